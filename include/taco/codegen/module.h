@@ -1,7 +1,10 @@
 #ifndef TACO_MODULE_H
 #define TACO_MODULE_H
 
+#include <atomic>
+#include <future>
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <utility>
@@ -11,17 +14,37 @@
 #include "taco/ir/ir.h"
 
 namespace taco {
+
+enum class ParallelSchedule;
+
 namespace ir {
 
+/// Instruction set variants that the kernels of a module can be compiled for.
+/// Variants are ordered from least to most capable.
+enum class KernelISA {
+  Generic, AVX2, AVX512
+};
+extern const char *KernelISA_NAMES[];
+
+/// True iff the host CPU can execute kernels compiled for the given
+/// instruction set variant.
+bool isKernelISASupported(KernelISA isa);
+
 class Module {
 public:
   /// Create a module for some target
   Module(Target target=getTargetFromEnvironment())
-    : lib_handle(nullptr), moduleFromUserSource(false), target(target) {
+    : lib_handle(nullptr), moduleFromUserSource(false),
+      multiVersioned(false), isa(KernelISA::Generic),
+      hasParallelCode(false), pgoTrainingCalls(0), pgoCallsRemaining(0), target(target) {
     setJITLibname();
     setJITTmpdir();
+    setMultiVersionedFromEnv();
+    setProfileGuidedFromEnv();
   }
 
+  ~Module();
+
   /// Compile the source into a library, returning its full path
   std::string compile();
   
@@ -45,8 +68,18 @@ public:
   /// returned.
   void* getFuncPtr(std::string name);
 
+  /// Get the slot holding the function pointer of a compiled function, or a
+  /// nullptr if there's no function of this name. Unlike the pointer returned
+  /// by getFuncPtr, the slot remains valid when the module swaps in a
+  /// recompiled library, and always holds the currently loaded function. The
+  /// slot is updated atomically, so callers may load it while another thread
+  /// swaps the library.
+  const std::atomic<void*>* getFuncPtrSlot(std::string name);
+
   /// Call a raw function in this module and return the result
-  int callFuncPackedRaw(std::string name, void** args);
+  int callFuncPackedRaw(std::string name, void** args) {
+    return callFuncPtr(getFuncPtr(name), args);
+  }
   
   /// Call a raw function in this module and return the result
   int callFuncPackedRaw(std::string name, std::vector<void*> args) {
@@ -63,8 +96,59 @@ public:
     return callFuncPacked(name, args.data());
   }
   
+  /// Call a function pointer obtained from getFuncPtr with an array of
+  /// arguments and return the result. This skips the name lookup of
+  /// callFuncPackedRaw and is meant for callers that invoke the same function
+  /// repeatedly.
+  int callFuncPtr(void* funcPtr, void** args);
+
+  /// Call a function pointer like callFuncPtr, but run the parallel loops of
+  /// the function with the given OpenMP schedule and chunk size instead of the
+  /// one set by taco_set_parallel_schedule.
+  int callFuncPtr(void* funcPtr, void** args, ParallelSchedule schedule,
+                  int chunkSize);
+
   /// Set the source of the module
   void setSource(std::string source);
+
+  /// Compile one library per supported instruction set variant (generic,
+  /// AVX2, AVX-512) and load the most capable variant that the host CPU
+  /// supports. Defaults to the value of the TACO_MULTIVERSION environment
+  /// variable. Has no effect while profile-guided optimization is enabled,
+  /// which always builds a single generic library.
+  void setMultiVersioned(bool multiVersioned);
+
+  /// Get the instruction set variant of the currently loaded library.
+  KernelISA getISA() const;
+
+  /// Load the library of the given instruction set variant of a module that
+  /// is multiversioned, instead of the most capable one that compile()
+  /// loads. This lets callers benchmark the variants against each other, or
+  /// check that they compute the same results. Returns false, and keeps the
+  /// loaded library, if the variant was not built or the host CPU does not
+  /// support it.
+  bool loadISA(KernelISA isa);
+
+  /// Enable profile-guided optimization of the module's kernels by passing a
+  /// positive number of training calls, or disable it by passing 0. When
+  /// enabled, compile() loads an instrumented library. Once it has served
+  /// trainingCalls calls, the kernels are recompiled with the collected
+  /// profile in the background, and the optimized library is swapped in when
+  /// it is built. The call that follows a failed build reports the failure.
+  /// Calling optimizeWithProfile instead recompiles the kernels right away.
+  /// Optimized libraries are kept in the directory given by the TACO_PGO_DIR
+  /// environment variable, if set, and reused by modules with the same
+  /// source. Defaults to the value of the TACO_PGO environment variable.
+  void setProfileGuided(int trainingCalls);
+
+  /// True iff the loaded library is instrumented and collecting a profile.
+  bool isCollectingProfile() const;
+
+  /// Recompile the module with the profile collected so far and load the
+  /// optimized library, or wait for the optimized library that is being built
+  /// once the training calls were served. Reports an error if the library
+  /// cannot be built.
+  void optimizeWithProfile();
   
 private:
   std::stringstream source;
@@ -77,10 +161,49 @@ private:
   // true iff the module was created from user-provided source
   bool moduleFromUserSource;
 
+  // true iff a library is built for every instruction set variant
+  bool multiVersioned;
+  KernelISA isa;
+
+  // Function pointers of the loaded library, resolved once when it is loaded.
+  // The mutex guards the map and the swap of the loaded library, and the
+  // pointers are atomic because callers read them through their slots
+  // without taking it.
+  std::map<std::string, std::atomic<void*>> funcPtrs;
+  mutable std::mutex funcPtrsMutex;
+
+  // true iff the loaded library contains OpenMP parallel regions, in which
+  // case calls have to apply taco's parallel schedule and thread count
+  bool hasParallelCode;
+
+  // Profile-guided optimization state: the number of calls used to train the
+  // instrumented library (0 if disabled) and the number of calls left before
+  // the optimized library is swapped in (0 if not training)
+  int pgoTrainingCalls;
+  int pgoCallsRemaining;
+  mutable std::mutex pgoMutex;
+  std::string compilerCommand;
+
+  // The build of the profile-optimized library that was started once the
+  // training calls were served, if it has not been waited for
+  std::future<void> pgoBuild;
+
+  // Libraries that were swapped out while other threads may still be running
+  // their functions. They stay loaded for the lifetime of the module.
+  std::vector<void*> retiredHandles;
+
   Target target;
   
   void setJITLibname();
   void setJITTmpdir();
+  void setMultiVersionedFromEnv();
+  void setProfileGuidedFromEnv();
+  std::string getProfileGuidedLibraryPath();
+  void loadLibrary(std::string path);
+  void resolveFuncPtrs();
+  void loadProfileOptimizedLibrary();
+  int callFuncPtrWithSchedule(void* funcPtr, void** args,
+                              const ParallelSchedule* schedule, int chunkSize);
 
   static std::string chars;
   static std::default_random_engine gen;
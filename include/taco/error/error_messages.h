@@ -25,6 +25,7 @@ extern const std::string assemble_without_compile;
 
 // compute error messages
 extern const std::string compute_without_compile;
+extern const std::string compute_aliased_operand;
 
 // factory function error messages
 extern const std::string requires_matrix;
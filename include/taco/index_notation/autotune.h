@@ -0,0 +1,90 @@
+#ifndef TACO_AUTOTUNE_H
+#define TACO_AUTOTUNE_H
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "taco/index_notation/index_notation.h"
+#include "taco/index_notation/transformations.h"
+
+namespace taco {
+
+enum class ParallelSchedule;
+
+/// A schedule found by the empirical autotuner. Tuned schedules are stored in
+/// the tuning database by the names of their index variables, so that they can
+/// be applied to any concrete index statement of the same expression.
+struct TunedSchedule {
+  TunedSchedule();
+
+  /// The order of the outermost foralls.
+  std::vector<std::string> loopOrder;
+
+  /// Whether the outermost forall is parallelized, and the OpenMP schedule and
+  /// chunk size (0 for the OpenMP default) that it is run with.
+  bool parallelize;
+  ParallelSchedule parallelSchedule;
+  int chunkSize;
+
+  /// The factor that the innermost forall is split by to vectorize it, or 0 if
+  /// it is not vectorized.
+  int vectorWidth;
+
+  /// Apply the schedule to a concrete index statement. Returns an undefined
+  /// statement if the schedule cannot be applied to the statement.
+  IndexStmt apply(IndexStmt stmt) const;
+
+  /// Parse a schedule printed by operator<<. Returns false if the string is
+  /// not a schedule.
+  static bool parse(const std::string& str, TunedSchedule* schedule);
+};
+
+bool operator==(const TunedSchedule&, const TunedSchedule&);
+
+/// Print a tuned schedule in the format of the tuning database, for example
+/// `order=i,j;parallel=dynamic,16;vector=8`.
+std::ostream& operator<<(std::ostream&, const TunedSchedule&);
+
+/**
+ * Returns the key that tuned schedules of an assignment are stored under in
+ * the tuning database. The key consists of the assignment with its tensors
+ * renamed in order of appearance, the formats of its tensors and, for every
+ * tensor with statistics, the dimensions rounded to a power of two and the
+ * density rounded to a power of ten.
+ */
+std::string getTuningKey(Assignment assignment,
+                         const std::map<TensorVar,TensorStatistics>& statistics={});
+
+/**
+ * Returns the candidate schedules that the autotuner times for a concrete
+ * index statement. Candidates vary the loop order (the loop orders with the
+ * lowest estimated cost first), the parallel schedule and chunk size of the
+ * outermost loop, and the vectorization of the innermost loop. Workspaces are
+ * placed by insertTemporaries for each loop order.
+ */
+std::vector<TunedSchedule>
+getScheduleCandidates(IndexStmt stmt,
+                      const std::map<TensorVar,TensorStatistics>& statistics={},
+                      size_t maxCandidates=32);
+
+/// Set the file of the tuning database. Tuned schedules are kept in memory if
+/// the path is empty. Defaults to the value of the TACO_TUNING_DB environment
+/// variable.
+void setTuningDatabase(const std::string& path);
+
+/// Get the file of the tuning database, or an empty string if tuned schedules
+/// are only kept in memory.
+std::string getTuningDatabase();
+
+/// Look up the tuned schedule stored under a key in the tuning database.
+/// Returns false if there is none.
+bool findTunedSchedule(const std::string& key, TunedSchedule* schedule);
+
+/// Store a tuned schedule under a key in the tuning database, replacing any
+/// schedule that is already stored under the key.
+void recordTunedSchedule(const std::string& key, const TunedSchedule& schedule);
+
+}
+#endif
@@ -63,6 +63,7 @@ struct IndexVarNode;
 struct AssignmentNode;
 struct YieldNode;
 struct ForallNode;
+struct ForallAnnotations;
 struct WhereNode;
 struct SequenceNode;
 struct AssembleNode;
@@ -599,10 +600,18 @@ public:
   /// variables sizes therefore equals the size of the original index
   /// variable.  Note that in the generated code, when the size of the
   /// inner index variable does not perfectly divide the original index
-  /// variable, a \textit{tail strategy} is employed such as emitting a variable
-  /// sized loop that handles remaining iterations.
+  /// variable, a \textit{tail strategy} handles the remaining iterations:
+  /// TailStrategy::Guard checks the bounds of every iteration of the inner
+  /// loop, TailStrategy::Peel iterates over the strips that are fully in bounds
+  /// without checks and over the last strip in a separate epilogue loop, and
+  /// TailStrategy::RoundUp omits the checks, which requires the size of the
+  /// original index variable to be a multiple of the split factor or the
+  /// tensors to be padded to one. Peeling applies to index variables that are
+  /// not derived from other index variables and whose outer loop encloses the
+  /// inner loop, and other splits are guarded instead.
   /// Preconditions: splitFactor is a positive nonzero integer
-  IndexStmt split(IndexVar i, IndexVar i1, IndexVar i2, size_t splitFactor) const; // TODO: TailStrategy
+  IndexStmt split(IndexVar i, IndexVar i1, IndexVar i2, size_t splitFactor,
+                  TailStrategy tailStrategy=TailStrategy::Guard) const;
 
   /// The divide transformation splits one index variable into
   /// two nested index variables, where the size of the outer
@@ -613,10 +622,34 @@ public:
   /// starting point of a tile can require an $O(n)$ or $O(\log (n))$
   /// search.  Therefore, if we want to parallelize a blocked
   /// loop, then we want a fixed number of blocks and not a number
-  /// proportional to the tensor size.
-  /// Preconditions: divideFactor is a positive nonzero integer
-  IndexStmt divide(IndexVar i, IndexVar i1, IndexVar i2, size_t divideFactor) const; // TODO: TailStrategy
-
+  /// proportional to the tensor size. The last block is guarded, unless the
+  /// tail strategy is TailStrategy::RoundUp (see split).
+  /// Preconditions: divideFactor is a positive nonzero integer and the tail
+  /// strategy is not TailStrategy::Peel
+  IndexStmt divide(IndexVar i, IndexVar i1, IndexVar i2, size_t divideFactor,
+                   TailStrategy tailStrategy=TailStrategy::Guard) const;
+
+
+  /// The tile transformation tiles directly nested index variables for a
+  /// memory hierarchy with several levels of caches. Every index variable
+  /// vars[k] is strip-mined into the index variables tiledVars[k], where
+  /// tiledVars[k][l] iterates over the tiles of level l and the last index
+  /// variable iterates over the points of the tiles of the innermost level.
+  /// The loops are reordered so that the loops over the tiles of every level
+  /// enclose the loops over the tiles of the next level. sizes[l] is the size
+  /// of the tiles of level l along every index variable. If no sizes are
+  /// given, the tiles of the innermost level are sized to fit in the L1 data
+  /// cache, the tiles of the level before it in the L2 data cache, and so on,
+  /// where the sizes of the caches are read from sysfs. The loops can then be
+  /// parallelized and vectorized like the loops of splits.
+  ///
+  /// Preconditions:
+  /// The index variables must be directly nested, every index variable must
+  /// be given the same number of levels, and the size of the tiles of a level
+  /// must be a multiple of the size of the tiles of the next level.
+  IndexStmt tile(std::vector<IndexVar> vars,
+                 std::vector<std::vector<IndexVar>> tiledVars,
+                 std::vector<size_t> sizes={}) const;
 
   /// The reorder transformation swaps two directly nested index
   /// variables in an iteration graph.  This changes the order of
@@ -640,7 +673,11 @@ public:
   /// transformation takes as an argument the type of parallel hardware
   /// to execute on.  The set of parallel hardware is extensible and our
   /// current code generation algorithm supports SIMD vector units, CPU
-  /// threads, GPU thread blocks, GPU warps, and individual GPU threads.
+  /// threads, CPU tasks, GPU thread blocks, GPU warps, and individual GPU
+  /// threads. Unlike loops over CPU threads, loops over CPU tasks can be
+  /// nested: the iterations of every such loop are split into tasks of about
+  /// the chunk size of the parallel schedule (see taco_set_parallel_schedule)
+  /// if the loop has at least that many iterations, and run inline otherwise.
   /// Parallelizing the iteration over an index variable changes the iteration
   /// order of the loop, and therefore requires reductions inside the
   /// iteration space described by the index variable's sub-tree in the
@@ -678,6 +715,15 @@ public:
   /// assume that no data races will occur. For all other strategies other than Atomics,
   /// there is the precondition
   /// that the racing reduction must be over the index variable being parallelized.
+  /// The MergePath strategy balances the loop over the rows of a compressed
+  /// matrix, such as the row loop of a CSR matrix-vector multiply, by the
+  /// number of nonzeros: every CPU thread gets an equal share of the rows plus
+  /// nonzeros, whose bounds are found by binary searches of the positions of
+  /// the compressed level, and the rows that are split between threads are
+  /// summed in a serial pass after the loop. It has the precondition that the
+  /// loop computes one component of a dense result per row by summing over
+  /// the nonzeros of a compressed level under a dense level that the
+  /// parallelized index variable indexes.
   IndexStmt parallelize(IndexVar i, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy) const;
 
   /// pos and coord create
@@ -744,6 +790,53 @@ public:
   /// Preconditions: unrollFactor is a positive nonzero integer
   IndexStmt unroll(IndexVar i, size_t unrollFactor) const;
 
+  /// The unrollReduction primitive unrolls the loop over an index variable by
+  /// a factor of accumulators, and splits the scalar reductions of the loop
+  /// into that many independent partial accumulators, which are combined once
+  /// the loop ends. This breaks the chain of dependent additions of reductions
+  /// such as the row sums of SpMV, so their throughput is no longer bound by
+  /// the latency of an addition. The remaining iterations are computed by a
+  /// loop that is not unrolled. Reductions are reassociated, so floating-point
+  /// results may differ in rounding. Loops that are not lowered to for loops
+  /// and loops without scalar reductions are not affected.
+  ///
+  /// Preconditions: accumulators is greater than one and the statement has a
+  /// loop over i.
+  IndexStmt unrollReduction(IndexVar i, size_t accumulators) const;
+
+  /// The prefetch primitive prefetches the values of the tensor of an access
+  /// that the loop over an index variable reads, distance iterations ahead of
+  /// the iteration that reads them. This hides the latency of indirect loads
+  /// such as x[crd[p]] in the loops over sparse operands, which hardware
+  /// prefetchers cannot predict. Like unroll, it is best applied after the
+  /// transformations that restructure the loop.
+  ///
+  /// Preconditions: distance is a positive nonzero integer and the loop over
+  /// i reads the values of the tensor of the access.
+  IndexStmt prefetch(IndexVar i, Access access, size_t distance) const;
+
+  /// The mergeby primitive sets the strategy that the loop over an index
+  /// variable merges the iterators of its operands with. With
+  /// MergeStrategy::Gallop, loops over intersections of compressed operands
+  /// advance every iterator to the largest of their coordinates by searching
+  /// exponentially and then binary searching its coordinates, so the cost of
+  /// an intersection grows with the length of its shortest operand rather
+  /// than with the sum of their lengths. Searches for nearby coordinates
+  /// compare blocks of coordinates without branches instead, so the strategy
+  /// adapts at runtime to the relative lengths of the operands. Merges of
+  /// unions and of dense operands are not affected.
+  ///
+  /// With MergeStrategy::Branchless, loops over unions of compressed operands
+  /// compute the statement once per coordinate from the values of the
+  /// operands that are present at the coordinate, which are selected without
+  /// branches, rather than branching to a case for each combination of
+  /// operands. This avoids mispredicted branches when the operands are
+  /// irregularly interleaved. Only unions whose statements add and subtract
+  /// their compressed operands are affected.
+  ///
+  /// Preconditions: the statement has a loop over i.
+  IndexStmt mergeby(IndexVar i, MergeStrategy strategy) const;
+
   /// The assemble primitive specifies whether a result tensor should be 
   /// assembled by appending or inserting nonzeros into the result tensor.
   /// In the latter case, the transformation inserts additional loops to 
@@ -835,6 +928,9 @@ public:
   Forall(const ForallNode*);
   Forall(IndexVar indexVar, IndexStmt stmt);
   Forall(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor = 0);
+  Forall(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit,
+         OutputRaceStrategy output_race_strategy,
+         const ForallAnnotations& annotations);
 
   IndexVar getIndexVar() const;
   IndexStmt getStmt() const;
@@ -842,14 +938,31 @@ public:
   ParallelUnit getParallelUnit() const;
   OutputRaceStrategy getOutputRaceStrategy() const;
 
+  /// Get the annotations that choose how the loop is emitted.
+  const ForallAnnotations& getAnnotations() const;
+
   size_t getUnrollFactor() const;
 
+  /// Get the tensors whose values are prefetched by the loop, mapped to how
+  /// many iterations ahead they are prefetched.
+  const std::map<TensorVar,size_t>& getPrefetches() const;
+
+  /// Get the strategy that the loop advances the iterators of merges with.
+  MergeStrategy getMergeStrategy() const;
+
+  /// Get the number of partial accumulators that the scalar reductions of the
+  /// loop are split into, or 0 if they are not split.
+  size_t getAccumulators() const;
+
   typedef ForallNode Node;
 };
 
 /// Create a forall index statement.
 Forall forall(IndexVar i, IndexStmt stmt);
 Forall forall(IndexVar i, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy output_race_strategy, size_t unrollFactor = 0);
+Forall forall(IndexVar i, IndexStmt stmt, ParallelUnit parallel_unit,
+              OutputRaceStrategy output_race_strategy,
+              const ForallAnnotations& annotations);
 
 
 /// A where statment has a producer statement that binds a tensor variable in
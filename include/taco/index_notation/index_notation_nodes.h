@@ -2,6 +2,7 @@
 #define TACO_INDEX_NOTATION_NODES_H
 
 #include <vector>
+#include <map>
 #include <memory>
 #include <functional>
 #include <numeric>
@@ -408,9 +409,39 @@ struct YieldNode : public IndexStmtNode {
   IndexExpr expr;
 };
 
+/// Annotations of a forall that choose how its loop is emitted without
+/// changing what it computes. Transformations that rebuild a forall copy its
+/// annotations as a unit.
+struct ForallAnnotations {
+  /// The number of times the loop is unrolled, or 0 if it is not unrolled.
+  size_t unrollFactor = 0;
+
+  /// The tensors whose values are prefetched by the loop, mapped to how many
+  /// iterations ahead they are prefetched.
+  std::map<TensorVar,size_t> prefetches;
+
+  /// The strategy that the loop advances the iterators of merges with.
+  MergeStrategy mergeStrategy = MergeStrategy::TwoFinger;
+
+  /// The number of partial accumulators that the scalar reductions of the
+  /// loop are split into, or 0 if they are not split.
+  size_t accumulators = 0;
+};
+
+bool operator==(const ForallAnnotations&, const ForallAnnotations&);
+bool operator!=(const ForallAnnotations&, const ForallAnnotations&);
+
 struct ForallNode : public IndexStmtNode {
   ForallNode(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit, OutputRaceStrategy  output_race_strategy, size_t unrollFactor = 0)
-      : indexVar(indexVar), stmt(stmt), parallel_unit(parallel_unit), output_race_strategy(output_race_strategy), unrollFactor(unrollFactor) {}
+      : indexVar(indexVar), stmt(stmt), parallel_unit(parallel_unit), output_race_strategy(output_race_strategy) {
+    annotations.unrollFactor = unrollFactor;
+  }
+
+  ForallNode(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit,
+             OutputRaceStrategy output_race_strategy,
+             const ForallAnnotations& annotations)
+      : indexVar(indexVar), stmt(stmt), parallel_unit(parallel_unit),
+        output_race_strategy(output_race_strategy), annotations(annotations) {}
 
   void accept(IndexStmtVisitorStrict* v) const {
     v->visit(this);
@@ -420,7 +451,7 @@ struct ForallNode : public IndexStmtNode {
   IndexStmt stmt;
   ParallelUnit parallel_unit;
   OutputRaceStrategy  output_race_strategy;
-  size_t unrollFactor = 0;
+  ForallAnnotations annotations;
 };
 
 struct WhereNode : public IndexStmtNode {
@@ -76,14 +76,17 @@ struct IndexVarRelNode : public util::Manageable<IndexVarRelNode>,
 };
 
 /// The split relation takes a parentVar's iteration space and stripmines into an outervar that iterates over splitFactor-sized
-/// iterations over innerVar
+/// iterations over innerVar. The tail strategy determines how the strip that
+/// extends past the end of the parentVar's iteration space is handled.
 struct SplitRelNode : public IndexVarRelNode {
-  SplitRelNode(IndexVar parentVar, IndexVar outerVar, IndexVar innerVar, size_t splitFactor);
+  SplitRelNode(IndexVar parentVar, IndexVar outerVar, IndexVar innerVar, size_t splitFactor,
+               TailStrategy tailStrategy=TailStrategy::Guard);
 
   const IndexVar& getParentVar() const;
   const IndexVar& getOuterVar() const;
   const IndexVar& getInnerVar() const;
   const size_t& getSplitFactor() const;
+  TailStrategy getTailStrategy() const;
 
   void print(std::ostream& stream) const;
   bool equals(const SplitRelNode &rel) const;
@@ -115,9 +118,10 @@ bool operator==(const SplitRelNode&, const SplitRelNode&);
 
 // DivideRelNode takes a parentVar's iteration space and divides it into divFactor
 // equal pieces. outerVar iterates over the number of pieces, and innerVar iterates
-// over each piece.
+// over each piece. The guard and round up tail strategies are supported.
   struct DivideRelNode : public IndexVarRelNode {
-    DivideRelNode(IndexVar parentVar, IndexVar outerVar, IndexVar innerVar, size_t divFactor);
+    DivideRelNode(IndexVar parentVar, IndexVar outerVar, IndexVar innerVar, size_t divFactor,
+                  TailStrategy tailStrategy=TailStrategy::Guard);
 
     const IndexVar &getParentVar() const;
 
@@ -127,6 +131,8 @@ bool operator==(const SplitRelNode&, const SplitRelNode&);
 
     const size_t &getDivFactor() const;
 
+    TailStrategy getTailStrategy() const;
+
     void print(std::ostream &stream) const;
 
     bool equals(const DivideRelNode &rel) const;
@@ -411,6 +417,10 @@ public:
   /// a `.divide` scheduling operation.
   bool isDivided(IndexVar indexVar) const;
 
+  /// Get the tail strategy of the split or divide that derives an index
+  /// variable, or TailStrategy::Guard if it is not derived by one.
+  TailStrategy getTailStrategy(IndexVar indexVar) const;
+
 private:
   std::map<IndexVar, IndexVarRel> childRelMap;
   std::map<IndexVar, IndexVarRel> parentRelMap;
@@ -1,6 +1,7 @@
 #ifndef TACO_TRANSFORMATIONS_H
 #define TACO_TRANSFORMATIONS_H
 
+#include <map>
 #include <memory>
 #include <string>
 #include <ostream>
@@ -160,7 +161,16 @@ std::ostream& operator<<(std::ostream&, const AddSuchThatPredicates&);
 
 
 /// The parallelize optimization tags a Forall as parallelized
-/// after checking for preconditions
+/// after checking for preconditions. On CPUs, the temporary output race
+/// strategy gives every thread its own copy of the dense results that the loop
+/// reduces into, which are summed into the results after the loop. If the
+/// copies would use more bytes than the TACO_PRIVATIZATION_BUDGET environment
+/// variable allows (64 MiB by default), or if the results are not dense, the
+/// loop reduces into the results with atomics instead. The parallel reduction
+/// output race strategy parallelizes loops on CPUs that reduce into scalars,
+/// whose partial results are combined by the reduction clauses of the loop.
+/// The scalars must be reduced by addition or by operators that lower to the
+/// min, max, logical or bitwise operators that OpenMP can reduce with.
 class Parallelize : public TransformationInterface {
 public:
   Parallelize();
@@ -214,9 +224,31 @@ std::ostream &operator<<(std::ostream &, const SetAssembleStrategy&);
  * 1. The loop iterates over only one data structure,
  * 2. Every result iterator has the insert capability, and
  * 3. No cross-thread reductions.
+ * When more than one thread is used, outer loops with cross-thread reductions
+ * into dense results are parallelized by privatizing the results (see the
+ * temporary output race strategy of Parallelize), as long as the private
+ * copies fit in the privatization budget, outer loops that reduce into
+ * scalars are parallelized with the parallel reduction output race strategy,
+ * and sparse results that do not support parallel inserts are assembled by
+ * parallelizeAssembly.
  */
 IndexStmt parallelizeOuterLoop(IndexStmt stmt);
 
+/**
+ * Assemble a sparse result that cannot be inserted into in parallel in two
+ * phases: a symbolic phase that counts the nonzeros of every result fiber,
+ * followed by a prefix sum of the counts into the positions of the fibers and
+ * a numeric phase in which every thread inserts into its own fibers. The outer
+ * loops of both phases are parallelized. Edges of the result are inserted in
+ * parallel because its attribute queries are computed in parallel, whereas
+ * Insert-based assembly with serial queries inserts them in order. Returns the
+ * statement unchanged if only one thread is used, if the result does not
+ * support ungrouped insertion, or if the numeric phase cannot be parallelized.
+ * parallelizeOuterLoop falls back on this when the outer loop writes to such a
+ * result.
+ */
+IndexStmt parallelizeAssembly(IndexStmt stmt);
+
 /**
  * Topologically reorder ForAlls so that all tensors are iterated in order.
  * Only reorders first contiguous section of ForAlls iterators form constraints
@@ -237,5 +269,101 @@ IndexStmt scalarPromote(IndexStmt stmt);
  */
 IndexStmt insertTemporaries(IndexStmt stmt);
 
+/**
+ * Fuse the computation of the results of producer assignments into the loop
+ * nest of a consumer assignment that reads them, and return the concrete index
+ * statement of the fused loop nest. A producer is fused into an assignment
+ * that reads it when the assignment only accesses dense tensors, when every
+ * access to the producer is the same and indexes every loop around the
+ * assignment, and when the producer's operands can be accessed at a point of
+ * its free variables. The value of a fused producer is then computed into a
+ * scalar temporary by a where statement right before it is read. Producers
+ * are fused recursively into the producers they are fused into. Returns an
+ * undefined statement if no producer can be fused.
+ */
+IndexStmt fuseAssignments(Assignment consumer,
+                          const std::map<TensorVar,Assignment>& producers);
+
+/**
+ * Rewrite the expressions of a statement in reduction notation to perform
+ * fewer operations, using the algebra of addition and multiplication and the
+ * properties of Func operators:
+ * 1. Operands that are added to a literal zero are simplified, and so are
+ *    products with a literal zero factor if their components are integers or
+ *    booleans, and calls to Funcs with an annihilator or identity argument.
+ *    Floating-point products with zero are kept, since NaN or infinite
+ *    operands make them NaN.
+ * 2. Factors that several products of a sum share are factored out of them,
+ *    for example `B*C + B*D` becomes `B*(C + D)`.
+ * 3. Factors of a sum reduction that do not depend on its variable are
+ *    hoisted out of it, so that nested reductions over sparse operands only
+ *    multiply the operands that they iterate over. For example
+ *    `sum(j, sum(k, A(i,j)*B(j,k)*c(k)))` becomes
+ *    `sum(j, A(i,j)*sum(k, B(j,k)*c(k)))`.
+ * Statements whose right-hand side simplifies to a literal are returned
+ * unchanged.
+ */
+IndexStmt simplifyAlgebraically(IndexStmt stmt);
+
+/// Statistics about the sparsity structure of a tensor, used by the cost model
+/// of the autoscheduler. Element l of levelSizes is the number of coordinates
+/// stored in level l of the tensor, so the average length of a fiber in level l
+/// is levelSizes[l] / levelSizes[l-1].
+struct TensorStatistics {
+  std::vector<size_t> levelSizes;
+};
+
+/**
+ * Estimate the cost of executing a concrete index statement, in units of
+ * innermost loop iterations. The estimate accounts for the iteration space of
+ * every loop (average fiber lengths for sparse levels and dimensions for dense
+ * levels), strided accesses of dense levels, workspaces that must be cleared,
+ * and outer loops that are parallelized. Tensors without statistics are
+ * assumed to be uniformly sparse.
+ */
+double estimateCost(IndexStmt stmt,
+                    const std::map<TensorVar,TensorStatistics>& statistics={});
+
+/**
+ * Returns the orders of the outermost foralls of a concrete index statement
+ * that iterate every sparse level after the levels above it. The first order
+ * is the one chosen by reorderLoopsTopologically. Loop nests that are too deep
+ * to enumerate only have that order.
+ */
+std::vector<std::vector<IndexVar>> getLegalLoopOrders(IndexStmt stmt);
+
+/**
+ * Reorder the outermost foralls of a concrete index statement to the given
+ * order and insert temporaries. Returns an undefined statement if the order is
+ * not a permutation of the outermost foralls or if the reordered statement
+ * scatters into a result that does not support inserts.
+ */
+IndexStmt applyLoopOrder(IndexStmt stmt, const std::vector<IndexVar>& order);
+
+/**
+ * Automatically schedule a concrete index statement. Every loop order of the
+ * outermost foralls that iterates all sparse levels in order is scheduled with
+ * insertTemporaries and parallelizeOuterLoop, and the schedule with the lowest
+ * estimated cost is returned. Loop nests that are too deep to enumerate are
+ * scheduled with reorderLoopsTopologically.
+ */
+IndexStmt autoschedule(IndexStmt stmt,
+                       const std::map<TensorVar,TensorStatistics>& statistics={});
+
+/**
+ * Compute an assignment of a product of three or more operands by contracting
+ * two operands at a time into dense temporaries, in the order with the lowest
+ * estimated cost. The cost of a contraction accounts for the dimensions of its
+ * loops and the densities of its sparse operands, like the cost model of
+ * autoschedule. The contractions are nested in where statements, so that each
+ * temporary is computed before the contractions that read it. Returns an
+ * undefined statement if the assignment is not such a product, if its result
+ * is not dense, or if computing the product in a single loop nest is
+ * estimated to be cheaper. TensorBase::compile only contracts products this
+ * way when the autoscheduler is enabled with TACO_AUTOSCHEDULE.
+ */
+IndexStmt optimizeContractionOrder(Assignment assignment,
+                 const std::map<TensorVar,TensorStatistics>& statistics={});
+
 }
 #endif
@@ -68,7 +68,8 @@ enum class IRNodeType {
   GetProperty,
   Continue,
   Sort,
-  Break
+  Break,
+  Prefetch
 };
 
 enum class TensorProperty {
@@ -615,7 +616,7 @@ struct Switch : public StmtNode<Switch> {
   static const IRNodeType _type_info = IRNodeType::Switch;
 };
 
-enum class LoopKind {Serial, Static, Dynamic, Runtime, Vectorized, Static_Chunked};
+enum class LoopKind {Serial, Static, Dynamic, Runtime, Vectorized, Static_Chunked, Task};
 
 /** A for loop from start to end by increment.
  * A vectorized loop will require the increment to be 1 and the
@@ -766,6 +767,16 @@ struct Sort : public StmtNode<Sort> {
   static const IRNodeType _type_info = IRNodeType::Sort;
 };
 
+/** A hint to prefetch an array location into the cache: &arr[loc] */
+struct Prefetch : public StmtNode<Prefetch> {
+  Expr arr;
+  Expr loc;
+
+  static Stmt make(Expr arr, Expr loc);
+
+  static const IRNodeType _type_info = IRNodeType::Prefetch;
+};
+
 /** A print statement.
  * Takes in a printf-style format string and Exprs to pass
  * for the values.
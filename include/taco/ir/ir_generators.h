@@ -1,6 +1,7 @@
 #ifndef TACO_IR_CODEGEN_H
 #define TACO_IR_CODEGEN_H
 
+#include <string>
 #include <vector>
 #include "taco/ir_tags.h"
 
@@ -16,6 +17,11 @@ Stmt compoundStore(Expr a, Expr i, Expr val, bool use_atomics=false, ParallelUni
 /// Generate `a += val;`
 Stmt compoundAssign(Expr a, Expr val, bool use_atomics=false, ParallelUnit atomic_parallel_unit=ParallelUnit::NotParallel);
 
+/// Get the OpenMP reduction identifier (`+`, `*`, `min`, `max`, `&&`, `||`,
+/// `&` or `|`) of an update `var = rhs` that combines `var` with another value,
+/// or the empty string if the update is not such a reduction.
+std::string getReductionOperator(Expr var, Expr rhs);
+
 /// Generate `exprs_0 && ... && exprs_n`
 Expr conjunction(std::vector<Expr> exprs);
 
@@ -8,8 +8,10 @@ namespace taco {
 /// ParallelUnit::GPUBlock must be used with GPUThread to create blocks of GPU threads
 /// ParallelUnit::GPUWarp can be optionally used to allow for GPU warp-level primitives
 /// ParallelUnit::GPUThread causes for every iteration to be executed on a separate GPU thread
+/// ParallelUnit::CPUTask splits loops into OpenMP tasks that idle CPU threads steal, and can
+///   be nested so that long fibers are split further while short ones run inline
 enum class ParallelUnit {
-  NotParallel, DefaultUnit, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector, CPUThreadGroupReduction, GPUBlockReduction, GPUWarpReduction
+  NotParallel, DefaultUnit, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector, CPUThreadGroupReduction, GPUBlockReduction, GPUWarpReduction, CPUTask
 };
 extern const char *ParallelUnit_NAMES[];
 
@@ -18,11 +20,26 @@ extern const char *ParallelUnit_NAMES[];
 /// OutputRaceStrategy::Temporary uses a temporary array for outputs that is serially reduced
 /// OutputRaceStrategy::ParallelReduction uses reduction operations across a warp/vector
 /// OutputRaceStrategy::IgnoreRaces allows the user to specify that races can be safely ignored
+/// OutputRaceStrategy::MergePath splits the rows and nonzeros of a loop over the rows of a
+///   compressed matrix evenly among CPU threads, and adds the partial rows at the boundaries
+///   of the partitions to the results in a serial carry-out pass
 enum class OutputRaceStrategy {
-  IgnoreRaces, NoRaces, Atomics, Temporary, ParallelReduction
+  IgnoreRaces, NoRaces, Atomics, Temporary, ParallelReduction, MergePath
 };
 extern const char *OutputRaceStrategy_NAMES[];
 
+/// MergeStrategy::TwoFinger advances the iterators of a merge loop past one coordinate at a time
+/// MergeStrategy::Gallop advances the iterators of a loop over an intersection to the largest of
+///   their coordinates with exponential searches, which skips over the coordinates of long operands
+///   that are missing from short ones
+/// MergeStrategy::Branchless computes the statement of a loop over a union once per coordinate,
+///   selecting the values of the operands that are present at the coordinate instead of branching
+///   to a case for each combination of operands
+enum class MergeStrategy {
+  TwoFinger, Gallop, Branchless
+};
+extern const char *MergeStrategy_NAMES[];
+
 enum class BoundType {
   MinExact, MinConstraint, MaxExact, MaxConstraint
 };
@@ -33,6 +50,16 @@ enum class AssembleStrategy {
 };
 extern const char *AssembleStrategy_NAMES[];
 
+/// TailStrategy::Guard checks that every iteration of a split loop is in bounds
+/// TailStrategy::Peel iterates over the strips that are fully in bounds without
+///   checks and over the last strip with checks in a separate epilogue loop
+/// TailStrategy::RoundUp omits the checks, which requires the split dimension
+///   to be a multiple of the split factor or the tensors to be padded to one
+enum class TailStrategy {
+  Guard, Peel, RoundUp
+};
+extern const char *TailStrategy_NAMES[];
+
 }
 
 #endif //TACO_IR_TAGS_H
@@ -2,12 +2,14 @@
 #define TACO_LOWER_H
 
 #include <string>
+#include <map>
 #include <set>
 #include <memory>
 
 namespace taco {
 
 class IndexStmt;
+class TensorVar;
 class LowererImpl;
 
 namespace ir {
@@ -48,6 +50,13 @@ ir::Stmt lower(IndexStmt stmt, std::string functionName,
                bool assemble=true, bool compute=true, bool pack=false, bool unpack=false,
                Lowerer lowerer=Lowerer());
 
+/// Specialize a lowered function to fixed dimensions of the modes of its
+/// tensors, which are then constants that loops can be unrolled and vectorized
+/// with. The specialized function checks the dimensions of the tensors that it
+/// is called with and runs the unspecialized function body if they differ.
+ir::Stmt specializeDimensions(ir::Stmt function,
+    const std::map<TensorVar,std::map<int,int>>& dimensions);
+
 /// Check whether the an index statement can be lowered to C code.  If the
 /// statement cannot be lowered and a `reason` string is provided then it is
 /// filled with the a reason.
@@ -146,13 +146,16 @@ protected:
      * \param statement
      *      A concrete index notation statement to compute at the points in the
      *      sparse iteration space described by the merge lattice.
+     * \param mergeStrategy
+     *      The strategy that the merge loops advance their iterators with.
      *
      * \return
      *       IR code to compute the forall loop.
      */
   virtual ir::Stmt lowerMergeLattice(MergeLattice lattice, IndexVar coordinateVar,
                                      IndexStmt statement, 
-                                     const std::set<Access>& reducedAccesses);
+                                     const std::set<Access>& reducedAccesses,
+                                     MergeStrategy mergeStrategy=MergeStrategy::TwoFinger);
 
   virtual ir::Stmt resolveCoordinate(std::vector<Iterator> mergers, ir::Expr coordinate, bool emitVarDecl);
 
@@ -169,10 +172,17 @@ protected:
      *      coordinate the merge point is at.
      *      A concrete index notation statement to compute at the points in the
      *      sparse iteration space region described by the merge point.
+     * \param mergeStrategy
+     *      The strategy that the merge loop advances its iterators with. Loops
+     *      over intersections of compressed levels gallop with
+     *      MergeStrategy::Gallop, and other loops advance one coordinate at a
+     *      time. Loops over unions compute the statement without branching
+     *      to cases with MergeStrategy::Branchless.
      */
   virtual ir::Stmt lowerMergePoint(MergeLattice pointLattice,
                                    ir::Expr coordinate, IndexVar coordinateVar, IndexStmt statement,
-                                   const std::set<Access>& reducedAccesses, bool resolvedCoordDeclared);
+                                   const std::set<Access>& reducedAccesses, bool resolvedCoordDeclared,
+                                   MergeStrategy mergeStrategy=MergeStrategy::TwoFinger);
 
   /// Lower a merge lattice to cases.
   virtual ir::Stmt lowerMergeCases(ir::Expr coordinate, IndexVar coordinateVar, IndexStmt stmt,
@@ -364,6 +374,37 @@ protected:
   std::vector<ir::Stmt> codeToInitializeTemporary(Where where);
   std::vector<ir::Stmt> codeToInitializeTemporaryParallel(Where where, ParallelUnit parallelUnit);
   std::vector<ir::Stmt> codeToInitializeLocalTemporaryParallel(Where where, ParallelUnit parallelUnit);
+
+  /// Privatizes the dense results that a loop parallelized over CPU threads
+  /// reduces into, so that every thread reduces into its own copy. Returns the
+  /// code that allocates the copies, the code that declares the copy of the
+  /// current thread in the loop body, and the code that sums the copies into
+  /// the results after the loop.
+  std::vector<ir::Stmt> codeToPrivatizeResults(
+      const std::set<Access>& reducedAccesses,
+      std::vector<TensorVar>* privatized);
+  /// Prefetches the values of the tensors that a forall prefetches in the
+  /// loops that it is lowered to. Every load of the values of a prefetched
+  /// tensor whose location can be computed at the start of an iteration is
+  /// prefetched for the iteration that is the prefetch distance ahead, where
+  /// loads in nested loops are prefetched for the first iteration of the
+  /// nested loops.
+  ir::Stmt codeToPrefetch(Forall forall, ir::Stmt loops);
+
+  /// Unrolls the loop that a forall with several accumulators is lowered to,
+  /// where every unrolled iteration adds to its own copy of the scalar
+  /// variables that the loop reduces into. The copies are added to the
+  /// variables after the loop, which is followed by a loop over the
+  /// iterations that remain.
+  ir::Stmt codeToSplitAccumulators(Forall forall, ir::Stmt loops);
+
+  /// Partitions the loop over the rows of a compressed level that a forall
+  /// with the merge-path strategy is lowered to. Every thread iterates over an
+  /// equal share of the rows plus nonzeros, which is bounded by binary searches
+  /// of the positions of the level, and carries out the sum of the row that
+  /// its share ends in, which is added to the result after the loop.
+  ir::Stmt codeToPartitionByMergePath(Forall forall, ir::Stmt loops);
+
   /// Gets the size of a temporary tensorVar in the where statement
   ir::Expr getTemporarySize(Where where);
 
@@ -565,6 +606,11 @@ private:
 
   bool emitUnderivedGuards = true;
 
+  /// Index variables whose bounds are not checked, because the splits that
+  /// derive loops from them use the round up tail strategy or because the
+  /// loops are the main loops of splits with the peel tail strategy.
+  std::set<IndexVar> unguardedVars;
+
   int inParallelLoopDepth = 0;
 
   std::map<ParallelUnit, ir::Expr> parallelUnitSizes;
@@ -212,6 +212,18 @@ public:
   getSeqInsertEdge(ir::Expr parentPos, std::vector<ir::Expr> coords,
                    std::vector<AttrQueryResult> queries, Mode mode) const;
 
+  /// Insert an edge independently of the edges of other parents, so that
+  /// edges can be inserted in parallel. The inserted edges are turned into
+  /// the edges that getSeqInsertEdge inserts by getParFinalizeEdges. Returns
+  /// an undefined statement if edges cannot be inserted in parallel.
+  virtual ir::Stmt
+  getParInsertEdge(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                   std::vector<AttrQueryResult> queries, Mode mode) const;
+
+  virtual ir::Stmt
+  getParFinalizeEdges(ir::Expr prevSize, std::vector<AttrQueryResult> queries,
+                      Mode mode) const;
+
   virtual ir::Stmt
   getInitCoords(ir::Expr prevSize, std::vector<AttrQueryResult> queries, 
                 Mode mode) const;
@@ -0,0 +1,71 @@
+#ifndef TACO_PROGRAM_H
+#define TACO_PROGRAM_H
+
+#include <vector>
+
+#include "taco/tensor.h"
+
+namespace taco {
+
+/// A tensor program evaluates the pending assignments that a set of result
+/// tensors depend on as a whole, rather than one tensor at a time as they are
+/// read. Before anything is compiled the program
+///
+/// 1. eliminates dead assignments: pending tensors that no result depends on
+///    are left pending,
+/// 2. shares common subexpressions: a tensor that is assigned the same
+///    expression of the same operands as another tensor of the same type and
+///    format is assigned a copy of that tensor instead,
+/// 3. fuses temporaries: a tensor that is not a result and is read by only one
+///    other tensor of the program is computed inside the kernel of that tensor
+///    where possible (see TensorBase::compile). Programs fuse temporaries
+///    whether or not TACO_FUSE is set, and
+/// 4. releases the storage of temporaries that are not fused once every tensor
+///    that reads them has been computed. Released temporaries are pending
+///    again and are recomputed if they are read later.
+///
+/// The kernels of tensors that do not depend on each other are then run
+/// concurrently.
+///
+/// Example:
+///   TensorProgram program;
+///   program.addResult(y);
+///   program.addResult(z);
+///   program.evaluate();
+class TensorProgram {
+public:
+  /// Create an empty tensor program.
+  TensorProgram();
+
+  /// Add a result to the program. The values of results are computed and kept
+  /// by evaluate.
+  void addResult(const TensorBase& result);
+
+  /// Get the results of the program.
+  const std::vector<TensorBase>& getResults() const;
+
+  /// Compute the results of the program and the pending assignments that they
+  /// depend on.
+  void evaluate();
+
+private:
+  std::vector<TensorBase> results;
+
+  /// Get the pending tensors that the results depend on, where every tensor
+  /// comes after the tensors that it reads.
+  std::vector<TensorBase> getPendingTensors() const;
+
+  /// Reassign a pending tensor to a copy of another tensor.
+  static void assignCopy(TensorBase tensor, TensorBase source);
+
+  /// Give a tensor that was reassigned a copy of another tensor its own
+  /// assignment back.
+  static void restoreAssignment(TensorBase tensor, TensorBase source,
+                                Assignment assignment);
+
+  /// Release the storage of a computed tensor and make it pending again.
+  static void release(TensorBase tensor);
+};
+
+}
+#endif
@@ -63,7 +63,12 @@ Array makeArray(T* data, size_t size, Array::Policy policy=Array::UserOwns) {
   return Array(type<T>(), data, size, policy);
 }
 
-/// Construct an array of elements of the given type.
+/// Alignment in bytes of the arrays allocated by makeArray and by generated
+/// kernels, which kernels may assume.
+static const size_t ARRAY_ALIGNMENT = 64;
+
+/// Construct an array of elements of the given type, aligned to
+/// ARRAY_ALIGNMENT bytes.
 Array makeArray(Datatype type, size_t size);
 
 /// Construct an Array from the values.
@@ -8,8 +8,8 @@ namespace taco {
 /// This struct represents the machine & OS to generate code for, both for
 /// JIT and AOT code generation.
 struct Target {
-  /// Architectures.  If C99, we generate C code, and if it is a specific
-  /// machine arch (e.g. x86 or arm) we use LLVM.
+  /// Architectures.  If C99, we generate portable C code, and if X86 we
+  /// generate C code that uses x86 vector intrinsics for vectorized loops.
   enum Arch {C99=0, X86} arch;
   
   /// Operating System.  Used when deciding which OS-specific calls to use.
@@ -28,7 +28,7 @@ struct Target {
   Target(const std::string &s);
 
   Target(Arch a, OS o) : arch(a), os(o) { 
-    taco_tassert(a == C99 && o != Windows && o != OSUnknown)
+    taco_tassert((a == C99 || a == X86) && o != Windows && o != OSUnknown)
         << "Unsupported target.";
   }
   
@@ -37,8 +37,9 @@ struct Target {
   
 };
 
-  /// Gets the target from the environment.  If this is not set in the
-  /// environment, it uses the default C99 backend with the current OS
+  /// Gets the target from the TACO_TARGET environment variable (e.g.
+  /// x86-linux).  If this is not set in the environment, it uses the default
+  /// C99 backend with the current OS
   Target getTargetFromEnvironment();
 
 } // namespace taco
@@ -1,13 +1,17 @@
 #ifndef TACO_TENSOR_H
 #define TACO_TENSOR_H
 
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 #include <cassert>
 #include <utility>
 #include <array>
 #include <mutex>
+#include <atomic>
+#include <cstdint>
 
 #include "taco/type.h"
 #include "taco/format.h"
@@ -15,6 +19,7 @@
 #include "taco/codegen/module.h"
 
 #include "taco/index_notation/index_notation.h"
+#include "taco/index_notation/autotune.h"
 
 #include "taco/storage/storage.h"
 #include "taco/storage/index.h"
@@ -30,10 +35,17 @@
 
 namespace taco {
 
+/// A prepared execution of a tensor's compute kernel. See TensorBase::prepare.
+class PreparedExecution;
+
 /// Inherits Access and adds a TensorBase object. Allows for tensor retreival
 /// for assignment setting and argument packing.
 struct AccessTensorNode;
 
+/// A program that evaluates the pending assignments that a set of result
+/// tensors depend on together. See program.h.
+class TensorProgram;
+
 /// ScalarAccess objects allow insertion and access of scalar values
 /// stored within tensors
 template <typename CType>
@@ -419,7 +431,12 @@ public:
   /// Pack tensor into the given format
   void pack();
 
-  /// Compile the tensor expression.
+  /// Compile the tensor expression. If the TACO_AUTOSCHEDULE environment
+  /// variable is set to a value other than 0, the expression is scheduled by
+  /// the cost-model driven autoscheduler rather than by the default schedule.
+  /// If the TACO_FUSE environment variable is set to a value other than 0,
+  /// the computations of operands that are yet to be computed are fused into
+  /// the kernel, and those operands are only computed if they are read later.
   void compile();
 
   void compile(IndexStmt stmt, bool assembleWhileCompute=false);
@@ -433,6 +450,22 @@ public:
   /// Compile, assemble and compute as needed.
   void evaluate();
 
+  /// Evaluate the tensor and return a handle that recomputes it. The kernel
+  /// function and its arguments are bound once, so invoking the handle costs
+  /// little more than a direct call to the compiled kernel. The handle may be
+  /// invoked after the values of the operands are modified in place, but not
+  /// after their index structures or value arrays are replaced.
+  PreparedExecution prepare();
+
+  /// Find the fastest schedule of the tensor's expression by compiling and
+  /// timing up to maxCandidates candidate schedules on the tensor's operands.
+  /// The fastest schedule is recorded in the tuning database, where compile
+  /// finds it for later computations of the same expression on tensors with
+  /// the same formats and similar shapes and densities, and the tensor is
+  /// recompiled with it. Returns a schedule with an empty loop order if the
+  /// expression has no candidate schedules.
+  TunedSchedule autotune(size_t maxCandidates=32);
+
   /// True if the Tensor needs to be packed.
   bool needsPack();
 
@@ -448,6 +481,14 @@ public:
   /// Set to true to perform the assemble and compute stages simultaneously.
   void setAssembleWhileCompute(bool assembleWhileCompute);
 
+  /// Specialize the kernels of the tensor to the dimensions of the modes that
+  /// are indexed by the given index variables, such as the rank of the factor
+  /// matrices of an MTTKRP. The dimensions are compiled into the kernels as
+  /// constants, so loops over them can be unrolled and vectorized. The kernels
+  /// check the dimensions of the tensors that they are called with and run
+  /// unspecialized code if they differ.
+  void specializeDimensions(const std::set<IndexVar>& indexVars);
+
   /// Get the source code of the kernel functions.
   std::string getSource() const;
 
@@ -498,15 +539,23 @@ public:
   friend std::ostream& operator<<(std::ostream&, TensorBase&);
 
   friend struct AccessTensorNode;
+  friend class TensorProgram;
   std::vector<TensorBase> getDependentTensors();
 private:
   static std::shared_ptr<ir::Module> getHelperFunctions(
       const Format& format, Datatype ctype, const std::vector<int>& dimensions);
-  static std::shared_ptr<ir::Module> getComputeKernel(const IndexStmt stmt);
-  static void cacheComputeKernel(const IndexStmt stmt, 
+  static std::shared_ptr<ir::Module> getComputeKernel(
+      const IndexStmt stmt, const std::vector<int>& specializedDimensions);
+  static void cacheComputeKernel(const IndexStmt stmt,
+                                 const std::vector<int>& specializedDimensions,
                                  const std::shared_ptr<ir::Module> kernel);
 
   /* --- Compiler Methods --- */
+  /// Compile the tensor expression, fusing the computations of operands that
+  /// are yet to be computed into the kernel if fuseOperands is true, except
+  /// for the given operands, which must be computed before the kernel is run.
+  void compile(const std::set<TensorVar>& unfusedOperands, bool fuseOperands);
+
   bool neverPacked();
 
   void unsetNeverPacked();
@@ -521,6 +570,22 @@ private:
 
   void syncValues();
 
+  /// Get the tensors that the tensor's assignment reads.
+  std::map<TensorVar,TensorBase> getOperands() const;
+
+  void buildArgumentPlan();
+  std::vector<void*> packArguments();
+
+  /// Assemble or compute the tensor with arguments returned by packArguments,
+  /// without syncing its operands. Packing writes to the storage of every
+  /// operand, so tensors that share operands are packed one at a time and can
+  /// then be assembled and computed concurrently.
+  void assemblePacked(void** arguments);
+  void computePacked(void** arguments);
+
+  /// Call a kernel of the tensor's module with the tensor's parallel schedule.
+  int callKernel(std::string name, void** arguments);
+
   template<typename CType>
   iterator_wrapper<int,CType> iteratorPacked();
   
@@ -547,12 +612,39 @@ private:
   static HelperFuncsCache helperFunctions;
   static std::mutex helperFunctionsMutex;
 
-  typedef std::vector<std::pair<IndexStmt, 
-                                std::shared_ptr<ir::Module>>> KernelsCache;
+  typedef std::vector<std::tuple<IndexStmt,
+                                 std::vector<int>,
+                                 std::shared_ptr<ir::Module>>> KernelsCache;
   static KernelsCache computeKernels;
   static std::mutex computeKernelsMutex;
 };
 
+/// A prepared execution of the compute kernel of a tensor's assignment,
+/// created by TensorBase::prepare.
+class PreparedExecution {
+public:
+  /// Construct an undefined prepared execution.
+  PreparedExecution();
+
+  /// Run the compute kernel on the bound arguments. Returns true iff the
+  /// kernel succeeded.
+  bool operator()();
+
+  /// Check whether the prepared execution is defined.
+  bool defined() const;
+
+private:
+  friend class TensorBase;
+
+  TensorBase result;
+  std::shared_ptr<ir::Module> module;
+  const std::atomic<void*>* computeFunc;
+  std::vector<void*> arguments;
+  bool hasParallelSchedule;
+  ParallelSchedule parallelSchedule;
+  int chunkSize;
+};
+
 /// A reference to a tensor. Tensor object copies copies the reference, and
 /// subsequent method calls affect both tensor references. To deeply copy a
 /// tensor (for instance to change the format) compute a copy index expression
@@ -917,6 +1009,41 @@ struct TensorBase::Content {
   std::vector<std::weak_ptr<TensorBase::Content>> dependentTensors;
   unsigned int       uniqueId;
 
+  // Argument-binding plan of the assignment: the operands to sync before a
+  // kernel call and the tensors whose storage is passed after the result, in
+  // kernel argument order. Built on first use and reset when the assignment
+  // changes.
+  bool                    hasArgumentPlan;
+  std::vector<TensorBase> planOperands;
+  std::vector<TensorBase> planArguments;
+
+  // Address ranges of the arrays of the result and of the argument tensors
+  // when they were last checked not to alias, so that they are only checked
+  // again once some of them are replaced.
+  std::vector<std::pair<uintptr_t,uintptr_t>> checkedArrays;
+
+  // Concrete statement that the kernel was compiled from. The order of its
+  // arguments is the order of the kernel's parameters.
+  IndexStmt                      compiledStmt;
+
+  // Concrete statement of the kernel when the computations of operands that
+  // are yet to be computed are fused into it, the assignments of those
+  // operands, and the tensors that the fused kernel reads. Undefined if the
+  // assignment is compiled on its own.
+  IndexStmt                      fusedStmt;
+  std::map<TensorVar,Assignment> fusedProducers;
+  std::map<TensorVar,TensorBase> fusedOperands;
+
+  // Index variables whose dimensions the kernels are specialized to.
+  std::set<IndexVar>             specializedIndexVars;
+
+  // OpenMP schedule of the parallel loops of the kernels found by the
+  // autotuner, if any. The module may be shared with other tensors through
+  // the kernel cache, so the schedule is passed to it on every call.
+  bool                           hasParallelSchedule;
+  ParallelSchedule               parallelSchedule;
+  int                            chunkSize;
+
   Content(std::string name, Datatype dataType, const std::vector<int>& dimensions,
           Format format, Literal fill)
       : dataType(dataType), dimensions(dimensions),
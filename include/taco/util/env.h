@@ -67,6 +67,11 @@ inline std::string getTmpdir() {
   return cachedtmpdir;
 }
 
+/// Get the size in bytes of the data cache of a level of the memory hierarchy
+/// (1 for L1, 2 for L2, ...) of the first CPU, as reported by sysfs, or 0 if
+/// the size is unknown.
+size_t getCacheSize(int level);
+
 }}
 
 #endif /* SRC_UTIL_ENV_H_ */
@@ -82,5 +82,10 @@ std::string repeat(std::string text, size_t n);
 /// is filled with `fill`.
 std::string fill(std::string text, char fill, size_t n);
 
+/// Returns the SHA-256 digest of `text` as a hexadecimal string. Unlike
+/// std::hash, the digest is the same across platforms and builds, so it can
+/// name files that outlive the process.
+std::string sha256(const std::string& text);
+
 }}
 #endif
@@ -2,6 +2,7 @@
 #include "taco/cuda.h"
 #include "codegen_cuda.h"
 #include "codegen_c.h"
+#include "codegen_c_x86.h"
 #include <algorithm>
 #include <unordered_set>
 
@@ -22,10 +23,14 @@ const std::string bufCapacityCopyName = "__bufcapcopy__";
 const std::string labelPrefix = "resume_";
 
 
-shared_ptr<CodeGen> CodeGen::init_default(std::ostream &dest, OutputKind outputKind) {
+shared_ptr<CodeGen> CodeGen::init_default(std::ostream &dest, OutputKind outputKind,
+                                          Target target) {
   if (should_use_CUDA_codegen()) {
     return make_shared<CodeGen_CUDA>(dest, outputKind);
   }
+  else if (target.arch == Target::X86) {
+    return make_shared<CodeGen_C_X86>(dest, outputKind);
+  }
   else {
     return make_shared<CodeGen_C>(dest, outputKind);
   }
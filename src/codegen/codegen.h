@@ -4,6 +4,7 @@
 #include <memory>
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_printer.h"
+#include "taco/target.h"
 
 namespace taco {
 namespace ir {
@@ -17,8 +18,9 @@ public:
 
   CodeGen(std::ostream& stream, CodeGenType type) : IRPrinter(stream), codeGenType(type) {};
   CodeGen(std::ostream& stream, bool color, bool simplify, CodeGenType type) : IRPrinter(stream, color, simplify), codeGenType(type) {};
-  /// Initialize the default code generator
-  static std::shared_ptr<CodeGen> init_default(std::ostream &dest, OutputKind outputKind);
+  /// Initialize the default code generator for a target
+  static std::shared_ptr<CodeGen> init_default(std::ostream &dest, OutputKind outputKind,
+                                               Target target=getTargetFromEnvironment());
 
   /// Compile a lowered function
   virtual void compile(Stmt stmt, bool isFirst=false) =0;
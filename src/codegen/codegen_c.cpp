@@ -6,6 +6,8 @@
 #include <taco.h>
 
 #include "taco/ir/ir_visitor.h"
+#include "taco/ir/ir_generators.h"
+#include "taco/ir/simplify.h"
 #include "codegen_c.h"
 #include "taco/error.h"
 #include "taco/util/strings.h"
@@ -20,13 +22,17 @@ namespace ir {
 namespace {
 
 // Include stdio.h for printf
-// stdlib.h for malloc/realloc
+// stdlib.h for malloc/realloc, and for posix_memalign, which -std=c99 hides
+// unless _POSIX_C_SOURCE is defined
 // math.h for sqrt
 // MIN preprocessor macro
 // This *must* be kept in sync with taco_tensor_t.h
 const string cHeaders =
   "#ifndef TACO_C_HEADERS\n"
   "#define TACO_C_HEADERS\n"
+  "#ifndef _POSIX_C_SOURCE\n"
+  "#define _POSIX_C_SOURCE 200112L\n"
+  "#endif\n"
   "#include <stdio.h>\n"
   "#include <stdlib.h>\n"
   "#include <stdint.h>\n"
@@ -39,6 +45,13 @@ const string cHeaders =
   "#endif\n"
   "#define TACO_MIN(_a,_b) ((_a) < (_b) ? (_a) : (_b))\n"
   "#define TACO_MAX(_a,_b) ((_a) > (_b) ? (_a) : (_b))\n"
+  "#define TACO_SELECT(_c,_a,_b) ((_c) ? (_a) : (_b))\n"
+  "#define TACO_ALIGNMENT " + std::to_string(ARRAY_ALIGNMENT) + "\n"
+  "#if defined(__GNUC__)\n"
+  "#define TACO_ASSUME_ALIGNED(_a) __builtin_assume_aligned((_a), TACO_ALIGNMENT)\n"
+  "#else\n"
+  "#define TACO_ASSUME_ALIGNED(_a) (_a)\n"
+  "#endif\n"
   "#define TACO_DEREF(_a) (((___context___*)(*__ctx__))->_a)\n"
   "#ifndef TACO_TENSOR_T_DEFINED\n"
   "#define TACO_TENSOR_T_DEFINED\n"
@@ -59,6 +72,24 @@ const string cHeaders =
   "int omp_get_thread_num() { return 0; }\n"
   "int omp_get_max_threads() { return 1; }\n"
   "#endif\n"
+  "void* taco_malloc_aligned(size_t size) {\n"
+  "  // Memory that is allocated aligned can still be reallocated and freed\n"
+  "  void* ptr = NULL;\n"
+  "  if (posix_memalign(&ptr, TACO_ALIGNMENT, size) != 0) {\n"
+  "    return NULL;\n"
+  "  }\n"
+  "  return ptr;\n"
+  "}\n"
+  "int taco_task_grainsize() {\n"
+  "#if _OPENMP\n"
+  "  omp_sched_t sched;\n"
+  "  int chunk;\n"
+  "  omp_get_schedule(&sched, &chunk);\n"
+  "  return (chunk > 1) ? chunk : 1024;\n"
+  "#else\n"
+  "  return 1024;\n"
+  "#endif\n"
+  "}\n"
   "int cmp(const void *a, const void *b) {\n"
   "  return *((const int*)a) - *((const int*)b);\n"
   "}\n"
@@ -104,6 +135,89 @@ const string cHeaders =
   "  }\n"
   "  return lowerBound;\n"
   "}\n"
+  "int taco_mergePathSearch(int *pos, int rows, int diagonal) {\n"
+  "  // Returns the number of row ends that precede the diagonal in the merge\n"
+  "  // of the row ends pos[1..rows] with the positions of the nonzeros\n"
+  "  int lowerBound = TACO_MAX(diagonal - pos[rows], 0);\n"
+  "  int upperBound = TACO_MIN(diagonal, rows);\n"
+  "  while (lowerBound < upperBound) {\n"
+  "    int mid = (upperBound + lowerBound) / 2;\n"
+  "    if (pos[mid + 1] <= diagonal - mid - 1) {\n"
+  "      lowerBound = mid + 1;\n"
+  "    }\n"
+  "    else {\n"
+  "      upperBound = mid;\n"
+  "    }\n"
+  "  }\n"
+  "  return lowerBound;\n"
+  "}\n"
+  "int taco_gallop(int *array, int arrayStart, int arrayEnd, int target) {\n"
+  "  // Returns the first position whose coordinate is not less than the\n"
+  "  // target. Targets within a block are found by counting the smaller\n"
+  "  // coordinates of the block without branches, and targets further away by\n"
+  "  // an exponential search followed by a branchless binary search.\n"
+  "  if (arrayStart >= arrayEnd || array[arrayStart] >= target) {\n"
+  "    return arrayStart;\n"
+  "  }\n"
+  "  int blockEnd = TACO_MIN(arrayStart + 16, arrayEnd);\n"
+  "  if (array[blockEnd - 1] >= target) {\n"
+  "    int count = 0;\n"
+  "    for (int i = arrayStart; i < blockEnd; i++) {\n"
+  "      count += (array[i] < target);\n"
+  "    }\n"
+  "    return arrayStart + count;\n"
+  "  }\n"
+  "  int lowerBound = blockEnd - 1; // always < target\n"
+  "  int step = 16;\n"
+  "  while (lowerBound + step < arrayEnd && array[lowerBound + step] < target) {\n"
+  "    lowerBound += step;\n"
+  "    step *= 2;\n"
+  "  }\n"
+  "  int base = lowerBound + 1;\n"
+  "  int size = TACO_MIN(lowerBound + step, arrayEnd) - base;\n"
+  "  if (size == 0) {\n"
+  "    return base;\n"
+  "  }\n"
+  "  while (size > 1) {\n"
+  "    int half = size / 2;\n"
+  "    base = (array[base + half] < target) ? base + half : base;\n"
+  "    size -= half;\n"
+  "  }\n"
+  "  return base + (array[base] < target);\n"
+  "}\n"
+  "int taco_prefixSum(int *array, int size) {\n"
+  "#if _OPENMP\n"
+  "  int numThreads = omp_get_max_threads();\n"
+  "  if (numThreads > 1 && size >= 4096) {\n"
+  "    int *sums = (int*)calloc(numThreads + 1, sizeof(int));\n"
+  "    #pragma omp parallel num_threads(numThreads)\n"
+  "    {\n"
+  "      int thread = omp_get_thread_num();\n"
+  "      int threads = omp_get_num_threads();\n"
+  "      int begin = (int)(((long long)size * thread) / threads);\n"
+  "      int end = (int)(((long long)size * (thread + 1)) / threads);\n"
+  "      for (int i = begin + 1; i < end; i++) {\n"
+  "        array[i] += array[i - 1];\n"
+  "      }\n"
+  "      sums[thread + 1] = (begin < end) ? array[end - 1] : 0;\n"
+  "      #pragma omp barrier\n"
+  "      #pragma omp single\n"
+  "      for (int t = 1; t <= threads; t++) {\n"
+  "        sums[t] += sums[t - 1];\n"
+  "      }\n"
+  "      for (int i = begin; i < end; i++) {\n"
+  "        array[i] += sums[thread];\n"
+  "      }\n"
+  "    }\n"
+  "    free(sums);\n"
+  "    return array[size - 1];\n"
+  "  }\n"
+  "#endif\n"
+  "  for (int i = 1; i < size; i++) {\n"
+  "    array[i] += array[i - 1];\n"
+  "  }\n"
+  "  return array[size - 1];\n"
+  "}\n"
   "taco_tensor_t* init_taco_tensor_t(int32_t order, int32_t csize,\n"
   "                                  int32_t* dimensions, int32_t* mode_ordering,\n"
   "                                  taco_mode_t* mode_types) {\n"
@@ -139,6 +253,15 @@ const string cHeaders =
   "  free(t->mode_types);\n"
   "  free(t);\n"
   "}\n"
+  "#if defined(TACO_PGO_INSTRUMENTED)\n"
+  "#if defined(__clang__)\n"
+  "int __llvm_profile_write_file(void);\n"
+  "void taco_write_profile() { __llvm_profile_write_file(); }\n"
+  "#else\n"
+  "void __gcov_dump(void);\n"
+  "void taco_write_profile() { __gcov_dump(); }\n"
+  "#endif\n"
+  "#endif\n"
   "#endif\n";
 } // anonymous namespace
 
@@ -241,7 +364,8 @@ protected:
 };
 
 CodeGen_C::CodeGen_C(std::ostream &dest, OutputKind outputKind, bool simplify)
-    : CodeGen(dest, false, simplify, C), out(dest), outputKind(outputKind) {}
+    : CodeGen(dest, false, simplify, C), out(dest), outputKind(outputKind),
+      parallelRegionDepth(0) {}
 
 CodeGen_C::~CodeGen_C() {}
 
@@ -251,13 +375,17 @@ void CodeGen_C::compile(Stmt stmt, bool isFirst) {
 
   if (isFirst) {
     // output the headers
-    out << cHeaders;
+    genHeaders();
   }
   out << endl;
   // generate code for the Stmt
   stmt.accept(this);
 }
 
+void CodeGen_C::genHeaders() {
+  out << cHeaders;
+}
+
 void CodeGen_C::visit(const Function* func) {
   // if generating a header, protect the function declaration with a guard
   if (outputKind == HeaderGen) {
@@ -357,16 +485,93 @@ void CodeGen_C::visit(const Var* op) {
   }
 }
 
-static string genVectorizePragma(int width) {
-  stringstream ret;
-  ret << "#pragma clang loop interleave(enable) ";
-  if (!width)
-    ret << "vectorize(enable)";
-  else
-    ret << "vectorize_width(" << width << ")";
+namespace {
 
-  return ret.str();
-}
+// Finds the scalar reductions of a loop body, i.e. variables declared outside
+// the loop that the body only updates as `x = x op e` for an operator that
+// OpenMP can reduce with, so that they can be listed in the reduction clause of
+// an `omp simd` or `omp parallel for` pragma. A body that updates outer scalars
+// in any other way, or that breaks out of the loop, cannot be annotated with
+// `omp simd`. Atomic updates are already safe to run concurrently and are
+// skipped when the reductions of parallel loops are found.
+struct FindScalarReductions : public IRVisitor {
+  using IRVisitor::visit;
+
+  vector<pair<string,Expr>> reductions;
+  bool simdLegal = true;
+  bool ignoreAtomics = false;
+
+  /// True iff every array that the body stores to is only loaded from and
+  /// stored to at the same location, so that no iteration reads or writes an
+  /// element that another iteration writes. Locations are compared by
+  /// identity, so equal locations that are built separately count as
+  /// different.
+  bool hasIndependentStores() const {
+    for (auto& store : stores) {
+      for (auto& access : accesses) {
+        if (access.first == store.first && access.second != store.second) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void visit(const VarDecl* op) {
+    declared.insert(op->var);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const For* op) {
+    declared.insert(op->var);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Break* op) {
+    simdLegal = false;
+  }
+
+  void visit(const Load* op) {
+    IRVisitor::visit(op);
+    accesses.push_back({util::toString(op->arr), op->loc});
+  }
+
+  void visit(const Store* op) {
+    IRVisitor::visit(op);
+    stores.push_back({util::toString(op->arr), op->loc});
+    accesses.push_back(stores.back());
+  }
+
+  void visit(const Assign* op) {
+    IRVisitor::visit(op);
+    if (!isa<Var>(op->lhs) || util::contains(declared, op->lhs) ||
+        (ignoreAtomics && op->use_atomics)) {
+      return;
+    }
+    string reductionOp = getReductionOperator(op->lhs, op->rhs);
+    if (reductionOp.empty() || to<Var>(op->lhs)->is_ptr ||
+        op->lhs.type().isComplex()) {
+      simdLegal = false;
+      return;
+    }
+    for (auto& reduction : reductions) {
+      if (reduction.second == op->lhs) {
+        simdLegal = simdLegal && (reduction.first == reductionOp);
+        return;
+      }
+    }
+    reductions.push_back({reductionOp, op->lhs});
+  }
+
+private:
+  set<Expr> declared;
+
+  // The arrays, by name, and locations of the loads and stores of the body
+  vector<pair<string,Expr>> accesses;
+  vector<pair<string,Expr>> stores;
+};
+
+} // anonymous namespace
 
 static string getParallelizePragma(LoopKind kind) {
   stringstream ret;
@@ -390,14 +595,70 @@ static string getParallelizePragma(LoopKind kind) {
   return ret.str();
 }
 
-static string getUnrollPragma(size_t unrollFactor) {
-  return "#pragma unroll " + std::to_string(unrollFactor);
-}
 
 static string getAtomicPragma() {
   return "#pragma omp atomic";
 }
 
+// GCC ignores the clang loop pragmas, so the vectorization and unroll hints are
+// emitted for both compilers and selected by the preprocessor. For GCC, `for`
+// loops are annotated with `omp simd`, which needs -fopenmp or -fopenmp-simd
+// and whose reduction clause preserves the semantics of scalar reductions in
+// the loop. Loops that cannot be annotated that way (`while` loops and loops
+// that update outer scalars other than by reduction) get `GCC ivdep`. Both
+// assert that iterations do not depend on each other through memory, unlike
+// the clang hint, so loops that may load or store an element that another
+// iteration stores get neither.
+void CodeGen_C::genVectorizePragma(int width, Stmt body, bool isFor) {
+  doIndent();
+  out << "#if defined(__clang__)\n";
+  doIndent();
+  out << "#pragma clang loop interleave(enable) ";
+  if (!width)
+    out << "vectorize(enable)";
+  else
+    out << "vectorize_width(" << width << ")";
+  out << "\n";
+  doIndent();
+  FindScalarReductions reductions;
+  body.accept(&reductions);
+  if (!reductions.hasIndependentStores()) {
+    out << "#endif\n";
+    return;
+  }
+  out << "#elif defined(__GNUC__)\n";
+  doIndent();
+  if (isFor && reductions.simdLegal) {
+    out << "#pragma omp simd";
+    if (width) {
+      out << " simdlen(" << width << ")";
+    }
+    for (auto& reduction : reductions.reductions) {
+      out << " reduction(" << reduction.first << ":"
+          << varMap[reduction.second] << ")";
+    }
+  }
+  else {
+    out << "#pragma GCC ivdep";
+  }
+  out << "\n";
+  doIndent();
+  out << "#endif\n";
+}
+
+void CodeGen_C::genUnrollPragma(size_t unrollFactor) {
+  doIndent();
+  out << "#if defined(__GNUC__) && !defined(__clang__)\n";
+  doIndent();
+  out << "#pragma GCC unroll " << unrollFactor << "\n";
+  doIndent();
+  out << "#else\n";
+  doIndent();
+  out << "#pragma unroll " << unrollFactor << "\n";
+  doIndent();
+  out << "#endif\n";
+}
+
 // The next two need to output the correct pragmas depending
 // on the loop kind (Serial, Static, Dynamic, Vectorized)
 //
@@ -406,22 +667,53 @@ static string getAtomicPragma() {
 void CodeGen_C::visit(const For* op) {
   switch (op->kind) {
     case LoopKind::Vectorized:
-      doIndent();
-      out << genVectorizePragma(op->vec_width);
-      out << "\n";
+      genVectorizePragma(op->vec_width, op->contents, true);
       break;
     case LoopKind::Static:
     case LoopKind::Dynamic:
     case LoopKind::Runtime:
     case LoopKind::Static_Chunked:
-      doIndent();
-      out << getParallelizePragma(op->kind);
+    case LoopKind::Task: {
+      if (op->kind != LoopKind::Task) {
+        doIndent();
+        out << getParallelizePragma(op->kind);
+      }
+      else {
+        // Loops over tasks outside of parallel regions start a region in
+        // which one thread creates the tasks, and loops that are too short to
+        // split run inline
+        if (parallelRegionDepth == 0) {
+          doIndent();
+          out << "#pragma omp parallel\n";
+          doIndent();
+          out << "#pragma omp single\n";
+        }
+        doIndent();
+        out << "#pragma omp taskloop default(shared) "
+            << "grainsize(taco_task_grainsize()) if(";
+        parentPrecedence = TOP;
+        Expr tripCount = ir::simplify(Sub::make(op->end, op->start));
+        Gte::make(tripCount, Call::make("taco_task_grainsize", {},
+                                        tripCount.type())).accept(this);
+        out << ")";
+      }
+      // Every thread reduces into its own copy of the outer scalars that the
+      // loop reduces into, which are combined when the loop ends
+      FindScalarReductions reductions;
+      reductions.ignoreAtomics = true;
+      op->contents.accept(&reductions);
+      if (reductions.simdLegal) {
+        for (auto& reduction : reductions.reductions) {
+          out << " reduction(" << reduction.first << ":"
+              << varMap[reduction.second] << ")";
+        }
+      }
       out << "\n";
       break;
+    }
     default:
       if (op->unrollFactor > 0) {
-        doIndent();
-        out << getUnrollPragma(op->unrollFactor) << endl;
+        genUnrollPragma(op->unrollFactor);
       }
       break;
   }
@@ -453,7 +745,18 @@ void CodeGen_C::visit(const For* op) {
   }
   stream << ") {\n";
 
+  const bool isParallel = (op->kind == LoopKind::Static ||
+                           op->kind == LoopKind::Dynamic ||
+                           op->kind == LoopKind::Runtime ||
+                           op->kind == LoopKind::Static_Chunked ||
+                           op->kind == LoopKind::Task);
+  if (isParallel) {
+    parallelRegionDepth++;
+  }
   op->contents.accept(this);
+  if (isParallel) {
+    parallelRegionDepth--;
+  }
   doIndent();
   stream << "}";
   stream << endl;
@@ -464,9 +767,7 @@ void CodeGen_C::visit(const While* op) {
   // while loops
   // however, we'll output the pragmas anyway
   if (op->kind == LoopKind::Vectorized) {
-    doIndent();
-    out << genVectorizePragma(op->vec_width);
-    out << "\n";
+    genVectorizePragma(op->vec_width, op->contents, false);
   }
 
   IRPrinter::visit(op);
@@ -527,10 +828,12 @@ void CodeGen_C::visit(const Allocate* op) {
   else {
     // If the allocation was requested to clear the allocated memory,
     // use calloc instead of malloc.
+    // Arrays that are not cleared are allocated aligned, which the code that
+    // follows the allocation may assume. Reallocated arrays are not.
     if (op->clear) {
       stream << "calloc(1, ";
     } else {
-      stream << "malloc(";
+      stream << "TACO_ASSUME_ALIGNED(taco_malloc_aligned(";
     }
   }
   stream << "sizeof(" << elementType << ")";
@@ -538,7 +841,11 @@ void CodeGen_C::visit(const Allocate* op) {
   parentPrecedence = MUL;
   op->num_elements.accept(this);
   parentPrecedence = TOP;
-  stream << ");";
+  stream << ")";
+  if (!op->is_realloc && !op->clear) {
+    stream << ")";
+  }
+  stream << ";";
     stream << endl;
 }
 
@@ -52,8 +52,17 @@ protected:
   int labelCount;
   bool emittingCoroutine;
 
+  /// The number of parallel loops that enclose the code being emitted.
+  int parallelRegionDepth;
+
   class FindVars;
 
+  /// Emit the headers that precede the first function of a module.
+  virtual void genHeaders();
+
+  void genVectorizePragma(int width, Stmt body, bool isFor);
+  void genUnrollPragma(size_t unrollFactor);
+
 private:
   virtual std::string restrictKeyword() const { return "restrict"; }
 };
@@ -0,0 +1,555 @@
+#include <string>
+
+#include "taco/ir/ir_visitor.h"
+#include "codegen_c_x86.h"
+#include "taco/error.h"
+#include "taco/util/collections.h"
+
+using namespace std;
+
+namespace taco {
+namespace ir {
+
+// Some helper functions
+namespace {
+
+// Include immintrin.h for the AVX2 intrinsics and define the horizontal sum
+// used to reduce vector accumulators. Only defined when compiling for AVX2, so
+// that the generated code also compiles for other targets. These headers follow
+// the C headers, which define the feature-test macros.
+const string x86Headers =
+  "#ifndef TACO_X86_HEADERS\n"
+  "#define TACO_X86_HEADERS\n"
+  "#if defined(__AVX2__)\n"
+  "#include <immintrin.h>\n"
+  "static inline double taco_hsum_pd(__m256d v) {\n"
+  "  __m128d lo = _mm256_castpd256_pd128(v);\n"
+  "  __m128d hi = _mm256_extractf128_pd(v, 1);\n"
+  "  lo = _mm_add_pd(lo, hi);\n"
+  "  return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));\n"
+  "}\n"
+  "#endif\n"
+  "#endif\n";
+
+// Number of double precision lanes of an AVX2 vector
+const int vectorWidth = 4;
+
+// Check whether an expression reads a variable or an array that is in the
+// given sets, i.e. whether it may differ across iterations of a vector loop.
+// Arrays are identified by the name of the C variable that holds them, since
+// the same tensor property may be referenced through distinct IR nodes.
+struct ReadsAny : public IRVisitor {
+  using IRVisitor::visit;
+
+  const set<Expr>& vars;
+  const set<string>& arrays;
+  const map<Expr, string, ExprCompare>& varMap;
+  bool reads = false;
+
+  ReadsAny(const set<Expr>& vars, const set<string>& arrays,
+           const map<Expr, string, ExprCompare>& varMap)
+      : vars(vars), arrays(arrays), varMap(varMap) {}
+
+  void visit(const Var* op) {
+    reads = reads || util::contains(vars, Expr(op));
+  }
+
+  void visit(const Load* op) {
+    reads = reads || (varMap.count(op->arr) &&
+                      util::contains(arrays, varMap.at(op->arr)));
+    IRVisitor::visit(op);
+  }
+};
+
+} // anonymous namespace
+
+CodeGen_C_X86::CodeGen_C_X86(std::ostream &dest, OutputKind outputKind,
+                             bool simplify)
+    : CodeGen_C(dest, outputKind, simplify), masked(false) {}
+
+void CodeGen_C_X86::genHeaders() {
+  CodeGen_C::genHeaders();
+  out << x86Headers;
+}
+
+void CodeGen_C_X86::visit(const For* op) {
+  if (!vectorize(op)) {
+    CodeGen_C::visit(op);
+    return;
+  }
+
+  // The loop body reads these as vectors rather than as the scalar variables
+  // of the portable loop.
+  string var = varMap[op->var];
+  string end = genUniqueName(var + "_end");
+  mask = genUniqueName("taco_mask");
+  mask32 = genUniqueName("taco_mask32");
+  for (auto& accumulator : accumulators) {
+    accumulator.second = genUniqueName(varMap[accumulator.first] + "_vec");
+  }
+  vector<Stmt> body;
+  collectBody(op->contents, &body);
+
+  doIndent();
+  out << "#if defined(__AVX2__)\n";
+  doIndent();
+  out << "{\n";
+  indent++;
+  for (auto& accumulator : accumulators) {
+    doIndent();
+    out << "__m256d " << accumulator.second << " = _mm256_setzero_pd();\n";
+  }
+  doIndent();
+  out << "int32_t " << var << " = ";
+  emitScalar(op->start);
+  out << ";\n";
+  doIndent();
+  out << "int32_t " << end << " = ";
+  emitScalar(op->end);
+  out << ";\n";
+
+  doIndent();
+  out << "for (; " << var << " + " << vectorWidth << " <= " << end << "; "
+      << var << " += " << vectorWidth << ") {\n";
+  indent++;
+  masked = false;
+  emitBody(body);
+  indent--;
+  doIndent();
+  out << "}\n";
+
+  // Run the remaining iterations as one vector iteration with inactive lanes
+  // masked off.
+  doIndent();
+  out << "if (" << var << " < " << end << ") {\n";
+  indent++;
+  doIndent();
+  out << "__m256i " << mask << " = _mm256_cmpgt_epi64(_mm256_set1_epi64x("
+      << end << " - " << var << "), _mm256_setr_epi64x(0, 1, 2, 3));\n";
+  doIndent();
+  out << "__m128i " << mask32 << " = _mm_cmpgt_epi32(_mm_set1_epi32("
+      << end << " - " << var << "), _mm_setr_epi32(0, 1, 2, 3));\n";
+  masked = true;
+  emitBody(body);
+  masked = false;
+  indent--;
+  doIndent();
+  out << "}\n";
+
+  for (auto& accumulator : accumulators) {
+    doIndent();
+    emitScalar(accumulator.first);
+    out << " = ";
+    emitScalar(accumulator.first);
+    out << " + taco_hsum_pd(" << accumulator.second << ");\n";
+  }
+  indent--;
+  doIndent();
+  out << "}\n";
+  doIndent();
+  out << "#else\n";
+  CodeGen_C::visit(op);
+  doIndent();
+  out << "#endif\n";
+}
+
+// Check whether a loop can be emitted with intrinsics and record how each
+// variable and array in its body is used. Supported bodies consist of scalar
+// declarations, additive reductions into double precision variables declared
+// outside the loop, and stores into double precision arrays at locations that
+// are consecutive across iterations.
+bool CodeGen_C_X86::vectorize(const For* op) {
+  if (op->kind != LoopKind::Vectorized || emittingCoroutine ||
+      op->var.type() != Int32) {
+    return false;
+  }
+  const Literal* increment = op->increment.as<Literal>();
+  if (increment == nullptr || !increment->type.isInt() ||
+      !increment->equalsScalar(1)) {
+    return false;
+  }
+
+  loopVar = op->var;
+  laneKinds.clear();
+  accumulators.clear();
+  storeLocations.clear();
+  laneKinds.insert({loopVar, Lanes::Affine});
+
+  vector<Stmt> body;
+  if (!collectBody(op->contents, &body)) {
+    return false;
+  }
+
+  // Find the accumulators and stored arrays first, since reading either of
+  // them elsewhere in the body prevents vectorization.
+  for (auto& stmt : body) {
+    if (isa<Assign>(stmt)) {
+      const Assign* assign = stmt.as<Assign>();
+      const Add* add = assign->rhs.as<Add>();
+      if (!isa<Var>(assign->lhs) || to<Var>(assign->lhs)->is_ptr ||
+          assign->lhs.type() != Float64 || assign->use_atomics ||
+          add == nullptr || add->a != assign->lhs) {
+        return false;
+      }
+      accumulators.insert({assign->lhs, ""});
+    }
+    else if (isa<Store>(stmt)) {
+      const Store* store = stmt.as<Store>();
+      if (store->use_atomics || !isArray(store->arr) ||
+          store->arr.type() != Float64) {
+        return false;
+      }
+      string arr = varMap.at(store->arr);
+      if (storeLocations.count(arr) && storeLocations.at(arr) != store->loc) {
+        return false;
+      }
+      storeLocations.insert({arr, store->loc});
+    }
+  }
+
+  for (auto& stmt : body) {
+    if (!checkStmt(stmt)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Arrays that are accessed in vector loops must be held in C variables.
+bool CodeGen_C_X86::isArray(Expr arr) {
+  return (isa<Var>(arr) || isa<GetProperty>(arr)) && varMap.count(arr);
+}
+
+// Flatten the blocks and scopes of a loop body into a list of statements.
+bool CodeGen_C_X86::collectBody(Stmt stmt, vector<Stmt>* body) {
+  if (isa<Block>(stmt)) {
+    for (auto& s : stmt.as<Block>()->contents) {
+      if (!collectBody(s, body)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (isa<Scope>(stmt)) {
+    return collectBody(stmt.as<Scope>()->scopedStmt, body);
+  }
+  if (isa<VarDecl>(stmt) || isa<Assign>(stmt) || isa<Store>(stmt)) {
+    body->push_back(stmt);
+    return true;
+  }
+  return isa<Comment>(stmt) || isa<BlankLine>(stmt);
+}
+
+bool CodeGen_C_X86::checkStmt(Stmt stmt) {
+  Lanes lanes;
+  if (isa<VarDecl>(stmt)) {
+    const VarDecl* decl = stmt.as<VarDecl>();
+    if (!isa<Var>(decl->var) || to<Var>(decl->var)->is_ptr ||
+        !classify(decl->rhs, &lanes)) {
+      return false;
+    }
+    if (lanes != Lanes::Uniform && decl->var.type() != Int32 &&
+        decl->var.type() != Float64) {
+      return false;
+    }
+    laneKinds.insert({decl->var, lanes});
+    return true;
+  }
+  if (isa<Assign>(stmt)) {
+    Expr value = to<Add>(stmt.as<Assign>()->rhs)->b;
+    return classify(value, &lanes) &&
+           (lanes == Lanes::Uniform || value.type() == Float64);
+  }
+  if (isa<Store>(stmt)) {
+    const Store* store = stmt.as<Store>();
+    return classify(store->loc, &lanes) && lanes == Lanes::Affine &&
+           classify(store->data, &lanes) &&
+           (lanes == Lanes::Uniform || store->data.type() == Float64);
+  }
+  return false;
+}
+
+// Determine how an expression varies across lanes. Returns false if the
+// expression cannot be computed with the supported intrinsics.
+bool CodeGen_C_X86::classify(Expr expr, Lanes* lanes) {
+  set<Expr> variant;
+  for (auto& kind : laneKinds) {
+    if (kind.second != Lanes::Uniform) {
+      variant.insert(kind.first);
+    }
+  }
+  for (auto& accumulator : accumulators) {
+    variant.insert(accumulator.first);
+  }
+  set<string> storedArrays;
+  for (auto& store : storeLocations) {
+    storedArrays.insert(store.first);
+  }
+  ReadsAny readsVariant(variant, storedArrays, varMap);
+  expr.accept(&readsVariant);
+  if (!readsVariant.reads) {
+    *lanes = Lanes::Uniform;
+    return true;
+  }
+
+  if (isa<Var>(expr)) {
+    if (accumulators.count(expr)) {
+      return false;
+    }
+    *lanes = laneKinds.at(expr);
+    return true;
+  }
+
+  if (isa<Load>(expr)) {
+    const Load* load = expr.as<Load>();
+    Lanes locLanes;
+    if (!isArray(load->arr) || load->loc.type() != Int32 ||
+        !classify(load->loc, &locLanes)) {
+      return false;
+    }
+    // Stored arrays may only be read at the location they are stored to.
+    string arr = varMap.at(load->arr);
+    if (storeLocations.count(arr) &&
+        (locLanes != Lanes::Affine || storeLocations.at(arr) != load->loc)) {
+      return false;
+    }
+    *lanes = Lanes::Varying;
+    return locLanes != Lanes::Uniform &&
+           (expr.type() == Float64 || expr.type() == Int32);
+  }
+
+  Expr a, b;
+  if (isa<Add>(expr)) {
+    a = to<Add>(expr)->a;
+    b = to<Add>(expr)->b;
+  } else if (isa<Sub>(expr)) {
+    a = to<Sub>(expr)->a;
+    b = to<Sub>(expr)->b;
+  } else if (isa<Mul>(expr)) {
+    a = to<Mul>(expr)->a;
+    b = to<Mul>(expr)->b;
+  } else if (isa<Div>(expr) && expr.type() == Float64) {
+    a = to<Div>(expr)->a;
+    b = to<Div>(expr)->b;
+  } else if (isa<Neg>(expr) && expr.type() == Float64) {
+    Lanes aLanes;
+    *lanes = Lanes::Varying;
+    return classify(to<Neg>(expr)->a, &aLanes) &&
+           to<Neg>(expr)->a.type() == Float64;
+  } else {
+    return false;
+  }
+
+  Lanes aLanes, bLanes;
+  if (!classify(a, &aLanes) || !classify(b, &bLanes)) {
+    return false;
+  }
+  if ((aLanes != Lanes::Uniform && a.type() != expr.type()) ||
+      (bLanes != Lanes::Uniform && b.type() != expr.type())) {
+    return false;
+  }
+  if (expr.type() == Int32) {
+    // The sum of consecutive integers and a uniform integer is consecutive.
+    bool affine = (isa<Add>(expr) &&
+                   ((aLanes == Lanes::Affine && bLanes == Lanes::Uniform) ||
+                    (aLanes == Lanes::Uniform && bLanes == Lanes::Affine))) ||
+                  (isa<Sub>(expr) &&
+                   aLanes == Lanes::Affine && bLanes == Lanes::Uniform);
+    *lanes = affine ? Lanes::Affine : Lanes::Varying;
+    return true;
+  }
+  *lanes = Lanes::Varying;
+  return expr.type() == Float64;
+}
+
+void CodeGen_C_X86::emitBody(const vector<Stmt>& body) {
+  for (auto& stmt : body) {
+    if (isa<VarDecl>(stmt)) {
+      const VarDecl* decl = stmt.as<VarDecl>();
+      if (laneKinds.at(decl->var) != Lanes::Varying) {
+        // Uniform and consecutive values are kept in scalars, which hold the
+        // value of the first lane.
+        stmt.accept(this);
+        continue;
+      }
+      doIndent();
+      if (decl->var.type() == Float64) {
+        out << "__m256d " << varMap[decl->var] << " = ";
+        emitDoubleVector(decl->rhs);
+      } else {
+        out << "__m128i " << varMap[decl->var] << " = ";
+        emitIntVector(decl->rhs);
+      }
+      out << ";\n";
+    }
+    else if (isa<Assign>(stmt)) {
+      const Assign* assign = stmt.as<Assign>();
+      string accumulator = accumulators.at(assign->lhs);
+      doIndent();
+      out << accumulator << " = _mm256_add_pd(" << accumulator << ", ";
+      if (masked) {
+        out << "_mm256_and_pd(";
+        emitDoubleVector(to<Add>(assign->rhs)->b);
+        out << ", _mm256_castsi256_pd(" << mask << "))";
+      } else {
+        emitDoubleVector(to<Add>(assign->rhs)->b);
+      }
+      out << ");\n";
+    }
+    else {
+      const Store* store = stmt.as<Store>();
+      doIndent();
+      if (masked) {
+        out << "_mm256_maskstore_pd(";
+        emitAddress(store->arr, store->loc);
+        out << ", " << mask << ", ";
+      } else {
+        out << "_mm256_storeu_pd(";
+        emitAddress(store->arr, store->loc);
+        out << ", ";
+      }
+      emitDoubleVector(store->data);
+      out << ");\n";
+    }
+  }
+}
+
+void CodeGen_C_X86::emitDoubleVector(Expr expr) {
+  Lanes lanes;
+  classify(expr, &lanes);
+  if (lanes == Lanes::Uniform) {
+    out << "_mm256_set1_pd(";
+    emitScalar(expr);
+    out << ")";
+  } else if (isa<Var>(expr)) {
+    out << varMap[expr];
+  } else if (isa<Load>(expr)) {
+    const Load* load = expr.as<Load>();
+    Lanes locLanes;
+    classify(load->loc, &locLanes);
+    if (locLanes == Lanes::Affine) {
+      out << (masked ? "_mm256_maskload_pd(" : "_mm256_loadu_pd(");
+      emitAddress(load->arr, load->loc);
+      if (masked) {
+        out << ", " << mask;
+      }
+      out << ")";
+    } else {
+      out << (masked ? "_mm256_mask_i32gather_pd(_mm256_setzero_pd(), "
+                     : "_mm256_i32gather_pd(");
+      load->arr.accept(this);
+      out << ", ";
+      emitIntVector(load->loc);
+      if (masked) {
+        out << ", _mm256_castsi256_pd(" << mask << ")";
+      }
+      out << ", 8)";
+    }
+  } else if (isa<Neg>(expr)) {
+    out << "_mm256_sub_pd(_mm256_setzero_pd(), ";
+    emitDoubleVector(to<Neg>(expr)->a);
+    out << ")";
+  } else {
+    Expr a, b;
+    if (isa<Add>(expr)) {
+      out << "_mm256_add_pd(";
+      a = to<Add>(expr)->a;
+      b = to<Add>(expr)->b;
+    } else if (isa<Sub>(expr)) {
+      out << "_mm256_sub_pd(";
+      a = to<Sub>(expr)->a;
+      b = to<Sub>(expr)->b;
+    } else if (isa<Mul>(expr)) {
+      out << "_mm256_mul_pd(";
+      a = to<Mul>(expr)->a;
+      b = to<Mul>(expr)->b;
+    } else {
+      taco_iassert(isa<Div>(expr));
+      out << "_mm256_div_pd(";
+      a = to<Div>(expr)->a;
+      b = to<Div>(expr)->b;
+    }
+    emitDoubleVector(a);
+    out << ", ";
+    emitDoubleVector(b);
+    out << ")";
+  }
+}
+
+void CodeGen_C_X86::emitIntVector(Expr expr) {
+  Lanes lanes;
+  classify(expr, &lanes);
+  if (lanes == Lanes::Uniform) {
+    out << "_mm_set1_epi32(";
+    emitScalar(expr);
+    out << ")";
+  } else if (lanes == Lanes::Affine) {
+    out << "_mm_add_epi32(_mm_set1_epi32(";
+    emitScalar(expr);
+    out << "), _mm_setr_epi32(0, 1, 2, 3))";
+  } else if (isa<Var>(expr)) {
+    out << varMap[expr];
+  } else if (isa<Load>(expr)) {
+    const Load* load = expr.as<Load>();
+    Lanes locLanes;
+    classify(load->loc, &locLanes);
+    if (locLanes == Lanes::Affine) {
+      if (masked) {
+        out << "_mm_maskload_epi32((const int*)";
+        emitAddress(load->arr, load->loc);
+        out << ", " << mask32 << ")";
+      } else {
+        out << "_mm_loadu_si128((const __m128i*)";
+        emitAddress(load->arr, load->loc);
+        out << ")";
+      }
+    } else {
+      out << (masked ? "_mm_mask_i32gather_epi32(_mm_setzero_si128(), "
+                     : "_mm_i32gather_epi32(");
+      out << "(const int*)";
+      load->arr.accept(this);
+      out << ", ";
+      emitIntVector(load->loc);
+      if (masked) {
+        out << ", " << mask32;
+      }
+      out << ", 4)";
+    }
+  } else {
+    Expr a, b;
+    if (isa<Add>(expr)) {
+      out << "_mm_add_epi32(";
+      a = to<Add>(expr)->a;
+      b = to<Add>(expr)->b;
+    } else if (isa<Sub>(expr)) {
+      out << "_mm_sub_epi32(";
+      a = to<Sub>(expr)->a;
+      b = to<Sub>(expr)->b;
+    } else {
+      taco_iassert(isa<Mul>(expr));
+      out << "_mm_mullo_epi32(";
+      a = to<Mul>(expr)->a;
+      b = to<Mul>(expr)->b;
+    }
+    emitIntVector(a);
+    out << ", ";
+    emitIntVector(b);
+    out << ")";
+  }
+}
+
+void CodeGen_C_X86::emitScalar(Expr expr) {
+  parentPrecedence = TOP;
+  expr.accept(this);
+}
+
+void CodeGen_C_X86::emitAddress(Expr arr, Expr loc) {
+  out << "(";
+  arr.accept(this);
+  out << " + (";
+  emitScalar(loc);
+  out << "))";
+}
+
+} // namespace ir
+} // namespace taco
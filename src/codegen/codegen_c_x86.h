@@ -0,0 +1,62 @@
+#ifndef TACO_BACKEND_C_X86_H
+#define TACO_BACKEND_C_X86_H
+#include <map>
+#include <set>
+#include <vector>
+
+#include "taco/ir/ir.h"
+#include "codegen_c.h"
+
+namespace taco {
+namespace ir {
+
+/// A C code generator for x86 targets. Loops that are parallelized over
+/// CPUVector are emitted as explicit AVX2 intrinsic code (vector loads and
+/// stores of contiguous value arrays, gathers through coordinate arrays,
+/// horizontal reductions of scalar accumulators and a masked tail iteration),
+/// guarded so that the portable C loop is compiled when the compiler does not
+/// target AVX2. Loops with bodies that cannot be expressed with intrinsics are
+/// emitted as by CodeGen_C.
+class CodeGen_C_X86 : public CodeGen_C {
+public:
+  /// Initialize a code generator that generates code to an
+  /// output stream.
+  CodeGen_C_X86(std::ostream &dest, OutputKind outputKind, bool simplify=true);
+
+protected:
+  using CodeGen_C::visit;
+
+  void visit(const For*);
+  void genHeaders();
+
+private:
+  /// How the value of an expression varies across the lanes of a vector loop:
+  /// the same in every lane, consecutive integers starting at the scalar value
+  /// of the expression, or arbitrary.
+  enum class Lanes {Uniform, Affine, Varying};
+
+  // Vectorization state of the loop that is being emitted
+  Expr loopVar;
+  std::map<Expr, Lanes, ExprCompare> laneKinds;
+  std::map<Expr, std::string, ExprCompare> accumulators;
+  std::map<std::string, Expr> storeLocations;
+  bool masked;
+  std::string mask;
+  std::string mask32;
+
+  bool vectorize(const For* op);
+  bool isArray(Expr arr);
+  bool collectBody(Stmt stmt, std::vector<Stmt>* body);
+  bool classify(Expr expr, Lanes* lanes);
+  bool checkStmt(Stmt stmt);
+
+  void emitBody(const std::vector<Stmt>& body);
+  void emitDoubleVector(Expr expr);
+  void emitIntVector(Expr expr);
+  void emitScalar(Expr expr);
+  void emitAddress(Expr arr, Expr loc);
+};
+
+} // namespace ir
+} // namespace taco
+#endif
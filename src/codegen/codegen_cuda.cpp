@@ -37,6 +37,7 @@ const string cHeaders =
   "#include <thrust/complex.h>\n"
   "#define TACO_MIN(_a,_b) ((_a) < (_b) ? (_a) : (_b))\n"
   "#define TACO_MAX(_a,_b) ((_a) > (_b) ? (_a) : (_b))\n"
+  "#define TACO_SELECT(_c,_a,_b) ((_c) ? (_a) : (_b))\n"
   "#define TACO_DEREF(_a) (((___context___*)(*__ctx__))->_a)\n"
   "#ifndef TACO_TENSOR_T_DEFINED\n"
   "#define TACO_TENSOR_T_DEFINED\n"
@@ -107,6 +108,12 @@ const string gpuAssertMacro =
   "  }\n"
   "  return lowerBound;\n"
   "}\n"
+  "__host__ int taco_prefixSum(int *array, int size) {\n"
+  "  for (int i = 1; i < size; i++) {\n"
+  "    array[i] += array[i - 1];\n"
+  "  }\n"
+  "  return array[size - 1];\n"
+  "}\n"
   "__global__ void taco_binarySearchBeforeBlock(int * __restrict__ array, int * __restrict__ results, int arrayStart, int arrayEnd, int values_per_block, int num_blocks) {\n"
   "  int thread = threadIdx.x;\n"
   "  int block = blockIdx.x;\n"
@@ -1157,6 +1164,10 @@ void CodeGen_CUDA::visit(const Sqrt* op) {
   stream << ")";
 }
 
+void CodeGen_CUDA::visit(const Prefetch*) {
+  // Prefetches are hints that are not emitted for GPUs
+}
+
 void CodeGen_CUDA::visit(const Continue*) {
   doIndent();
   if(!isHostFunction && deviceFunctionLoopDepth == 0) {
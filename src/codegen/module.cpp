@@ -1,7 +1,12 @@
 #include "taco/codegen/module.h"
 
+#include <chrono>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <functional>
+#include <tuple>
 #include <dlfcn.h>
 #include <unistd.h>
 #if USE_OPENMP
@@ -10,6 +15,7 @@
 
 #include "taco/tensor.h"
 #include "taco/error.h"
+#include "taco/ir/ir_visitor.h"
 #include "taco/util/strings.h"
 #include "taco/util/env.h"
 #include "codegen/codegen_c.h"
@@ -21,6 +27,8 @@ using namespace std;
 namespace taco {
 namespace ir {
 
+const char *KernelISA_NAMES[] = {"generic", "avx2", "avx512"};
+
 std::string Module::chars = "abcdefghijkmnpqrstuvwxyz0123456789";
 std::default_random_engine Module::gen = std::default_random_engine();
 std::uniform_int_distribution<int> Module::randint =
@@ -30,6 +38,21 @@ void Module::setJITTmpdir() {
   tmpdir = util::getTmpdir();
 }
 
+void Module::setMultiVersionedFromEnv() {
+  multiVersioned = util::getFromEnv("TACO_MULTIVERSION", "0") != "0";
+}
+
+void Module::setProfileGuidedFromEnv() {
+  string trainingCalls = util::getFromEnv("TACO_PGO", "0");
+  char* end = nullptr;
+  long calls = strtol(trainingCalls.c_str(), &end, 10);
+  taco_uassert(!trainingCalls.empty() && *end == '\0' &&
+               calls >= 0 && calls <= INT_MAX)
+      << "TACO_PGO must be a non-negative number of training calls, but is "
+      << "\"" << trainingCalls << "\"";
+  pgoTrainingCalls = (int)calls;
+}
+
 void Module::setJITLibname() {
   libname.resize(12);
   for (int i=0; i<12; i++)
@@ -51,12 +74,12 @@ void Module::compileToSource(string path, string prefix) {
     source.str("");
     source.clear();
 
-    taco_tassert(target.arch == Target::C99) <<
-        "Only C99 codegen supported currently";
+    taco_tassert(target.arch == Target::C99 || target.arch == Target::X86) <<
+        "Only C99 and x86 codegen supported currently";
     std::shared_ptr<CodeGen> sourcegen =
-        CodeGen::init_default(source, CodeGen::ImplementationGen);
+        CodeGen::init_default(source, CodeGen::ImplementationGen, target);
     std::shared_ptr<CodeGen> headergen =
-            CodeGen::init_default(header, CodeGen::HeaderGen);
+            CodeGen::init_default(header, CodeGen::HeaderGen, target);
 
     for (auto func: funcs) {
       sourcegen->compile(func, !didGenRuntime);
@@ -106,8 +129,72 @@ void writeShims(vector<Stmt> funcs, string path, string prefix) {
   shims_file.close();
 }
 
+// Extra compiler flags that enable each instruction set variant.
+string getISAFlags(KernelISA isa) {
+  switch (isa) {
+    case KernelISA::Generic:
+      return "";
+    case KernelISA::AVX2:
+      return " -mavx2 -mfma";
+    case KernelISA::AVX512:
+      return " -mavx512f -mavx512vl -mavx512bw -mavx512dq -mavx2 -mfma";
+  }
+  return "";
+}
+
+// True iff the functions contain OpenMP parallel regions, either as parallel
+// loops or in the runtime helpers that they call. Modules created from user
+// source are checked for parallel pragmas instead.
+bool containsParallelCode(const vector<Stmt>& funcs, const string& source) {
+  struct FindParallelCode : public IRVisitor {
+    using IRVisitor::visit;
+    bool found = false;
+
+    void visit(const For* op) {
+      if (op->kind != LoopKind::Serial && op->kind != LoopKind::Vectorized) {
+        found = true;
+        return;
+      }
+      IRVisitor::visit(op);
+    }
+
+    void visit(const Call* op) {
+      found = found || op->func == "taco_prefixSum";
+      IRVisitor::visit(op);
+    }
+  };
+
+  if (funcs.empty()) {
+    return source.find("omp parallel") != string::npos;
+  }
+  FindParallelCode finder;
+  for (auto& func : funcs) {
+    func.accept(&finder);
+  }
+  return finder.found;
+}
+
 } // anonymous namespace
 
+// Check with cpuid whether the host CPU can execute code compiled for isa.
+bool isKernelISASupported(KernelISA isa) {
+  switch (isa) {
+    case KernelISA::Generic:
+      return true;
+#if defined(__x86_64__) || defined(__i386__)
+    case KernelISA::AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case KernelISA::AVX512:
+      return __builtin_cpu_supports("avx512f") &&
+             __builtin_cpu_supports("avx512vl") &&
+             __builtin_cpu_supports("avx512bw") &&
+             __builtin_cpu_supports("avx512dq");
+#endif
+    default:
+      return false;
+  }
+}
+
 string Module::compile() {
   string prefix = tmpdir+libname;
   string fullpath = prefix + ".so";
@@ -136,7 +223,15 @@ string Module::compile() {
     cflags = util::getFromEnv("TACO_CFLAGS", defaultFlags) + " -shared -fPIC";
 #if USE_OPENMP
     cflags += " -fopenmp";
+#else
+    // Honor the `omp simd` pragmas emitted for vectorized loops.
+    cflags += " -fopenmp-simd";
 #endif
+    // Kernels with x86 intrinsics are compiled for the host's instruction set
+    // unless a library is built for every instruction set variant.
+    if (target.arch == Target::X86 && !multiVersioned) {
+      cflags += " -march=native";
+    }
     file_ending = ".c";
     shims_file = "";
   }
@@ -144,26 +239,222 @@ string Module::compile() {
   string cmd = cc + " " + cflags + " " +
     prefix + file_ending + " " + shims_file + " " + 
     "-o " + fullpath + " -lm";
+  compilerCommand = cc + " " + cflags;
 
   // open the output file & write out the source
   compileToSource(tmpdir, libname);
   
   // write out the shims
   writeShims(funcs, tmpdir, libname);
+
+  if (pgoTrainingCalls > 0 && !should_use_CUDA_codegen()) {
+    // Reuse a library that was optimized with a profile of the same source.
+    string pgopath = getProfileGuidedLibraryPath();
+    if (access(pgopath.data(), R_OK) == 0) {
+      loadLibrary(pgopath);
+      isa = KernelISA::Generic;
+      pgoCallsRemaining = 0;
+      return pgopath;
+    }
+
+    // Otherwise build and load an instrumented library that collects a
+    // profile. The object file is compiled separately so that the instrumented
+    // and optimized builds agree on the name of the profile data file.
+    string instrpath = prefix + "_instrumented.so";
+    string profileFlags = " -fprofile-generate=" + prefix + "_profile" +
+                          " -DTACO_PGO_INSTRUMENTED";
+    string instrcmd = compilerCommand + profileFlags + " -c " + prefix +
+                      file_ending + " -o " + prefix + "_pgo.o && " +
+                      compilerCommand + profileFlags + " " + prefix +
+                      "_pgo.o -o " + instrpath + " -lm";
+    int err = system(instrcmd.data());
+    taco_uassert(err == 0) << "Compilation command failed:\n" << instrcmd
+      << "\nreturned " << err;
+    loadLibrary(instrpath);
+    isa = KernelISA::Generic;
+    pgoCallsRemaining = pgoTrainingCalls;
+    return instrpath;
+  }
   
   // now compile it
   int err = system(cmd.data());
   taco_uassert(err == 0) << "Compilation command failed:\n" << cmd
     << "\nreturned " << err;
 
+  KernelISA loadedISA = KernelISA::Generic;
+  if (multiVersioned && !should_use_CUDA_codegen()) {
+    // Build every instruction set variant next to the generic library so that
+    // the set of libraries can be loaded on any host, and pick the most
+    // capable variant that this host supports. Variants that the C compiler
+    // cannot build are skipped.
+    for (KernelISA variant : {KernelISA::AVX2, KernelISA::AVX512}) {
+      string variantpath = prefix + "_" +
+                           KernelISA_NAMES[(int)variant] + ".so";
+      string variantcmd = cc + " " + cflags + getISAFlags(variant) + " " +
+                          prefix + file_ending + " -o " + variantpath +
+                          " -lm 2> /dev/null";
+      if (system(variantcmd.data()) == 0 && isKernelISASupported(variant)) {
+        fullpath = variantpath;
+        loadedISA = variant;
+      }
+    }
+  }
+
+  loadLibrary(fullpath);
+  isa = loadedISA;
+
+  return fullpath;
+}
+
+void Module::loadLibrary(string path) {
+  std::lock_guard<std::mutex> lock(funcPtrsMutex);
+
   // use dlsym() to open the compiled library
   if (lib_handle) {
     dlclose(lib_handle);
   }
-  lib_handle = dlopen(fullpath.data(), RTLD_NOW | RTLD_LOCAL);
+  lib_handle = dlopen(path.data(), RTLD_NOW | RTLD_LOCAL);
   taco_uassert(lib_handle) << "Failed to load generated code, error is: " << dlerror();
+  resolveFuncPtrs();
+}
 
-  return fullpath;
+void Module::resolveFuncPtrs() {
+  // Resolve the functions and their shims up front so that calls do not have
+  // to look them up by name. Entries are updated in place rather than
+  // replaced, so that slots handed out by getFuncPtrSlot stay valid and never
+  // hold a null pointer while a library is swapped in.
+  for (auto& func : funcs) {
+    taco_iassert(func.as<Function>()) << "Module function is not a Function";
+    string name = func.as<Function>()->name;
+    for (string funcName : {name, "_shim_" + name}) {
+      funcPtrs.emplace(std::piecewise_construct,
+                       std::forward_as_tuple(funcName),
+                       std::forward_as_tuple(nullptr));
+    }
+  }
+  for (auto& funcPtr : funcPtrs) {
+    funcPtr.second.store(dlsym(lib_handle, funcPtr.first.data()),
+                         std::memory_order_release);
+  }
+  hasParallelCode = containsParallelCode(funcs, source.str());
+}
+
+string Module::getProfileGuidedLibraryPath() {
+  // Optimized libraries are named after a hash of their source and compiler
+  // command, so that modules with the same kernels share them.
+  string pgodir = util::getFromEnv("TACO_PGO_DIR", tmpdir);
+  if (pgodir.back() != '/') {
+    pgodir += '/';
+  }
+  string key = util::sha256(compilerCommand + "\n" + source.str());
+  return pgodir + "taco_pgo_" + key + ".so";
+}
+
+void Module::optimizeWithProfile() {
+  std::future<void> build;
+  {
+    std::lock_guard<std::mutex> lock(pgoMutex);
+    taco_uassert(pgoCallsRemaining > 0 || pgoBuild.valid())
+        << "The module is not collecting a profile";
+    pgoCallsRemaining = 0;
+    build = std::move(pgoBuild);
+  }
+  if (build.valid()) {
+    // The optimized library is already being built, and errors in building
+    // it are rethrown here
+    build.get();
+    return;
+  }
+  loadProfileOptimizedLibrary();
+}
+
+void Module::loadProfileOptimizedLibrary() {
+  // Write out the profile collected so far. Other threads may still be running
+  // the functions of the instrumented library, so it is not unloaded, which
+  // would also write out the profile.
+  typedef void (*writeprofile_t)();
+  writeprofile_t writeProfile;
+  *reinterpret_cast<void**>(&writeProfile) =
+      dlsym(lib_handle, "taco_write_profile");
+  if (writeProfile != nullptr) {
+    writeProfile();
+  }
+
+  string prefix = tmpdir + libname;
+  string profiledir = prefix + "_profile";
+  string pgopath = getProfileGuidedLibraryPath();
+
+  // Clang writes raw profiles that have to be merged before they can be used,
+  // whereas GCC writes profiles that are used directly.
+  string mergecmd = "ls " + profiledir + "/*.profraw > /dev/null 2>&1 && " +
+                    util::getFromEnv("TACO_PROFDATA", "llvm-profdata") +
+                    " merge -output=" + profiledir + "/default.profdata " +
+                    profiledir + "/*.profraw > /dev/null 2>&1";
+  if (system(mergecmd.data()) != 0) {
+    // No raw profiles to merge.
+  }
+
+  string profileFlags = " -fprofile-use=" + profiledir +
+                        " -fprofile-correction -Wno-missing-profile";
+  string cmd = compilerCommand + profileFlags + " -c " + prefix + ".c -o " +
+               prefix + "_pgo.o && " + compilerCommand + " " + prefix +
+               "_pgo.o -o " + pgopath + " -lm";
+  int err = system(cmd.data());
+  taco_uassert(err == 0) << "Profile-guided compilation command failed:\n"
+    << cmd << "\nreturned " << err;
+
+  // The optimized library is built before it is swapped in, so calls only
+  // wait for the swap itself
+  void* handle = dlopen(pgopath.data(), RTLD_NOW | RTLD_LOCAL);
+  taco_uassert(handle) << "Failed to load generated code, error is: "
+                       << dlerror();
+  std::lock_guard<std::mutex> lock(funcPtrsMutex);
+  retiredHandles.push_back(lib_handle);
+  lib_handle = handle;
+  resolveFuncPtrs();
+}
+
+Module::~Module() {
+  // A profile-optimized library that is still being built uses the module
+  if (pgoBuild.valid()) {
+    pgoBuild.wait();
+  }
+}
+
+void Module::setProfileGuided(int trainingCalls) {
+  taco_uassert(trainingCalls >= 0)
+      << "The number of training calls must not be negative";
+  pgoTrainingCalls = trainingCalls;
+}
+
+bool Module::isCollectingProfile() const {
+  std::lock_guard<std::mutex> lock(pgoMutex);
+  return pgoCallsRemaining > 0;
+}
+
+void Module::setMultiVersioned(bool multiVersioned) {
+  this->multiVersioned = multiVersioned;
+}
+
+KernelISA Module::getISA() const {
+  return isa;
+}
+
+bool Module::loadISA(KernelISA isa) {
+  if (!multiVersioned || isCollectingProfile() || !isKernelISASupported(isa)) {
+    return false;
+  }
+  string path = tmpdir + libname;
+  if (isa != KernelISA::Generic) {
+    path += string("_") + KernelISA_NAMES[(int)isa];
+  }
+  path += ".so";
+  if (access(path.data(), R_OK) != 0) {
+    return false;
+  }
+  loadLibrary(path);
+  this->isa = isa;
+  return true;
 }
 
 void Module::setSource(string source) {
@@ -176,46 +467,144 @@ string Module::getSource() {
 }
 
 void* Module::getFuncPtr(std::string name) {
+  std::lock_guard<std::mutex> lock(funcPtrsMutex);
+  auto it = funcPtrs.find(name);
+  if (it != funcPtrs.end()) {
+    void* ptr = it->second.load(std::memory_order_acquire);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
   return dlsym(lib_handle, name.data());
 }
 
-int Module::callFuncPackedRaw(std::string name, void** args) {
+const std::atomic<void*>* Module::getFuncPtrSlot(std::string name) {
+  std::lock_guard<std::mutex> lock(funcPtrsMutex);
+  auto it = funcPtrs.find(name);
+  if (it == funcPtrs.end()) {
+    void* ptr = dlsym(lib_handle, name.data());
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+    it = funcPtrs.emplace(std::piecewise_construct,
+                          std::forward_as_tuple(name),
+                          std::forward_as_tuple(ptr)).first;
+  }
+  return &it->second;
+}
+
+namespace {
+
+// Call a packed function under taco's OpenMP parallel schedule and thread
+// count, or under the given schedule if there is one. Serial functions are not
+// affected by either, so they are called directly.
+int callWithParallelSettings(void* funcPtr, void** args, bool isParallel,
+                             const ParallelSchedule* schedule, int chunkSize) {
   typedef int (*fnptr_t)(void**);
   static_assert(sizeof(void*) == sizeof(fnptr_t),
     "Unable to cast dlsym() returned void pointer to function pointer");
-  void* v_func_ptr = getFuncPtr(name);
   fnptr_t func_ptr;
-  *reinterpret_cast<void**>(&func_ptr) = v_func_ptr;
+  *reinterpret_cast<void**>(&func_ptr) = funcPtr;
 
 #if USE_OPENMP
+  if (!isParallel) {
+    return func_ptr(args);
+  }
+
   omp_sched_t existingSched;
   ParallelSchedule tacoSched;
   int existingChunkSize, tacoChunkSize;
   int existingNumThreads = omp_get_max_threads();
   omp_get_schedule(&existingSched, &existingChunkSize);
-  taco_get_parallel_schedule(&tacoSched, &tacoChunkSize);
+  if (schedule != nullptr) {
+    tacoSched = *schedule;
+    tacoChunkSize = chunkSize;
+  }
+  else {
+    taco_get_parallel_schedule(&tacoSched, &tacoChunkSize);
+  }
+  int tacoNumThreads = taco_get_num_threads();
+
+  omp_sched_t sched = existingSched;
+  bool setSched = false;
   switch (tacoSched) {
     case ParallelSchedule::Static:
-      omp_set_schedule(omp_sched_static, tacoChunkSize);
+      sched = omp_sched_static;
+      setSched = true;
       break;
     case ParallelSchedule::Dynamic:
-      omp_set_schedule(omp_sched_dynamic, tacoChunkSize);
+      sched = omp_sched_dynamic;
+      setSched = true;
       break;
     default:
       break;
   }
-  omp_set_num_threads(taco_get_num_threads());
+  setSched = setSched && (sched != existingSched ||
+                          tacoChunkSize != existingChunkSize);
+  if (setSched) {
+    omp_set_schedule(sched, tacoChunkSize);
+  }
+  bool setNumThreads = (tacoNumThreads != existingNumThreads);
+  if (setNumThreads) {
+    omp_set_num_threads(tacoNumThreads);
+  }
 #endif
 
   int ret = func_ptr(args);
 
 #if USE_OPENMP
-  omp_set_schedule(existingSched, existingChunkSize);
-  omp_set_num_threads(existingNumThreads);
+  if (setSched) {
+    omp_set_schedule(existingSched, existingChunkSize);
+  }
+  if (setNumThreads) {
+    omp_set_num_threads(existingNumThreads);
+  }
 #endif
 
   return ret;
 }
 
+} // anonymous namespace
+
+int Module::callFuncPtr(void* funcPtr, void** args) {
+  return callFuncPtrWithSchedule(funcPtr, args, nullptr, 0);
+}
+
+int Module::callFuncPtr(void* funcPtr, void** args, ParallelSchedule schedule,
+                        int chunkSize) {
+  return callFuncPtrWithSchedule(funcPtr, args, &schedule, chunkSize);
+}
+
+int Module::callFuncPtrWithSchedule(void* funcPtr, void** args,
+                                    const ParallelSchedule* schedule,
+                                    int chunkSize) {
+  int ret = callWithParallelSettings(funcPtr, args, hasParallelCode, schedule,
+                                     chunkSize);
+
+  // Once the instrumented library has served its training calls, the
+  // profile-optimized library is built in the background and swapped in when
+  // it is ready, so that calls do not wait for the compiler. The first call
+  // after a failed build reports the failure.
+  std::future<void> build;
+  {
+    std::lock_guard<std::mutex> lock(pgoMutex);
+    if (pgoCallsRemaining == 1) {
+      pgoCallsRemaining = 0;
+      pgoBuild = std::async(std::launch::async,
+                            &Module::loadProfileOptimizedLibrary, this);
+    } else if (pgoCallsRemaining > 1) {
+      pgoCallsRemaining--;
+    } else if (pgoBuild.valid() &&
+               pgoBuild.wait_for(std::chrono::seconds(0)) ==
+                   std::future_status::ready) {
+      build = std::move(pgoBuild);
+    }
+  }
+  if (build.valid()) {
+    build.get();
+  }
+  return ret;
+}
+
 } // namespace ir
 } // namespace taco
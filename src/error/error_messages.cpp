@@ -37,6 +37,9 @@ const std::string assemble_without_compile =
 const std::string compute_without_compile =
    "The compile method must be called before compute.";
 
+const std::string compute_aliased_operand =
+   "A tensor cannot be computed from an operand that shares its storage.";
+
 const std::string requires_matrix =
     "The argument must be a matrix.";
 
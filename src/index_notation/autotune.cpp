@@ -0,0 +1,365 @@
+#include "taco/index_notation/autotune.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include "taco/tensor.h"
+#include "taco/index_notation/index_notation_nodes.h"
+#include "taco/index_notation/index_notation_rewriter.h"
+#include "taco/index_notation/provenance_graph.h"
+#include "taco/error.h"
+#include "taco/util/collections.h"
+#include "taco/util/env.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+
+namespace taco {
+
+// The number of loop orders, ranked by estimated cost, that candidates are
+// generated for, and the split factors tried when vectorizing innermost loops.
+static const size_t maxTunedLoopOrders = 3;
+static const vector<int> vectorWidths = {0, 4, 16};
+
+// The OpenMP schedules and chunk sizes tried for parallelized outer loops.
+static const vector<pair<ParallelSchedule,int>> parallelSchedules = {
+  {ParallelSchedule::Static, 0},
+  {ParallelSchedule::Dynamic, 16},
+  {ParallelSchedule::Dynamic, 256}
+};
+
+
+// class TunedSchedule
+TunedSchedule::TunedSchedule()
+    : parallelize(false), parallelSchedule(ParallelSchedule::Static),
+      chunkSize(0), vectorWidth(0) {
+}
+
+/// Returns true iff every tensor that is accessed by i stores the mode that i
+/// indexes in a full level, so that the loop over i can be vectorized.
+static bool isDenseLoop(IndexStmt stmt, IndexVar i) {
+  bool isDense = true;
+  match(stmt,
+    function<void(const AccessNode*)>([&](const AccessNode* op) {
+      const Format format = op->tensorVar.getFormat();
+      const vector<int> modeOrdering = format.getModeOrdering();
+      const vector<ModeFormat> modeFormats = format.getModeFormats();
+      for (size_t level = 0; level < modeOrdering.size(); level++) {
+        if (op->indexVars[modeOrdering[level]] == i &&
+            !modeFormats[level].isFull()) {
+          isDense = false;
+        }
+      }
+    })
+  );
+  return isDense;
+}
+
+/// Split the forall over i and vectorize the inner loop of the split.
+static IndexStmt vectorize(IndexStmt stmt, IndexVar i, int width) {
+  if (!isDenseLoop(stmt, i)) {
+    return IndexStmt();
+  }
+
+  IndexVar i0(i.getName() + "_o");
+  IndexVar i1(i.getName() + "_v");
+  IndexVarRel rel = IndexVarRel(new SplitRelNode(i, i0, i1, width));
+  string reason;
+  IndexStmt split = Transformation(AddSuchThatPredicates({rel})).apply(stmt,
+                                                                       &reason);
+  if (!split.defined()) {
+    return IndexStmt();
+  }
+  split = Transformation(ForAllReplace({i}, {i0, i1})).apply(split, &reason);
+  if (!split.defined()) {
+    return IndexStmt();
+  }
+
+  IndexStmt vectorized = Parallelize(i1, ParallelUnit::CPUVector,
+                                     OutputRaceStrategy::NoRaces).apply(split,
+                                                                        &reason);
+  if (!vectorized.defined()) {
+    vectorized = Parallelize(i1, ParallelUnit::CPUVector,
+                             OutputRaceStrategy::ParallelReduction).apply(split,
+                                                                          &reason);
+  }
+  return vectorized;
+}
+
+IndexStmt TunedSchedule::apply(IndexStmt stmt) const {
+  map<string,IndexVar> indexVars;
+  for (auto& indexVar : stmt.getIndexVars()) {
+    indexVars.insert({indexVar.getName(), indexVar});
+  }
+  vector<IndexVar> order;
+  for (auto& name : loopOrder) {
+    if (!util::contains(indexVars, name)) {
+      return IndexStmt();
+    }
+    order.push_back(indexVars.at(name));
+  }
+
+  IndexStmt scheduled = applyLoopOrder(stmt, order);
+  if (!scheduled.defined()) {
+    return IndexStmt();
+  }
+
+  if (parallelize) {
+    IndexStmt parallelized = parallelizeOuterLoop(scheduled);
+    if (parallelized == scheduled) {
+      return IndexStmt();
+    }
+    scheduled = parallelized;
+  }
+
+  if (vectorWidth > 0) {
+    // A single loop cannot be both parallelized and vectorized
+    if (order.empty() || (parallelize && order.size() == 1)) {
+      return IndexStmt();
+    }
+    scheduled = vectorize(scheduled, order.back(), vectorWidth);
+  }
+  return scheduled;
+}
+
+bool TunedSchedule::parse(const std::string& str, TunedSchedule* schedule) {
+  TunedSchedule parsed;
+  bool hasOrder = false;
+  for (auto& field : util::split(str, ";")) {
+    const size_t eq = field.find('=');
+    if (eq == string::npos) {
+      return false;
+    }
+    const string name = field.substr(0, eq);
+    const vector<string> values = util::split(field.substr(eq + 1), ",");
+    if (name == "order") {
+      parsed.loopOrder = values;
+      hasOrder = true;
+    }
+    else if (name == "parallel") {
+      if (values.size() == 1 && values[0] == "none") {
+        parsed.parallelize = false;
+      }
+      else if (values.size() == 2 &&
+               (values[0] == "static" || values[0] == "dynamic")) {
+        parsed.parallelize = true;
+        parsed.parallelSchedule = (values[0] == "static")
+                                  ? ParallelSchedule::Static
+                                  : ParallelSchedule::Dynamic;
+        parsed.chunkSize = atoi(values[1].c_str());
+      }
+      else {
+        return false;
+      }
+    }
+    else if (name == "vector" && values.size() == 1) {
+      parsed.vectorWidth = atoi(values[0].c_str());
+    }
+    else {
+      return false;
+    }
+  }
+  if (!hasOrder) {
+    return false;
+  }
+  *schedule = parsed;
+  return true;
+}
+
+bool operator==(const TunedSchedule& a, const TunedSchedule& b) {
+  return a.loopOrder == b.loopOrder && a.parallelize == b.parallelize &&
+         (!a.parallelize || (a.parallelSchedule == b.parallelSchedule &&
+                             a.chunkSize == b.chunkSize)) &&
+         a.vectorWidth == b.vectorWidth;
+}
+
+std::ostream& operator<<(std::ostream& os, const TunedSchedule& schedule) {
+  os << "order=" << util::join(schedule.loopOrder, ",");
+  if (schedule.parallelize) {
+    os << ";parallel="
+       << (schedule.parallelSchedule == ParallelSchedule::Static ? "static"
+                                                                 : "dynamic")
+       << "," << schedule.chunkSize;
+  }
+  else {
+    os << ";parallel=none";
+  }
+  return os << ";vector=" << schedule.vectorWidth;
+}
+
+
+std::string getTuningKey(Assignment assignment,
+                         const map<TensorVar,TensorStatistics>& statistics) {
+  // Tensors are renamed by their order of appearance, so that assignments
+  // with the same structure share a key whatever their tensors are called
+  vector<TensorVar> tensorVars = {assignment.getLhs().getTensorVar()};
+  match(assignment.getRhs(),
+    function<void(const AccessNode*)>([&](const AccessNode* op) {
+      if (!util::contains(tensorVars, op->tensorVar)) {
+        tensorVars.push_back(op->tensorVar);
+      }
+    })
+  );
+  map<TensorVar,TensorVar> canonicalVars;
+  for (size_t i = 0; i < tensorVars.size(); i++) {
+    canonicalVars.insert({tensorVars[i],
+                          TensorVar("T" + to_string(i), tensorVars[i].getType(),
+                                    tensorVars[i].getFormat(),
+                                    tensorVars[i].getFill())});
+  }
+
+  stringstream key;
+  key << replace(IndexStmt(assignment), canonicalVars);
+  for (auto& tensorVar : tensorVars) {
+    key << "; " << canonicalVars.at(tensorVar).getName() << " "
+        << tensorVar.getFormat();
+    if (!util::contains(statistics, tensorVar) ||
+        statistics.at(tensorVar).levelSizes.empty()) {
+      continue;
+    }
+
+    double size = 1.0;
+    key << " [";
+    for (auto& dimension : tensorVar.getType().getShape()) {
+      double dimensionSize = dimension.isFixed()
+                             ? (double)std::max(dimension.getSize(), (size_t)1)
+                             : 1.0;
+      key << std::lround(std::log2(dimensionSize)) << ",";
+      size *= dimensionSize;
+    }
+    const double nnz = statistics.at(tensorVar).levelSizes.back();
+    key << "d" << (nnz > 0.0 ? std::lround(std::log10(nnz / size)) : 0) << "]";
+  }
+  return key.str();
+}
+
+std::vector<TunedSchedule>
+getScheduleCandidates(IndexStmt stmt,
+                      const map<TensorVar,TensorStatistics>& statistics,
+                      size_t maxCandidates) {
+  // Rank the loop orders by their estimated cost
+  vector<pair<double,vector<IndexVar>>> orders;
+  for (auto& order : getLegalLoopOrders(stmt)) {
+    IndexStmt scheduled = applyLoopOrder(stmt, order);
+    if (scheduled.defined()) {
+      orders.push_back({estimateCost(scheduled, statistics), order});
+    }
+  }
+  std::stable_sort(orders.begin(), orders.end(),
+                   [](const pair<double,vector<IndexVar>>& a,
+                      const pair<double,vector<IndexVar>>& b) {
+                     return a.first < b.first;
+                   });
+  if (orders.size() > maxTunedLoopOrders) {
+    orders.resize(maxTunedLoopOrders);
+  }
+
+  vector<TunedSchedule> candidates;
+  for (auto& order : orders) {
+    TunedSchedule candidate;
+    for (auto& indexVar : order.second) {
+      candidate.loopOrder.push_back(indexVar.getName());
+    }
+
+    for (int vectorWidth : vectorWidths) {
+      candidate.vectorWidth = vectorWidth;
+
+      vector<TunedSchedule> variants;
+      candidate.parallelize = false;
+      variants.push_back(candidate);
+      candidate.parallelize = true;
+      for (auto& parallelSchedule : parallelSchedules) {
+        candidate.parallelSchedule = parallelSchedule.first;
+        candidate.chunkSize = parallelSchedule.second;
+        variants.push_back(candidate);
+      }
+
+      for (auto& variant : variants) {
+        if (candidates.size() < maxCandidates &&
+            variant.apply(stmt).defined()) {
+          candidates.push_back(variant);
+        }
+      }
+    }
+  }
+  return candidates;
+}
+
+
+// Tuning database
+static std::mutex tuningDatabaseMutex;
+static map<string,TunedSchedule> tunedSchedules;
+static bool tuningDatabaseLoaded = false;
+
+static string& tuningDatabasePath() {
+  static string path = util::getFromEnv("TACO_TUNING_DB", "");
+  return path;
+}
+
+/// Load the schedules stored in the tuning database file, if it has not been
+/// loaded. Every line holds a key and a schedule separated by a tab, and later
+/// lines take precedence over earlier lines with the same key.
+static void loadTuningDatabase() {
+  if (tuningDatabaseLoaded) {
+    return;
+  }
+  tuningDatabaseLoaded = true;
+  if (tuningDatabasePath().empty()) {
+    return;
+  }
+
+  ifstream file(tuningDatabasePath());
+  string line;
+  while (getline(file, line)) {
+    const size_t tab = line.rfind('\t');
+    TunedSchedule schedule;
+    if (tab != string::npos &&
+        TunedSchedule::parse(line.substr(tab + 1), &schedule)) {
+      tunedSchedules[line.substr(0, tab)] = schedule;
+    }
+  }
+}
+
+void setTuningDatabase(const std::string& path) {
+  lock_guard<mutex> lock(tuningDatabaseMutex);
+  tuningDatabasePath() = path;
+  tunedSchedules.clear();
+  tuningDatabaseLoaded = false;
+}
+
+std::string getTuningDatabase() {
+  lock_guard<mutex> lock(tuningDatabaseMutex);
+  return tuningDatabasePath();
+}
+
+bool findTunedSchedule(const std::string& key, TunedSchedule* schedule) {
+  lock_guard<mutex> lock(tuningDatabaseMutex);
+  loadTuningDatabase();
+  if (!util::contains(tunedSchedules, key)) {
+    return false;
+  }
+  *schedule = tunedSchedules.at(key);
+  return true;
+}
+
+void recordTunedSchedule(const std::string& key,
+                         const TunedSchedule& schedule) {
+  taco_uassert(key.find('\n') == string::npos &&
+               key.find('\t') == string::npos)
+      << "Tuning database keys cannot contain tabs or newlines";
+
+  lock_guard<mutex> lock(tuningDatabaseMutex);
+  loadTuningDatabase();
+  tunedSchedules[key] = schedule;
+  if (!tuningDatabasePath().empty()) {
+    ofstream file(tuningDatabasePath(), ios::app);
+    taco_uassert(file.is_open())
+        << "Unable to write to the tuning database " << tuningDatabasePath();
+    file << key << "\t" << schedule << endl;
+  }
+}
+
+}
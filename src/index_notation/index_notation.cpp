@@ -450,7 +450,7 @@ struct Isomorphic : public IndexNotationVisitorStrict {
         !check(anode->stmt, bnode->stmt) ||
         anode->parallel_unit != bnode->parallel_unit ||
         anode->output_race_strategy != bnode->output_race_strategy ||
-        anode->unrollFactor != bnode->unrollFactor) {
+        anode->annotations != bnode->annotations) {
       eq = false;
       return;
     }
@@ -909,7 +909,7 @@ struct Equals : public IndexNotationVisitorStrict {
         !equals(anode->stmt, bnode->stmt) ||
         anode->parallel_unit != bnode->parallel_unit ||
         anode->output_race_strategy != bnode->output_race_strategy ||
-        anode->unrollFactor != bnode->unrollFactor) {
+        anode->annotations != bnode->annotations) {
       eq = false;
       return;
     }
@@ -1816,8 +1816,10 @@ IndexStmt IndexStmt::concretize() const {
   return stmt;
 }
 
-IndexStmt IndexStmt::split(IndexVar i, IndexVar i1, IndexVar i2, size_t splitFactor) const {
-  IndexVarRel rel = IndexVarRel(new SplitRelNode(i, i1, i2, splitFactor));
+IndexStmt IndexStmt::split(IndexVar i, IndexVar i1, IndexVar i2, size_t splitFactor,
+                           TailStrategy tailStrategy) const {
+  IndexVarRel rel = IndexVarRel(new SplitRelNode(i, i1, i2, splitFactor,
+                                                 tailStrategy));
   string reason;
 
   // Add predicate to concrete index notation
@@ -1835,8 +1837,13 @@ IndexStmt IndexStmt::split(IndexVar i, IndexVar i1, IndexVar i2, size_t splitFac
   return transformed;
 }
 
-IndexStmt IndexStmt::divide(IndexVar i, IndexVar i1, IndexVar i2, size_t splitFactor) const {
-  IndexVarRel rel = IndexVarRel(new DivideRelNode(i, i1, i2, splitFactor));
+IndexStmt IndexStmt::divide(IndexVar i, IndexVar i1, IndexVar i2, size_t splitFactor,
+                            TailStrategy tailStrategy) const {
+  taco_uassert(tailStrategy != TailStrategy::Peel)
+      << "Divided index variables cannot be peeled, since every block of a "
+      << "divide may extend past the end of the index variable";
+  IndexVarRel rel = IndexVarRel(new DivideRelNode(i, i1, i2, splitFactor,
+                                                  tailStrategy));
   string reason;
 
   // Add predicate to concrete index notation.
@@ -1854,6 +1861,92 @@ IndexStmt IndexStmt::divide(IndexVar i, IndexVar i1, IndexVar i2, size_t splitFa
   return transformed;
 }
 
+/// Get the sizes of the tiles of every level of a tiling of a statement, such
+/// that the tiles of the tensors that the statement accesses fit in the data
+/// cache that corresponds to the level. The innermost level corresponds to L1.
+static vector<size_t> getCacheTileSizes(IndexStmt stmt, size_t numVars,
+                                        size_t levels) {
+  set<TensorVar> tensors;
+  size_t componentBytes = 1;
+  match(stmt,
+    function<void(const AccessNode*)>([&](const AccessNode* op) {
+      tensors.insert(op->tensorVar);
+      componentBytes = std::max(componentBytes,
+          (size_t)op->tensorVar.getType().getDataType().getNumBytes());
+    })
+  );
+
+  // The tiles of tensors that are accessed by more than two of the tiled index
+  // variables are assumed to be two-dimensional slices of the tiles
+  const size_t tileOrder = std::min(numVars, (size_t)2);
+  vector<size_t> sizes(levels);
+  for (size_t level = 0; level < levels; level++) {
+    const int cacheLevel = (int)(levels - level);
+    size_t cacheBytes = util::getCacheSize(cacheLevel);
+    if (cacheBytes == 0) {
+      cacheBytes = (size_t)32768 << (3 * (cacheLevel - 1));
+    }
+    const size_t tileBytes = tensors.size() * componentBytes;
+    size_t size = 1;
+    while (tileBytes * (tileOrder == 2 ? 4 * size * size : 2 * size) <=
+           cacheBytes) {
+      size *= 2;
+    }
+    sizes[level] = (level > 0) ? std::min(size, sizes[level - 1]) : size;
+  }
+  return sizes;
+}
+
+IndexStmt IndexStmt::tile(std::vector<IndexVar> vars,
+                          std::vector<std::vector<IndexVar>> tiledVars,
+                          std::vector<size_t> sizes) const {
+  taco_uassert(!vars.empty() && vars.size() == tiledVars.size())
+      << "Every tiled index variable must be given the index variables of its "
+      << "tiles";
+  const size_t levels = tiledVars[0].size() - 1;
+  for (auto& varTiles : tiledVars) {
+    taco_uassert(varTiles.size() >= 2 && varTiles.size() == levels + 1)
+        << "Every tiled index variable must be given the index variables of "
+        << "the same number of levels of tiles";
+  }
+  if (sizes.empty()) {
+    sizes = getCacheTileSizes(*this, vars.size(), levels);
+  }
+  taco_uassert(sizes.size() == levels)
+      << "Tiling " << levels << " levels requires " << levels << " tile sizes";
+  for (size_t level = 1; level < levels; level++) {
+    taco_uassert(sizes[level] > 0 && sizes[level - 1] % sizes[level] == 0)
+        << "The size of the tiles of a level must be a multiple of the size "
+        << "of the tiles of the next level";
+  }
+
+  // Strip-mine every index variable into its levels, where the inner variable
+  // of every split but the last is split further
+  IndexStmt transformed = *this;
+  for (size_t k = 0; k < vars.size(); k++) {
+    IndexVar var = vars[k];
+    for (size_t level = 0; level < levels; level++) {
+      IndexVar inner = (level + 1 == levels)
+                       ? tiledVars[k][levels]
+                       : IndexVar(tiledVars[k][levels].getName() + "_" +
+                                  util::toString(level));
+      transformed = transformed.split(var, tiledVars[k][level], inner,
+                                      sizes[level]);
+      var = inner;
+    }
+  }
+
+  // Nest the loops over the tiles of every level inside the loops over the
+  // tiles of the level before it
+  vector<IndexVar> reordered;
+  for (size_t level = 0; level <= levels; level++) {
+    for (auto& varTiles : tiledVars) {
+      reordered.push_back(varTiles[level]);
+    }
+  }
+  return transformed.reorder(reordered);
+}
+
 IndexStmt IndexStmt::precompute(IndexExpr expr, std::vector<IndexVar> i_vars,
                                 std::vector<IndexVar> iw_vars, TensorVar workspace) const {
 
@@ -2017,7 +2110,9 @@ IndexStmt IndexStmt::unroll(IndexVar i, size_t unrollFactor) const {
 
     void visit(const ForallNode* node) {
       if (node->indexVar == i) {
-        stmt = Forall(i, rewrite(node->stmt), node->parallel_unit, node->output_race_strategy, unrollFactor);
+        ForallAnnotations annotations = node->annotations;
+        annotations.unrollFactor = unrollFactor;
+        stmt = Forall(i, rewrite(node->stmt), node->parallel_unit, node->output_race_strategy, annotations);
       }
       else {
         IndexNotationRewriter::visit(node);
@@ -2027,6 +2122,105 @@ IndexStmt IndexStmt::unroll(IndexVar i, size_t unrollFactor) const {
   return UnrollLoop(i, unrollFactor).rewrite(*this);
 }
 
+IndexStmt IndexStmt::unrollReduction(IndexVar i, size_t accumulators) const {
+  taco_uassert(accumulators > 1)
+      << "Reductions must be split into more than one accumulator";
+
+  bool hasLoop = false;
+  struct UnrollReduction : IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+    IndexVar i;
+    size_t accumulators;
+    bool* hasLoop;
+    UnrollReduction(IndexVar i, size_t accumulators, bool* hasLoop)
+        : i(i), accumulators(accumulators), hasLoop(hasLoop) {}
+
+    void visit(const ForallNode* node) {
+      if (node->indexVar == i) {
+        *hasLoop = true;
+        ForallAnnotations annotations = node->annotations;
+        annotations.accumulators = accumulators;
+        stmt = Forall(i, rewrite(node->stmt), node->parallel_unit,
+                      node->output_race_strategy, annotations);
+      }
+      else {
+        IndexNotationRewriter::visit(node);
+      }
+    }
+  };
+  IndexStmt transformed = UnrollReduction(i, accumulators,
+                                          &hasLoop).rewrite(*this);
+  taco_uassert(hasLoop) << "The statement has no loop over " << i;
+  return transformed;
+}
+
+IndexStmt IndexStmt::prefetch(IndexVar i, Access access, size_t distance) const {
+  taco_uassert(distance > 0) << "The prefetch distance must be positive";
+
+  bool readsAccess = false;
+  struct PrefetchLoop : IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+    IndexVar i;
+    TensorVar tensor;
+    size_t distance;
+    bool* readsAccess;
+    PrefetchLoop(IndexVar i, TensorVar tensor, size_t distance,
+                 bool* readsAccess)
+        : i(i), tensor(tensor), distance(distance), readsAccess(readsAccess) {}
+
+    void visit(const ForallNode* node) {
+      if (node->indexVar == i) {
+        match(node->stmt,
+          function<void(const AccessNode*)>([&](const AccessNode* op) {
+            *readsAccess = *readsAccess || op->tensorVar == tensor;
+          })
+        );
+        ForallAnnotations annotations = node->annotations;
+        annotations.prefetches[tensor] = distance;
+        stmt = Forall(i, node->stmt, node->parallel_unit,
+                      node->output_race_strategy, annotations);
+      }
+      else {
+        IndexNotationRewriter::visit(node);
+      }
+    }
+  };
+  IndexStmt transformed = PrefetchLoop(i, access.getTensorVar(), distance,
+                                       &readsAccess).rewrite(*this);
+  taco_uassert(readsAccess) << "The loop over " << i << " does not read "
+                            << access.getTensorVar().getName();
+  return transformed;
+}
+
+IndexStmt IndexStmt::mergeby(IndexVar i, MergeStrategy strategy) const {
+  bool hasLoop = false;
+  struct SetMergeStrategy : IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+    IndexVar i;
+    MergeStrategy strategy;
+    bool* hasLoop;
+    SetMergeStrategy(IndexVar i, MergeStrategy strategy, bool* hasLoop)
+        : i(i), strategy(strategy), hasLoop(hasLoop) {}
+
+    void visit(const ForallNode* node) {
+      if (node->indexVar == i) {
+        *hasLoop = true;
+        ForallAnnotations annotations = node->annotations;
+        annotations.mergeStrategy = strategy;
+        stmt = Forall(i, rewrite(node->stmt), node->parallel_unit,
+                      node->output_race_strategy, annotations);
+      }
+      else {
+        IndexNotationRewriter::visit(node);
+      }
+    }
+  };
+  IndexStmt transformed = SetMergeStrategy(i, strategy,
+                                           &hasLoop).rewrite(*this);
+  taco_uassert(hasLoop) << "The statement has no loop over " << i;
+  return transformed;
+}
+
 IndexStmt IndexStmt::assemble(TensorVar result, AssembleStrategy strategy,
                               bool separatelySchedulable) const {
   string reason;
@@ -2125,6 +2319,19 @@ IndexExpr Yield::getExpr() const {
 }
 
 
+// struct ForallAnnotations
+bool operator==(const ForallAnnotations& a, const ForallAnnotations& b) {
+  return a.unrollFactor == b.unrollFactor &&
+         a.prefetches == b.prefetches &&
+         a.mergeStrategy == b.mergeStrategy &&
+         a.accumulators == b.accumulators;
+}
+
+bool operator!=(const ForallAnnotations& a, const ForallAnnotations& b) {
+  return !(a == b);
+}
+
+
 // class Forall
 Forall::Forall(const ForallNode* n) : IndexStmt(n) {
 }
@@ -2137,6 +2344,13 @@ Forall::Forall(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit, Ou
         : Forall(new ForallNode(indexVar, stmt, parallel_unit, output_race_strategy, unrollFactor)) {
 }
 
+Forall::Forall(IndexVar indexVar, IndexStmt stmt, ParallelUnit parallel_unit,
+               OutputRaceStrategy output_race_strategy,
+               const ForallAnnotations& annotations)
+    : Forall(new ForallNode(indexVar, stmt, parallel_unit, output_race_strategy,
+                            annotations)) {
+}
+
 IndexVar Forall::getIndexVar() const {
   return getNode(*this)->indexVar;
 }
@@ -2153,8 +2367,24 @@ OutputRaceStrategy Forall::getOutputRaceStrategy() const {
   return getNode(*this)->output_race_strategy;
 }
 
+const ForallAnnotations& Forall::getAnnotations() const {
+  return getNode(*this)->annotations;
+}
+
 size_t Forall::getUnrollFactor() const {
-  return getNode(*this)->unrollFactor;
+  return getNode(*this)->annotations.unrollFactor;
+}
+
+const std::map<TensorVar,size_t>& Forall::getPrefetches() const {
+  return getNode(*this)->annotations.prefetches;
+}
+
+MergeStrategy Forall::getMergeStrategy() const {
+  return getNode(*this)->annotations.mergeStrategy;
+}
+
+size_t Forall::getAccumulators() const {
+  return getNode(*this)->annotations.accumulators;
 }
 
 Forall forall(IndexVar i, IndexStmt stmt) {
@@ -2165,6 +2395,12 @@ Forall forall(IndexVar i, IndexStmt stmt, ParallelUnit parallel_unit, OutputRace
   return Forall(i, stmt, parallel_unit, output_race_strategy, unrollFactor);
 }
 
+Forall forall(IndexVar i, IndexStmt stmt, ParallelUnit parallel_unit,
+              OutputRaceStrategy output_race_strategy,
+              const ForallAnnotations& annotations) {
+  return Forall(i, stmt, parallel_unit, output_race_strategy, annotations);
+}
+
 template <> bool isa<Forall>(IndexStmt s) {
   return isa<ForallNode>(s.ptr);
 }
@@ -3943,7 +4179,7 @@ private:
       stmt = op;
     }
     else {
-      stmt = new ForallNode(op->indexVar, body, op->parallel_unit, op->output_race_strategy, op->unrollFactor);
+      stmt = new ForallNode(op->indexVar, body, op->parallel_unit, op->output_race_strategy, op->annotations);
     }
   }
 
@@ -185,7 +185,7 @@ void IndexNotationRewriter::visit(const ForallNode* op) {
     stmt = op;
   }
   else {
-    stmt = new ForallNode(op->indexVar, s, op->parallel_unit, op->output_race_strategy, op->unrollFactor);
+    stmt = new ForallNode(op->indexVar, s, op->parallel_unit, op->output_race_strategy, op->annotations);
   }
 }
 
@@ -407,7 +407,7 @@ struct ReplaceIndexVars : public IndexNotationRewriter {
     }
     else {
       stmt = new ForallNode(iv, s, op->parallel_unit, op->output_race_strategy, 
-                            op->unrollFactor);
+                            op->annotations);
     }
   }
 
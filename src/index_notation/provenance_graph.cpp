@@ -120,14 +120,17 @@ struct SplitRelNode::Content {
   IndexVar outerVar;
   IndexVar innerVar;
   size_t splitFactor;
+  TailStrategy tailStrategy;
 };
 
-SplitRelNode::SplitRelNode(IndexVar parentVar, IndexVar outerVar, IndexVar innerVar, size_t splitFactor)
+SplitRelNode::SplitRelNode(IndexVar parentVar, IndexVar outerVar, IndexVar innerVar, size_t splitFactor,
+                           TailStrategy tailStrategy)
   : IndexVarRelNode(SPLIT), content(new Content) {
   content->parentVar = parentVar;
   content->outerVar = outerVar;
   content->innerVar = innerVar;
   content->splitFactor = splitFactor;
+  content->tailStrategy = tailStrategy;
 }
 
 const IndexVar& SplitRelNode::getParentVar() const {
@@ -142,14 +145,22 @@ const IndexVar& SplitRelNode::getInnerVar() const {
 const size_t& SplitRelNode::getSplitFactor() const {
   return content->splitFactor;
 }
+TailStrategy SplitRelNode::getTailStrategy() const {
+  return content->tailStrategy;
+}
 
 void SplitRelNode::print(std::ostream &stream) const {
-  stream << "split(" << getParentVar() << ", " << getOuterVar() << ", " << getInnerVar() << ", " << getSplitFactor() << ")";
+  stream << "split(" << getParentVar() << ", " << getOuterVar() << ", " << getInnerVar() << ", " << getSplitFactor();
+  if (getTailStrategy() != TailStrategy::Guard) {
+    stream << ", " << TailStrategy_NAMES[(int)getTailStrategy()];
+  }
+  stream << ")";
 }
 
 bool SplitRelNode::equals(const SplitRelNode &rel) const {
   return getParentVar() == rel.getParentVar() && getOuterVar() == rel.getOuterVar()
-        && getInnerVar() == rel.getInnerVar() && getSplitFactor() == rel.getSplitFactor();
+        && getInnerVar() == rel.getInnerVar() && getSplitFactor() == rel.getSplitFactor()
+        && getTailStrategy() == rel.getTailStrategy();
 }
 
 std::vector<IndexVar> SplitRelNode::getParents() const {
@@ -271,14 +282,18 @@ struct DivideRelNode::Content {
   IndexVar outerVar;
   IndexVar innerVar;
   size_t divFactor;
+  TailStrategy tailStrategy;
 };
 
-DivideRelNode::DivideRelNode(IndexVar parentVar, IndexVar outerVar, IndexVar innerVar, size_t divFactor)
+DivideRelNode::DivideRelNode(IndexVar parentVar, IndexVar outerVar, IndexVar innerVar, size_t divFactor,
+                             TailStrategy tailStrategy)
   : IndexVarRelNode(DIVIDE), content(new Content) {
+  taco_iassert(tailStrategy != TailStrategy::Peel);
   content->parentVar = parentVar;
   content->outerVar = outerVar;
   content->innerVar = innerVar;
   content->divFactor = divFactor;
+  content->tailStrategy = tailStrategy;
 }
 
 const IndexVar& DivideRelNode::getParentVar() const {
@@ -293,14 +308,22 @@ const IndexVar& DivideRelNode::getInnerVar() const {
 const size_t& DivideRelNode::getDivFactor() const {
   return content->divFactor;
 }
+TailStrategy DivideRelNode::getTailStrategy() const {
+  return content->tailStrategy;
+}
 
 void DivideRelNode::print(std::ostream &stream) const {
-  stream << "divide(" << getParentVar() << ", " << getOuterVar() << ", " << getInnerVar() << ", " << getDivFactor() << ")";
+  stream << "divide(" << getParentVar() << ", " << getOuterVar() << ", " << getInnerVar() << ", " << getDivFactor();
+  if (getTailStrategy() != TailStrategy::Guard) {
+    stream << ", " << TailStrategy_NAMES[(int)getTailStrategy()];
+  }
+  stream << ")";
 }
 
 bool DivideRelNode::equals(const DivideRelNode &rel) const {
   return getParentVar() == rel.getParentVar() && getOuterVar() == rel.getOuterVar() &&
-    getInnerVar() == rel.getInnerVar() && getDivFactor() == rel.getDivFactor();
+    getInnerVar() == rel.getInnerVar() && getDivFactor() == rel.getDivFactor() &&
+    getTailStrategy() == rel.getTailStrategy();
 }
 
 std::vector<IndexVar> DivideRelNode::getParents() const {
@@ -1419,4 +1442,19 @@ bool ProvenanceGraph::isDivided(IndexVar indexVar) const {
   return false;
 }
 
+TailStrategy ProvenanceGraph::getTailStrategy(IndexVar indexVar) const {
+  if (isUnderived(indexVar)) {
+    return TailStrategy::Guard;
+  }
+  IndexVarRel rel = parentRelMap.at(indexVar);
+  switch (rel.getRelType()) {
+    case SPLIT:
+      return rel.getNode<SplitRelNode>()->getTailStrategy();
+    case DIVIDE:
+      return rel.getNode<DivideRelNode>()->getTailStrategy();
+    default:
+      return TailStrategy::Guard;
+  }
+}
+
 }
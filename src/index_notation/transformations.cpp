@@ -5,10 +5,14 @@
 #include "taco/index_notation/index_notation_nodes.h"
 #include "taco/error/error_messages.h"
 #include "taco/util/collections.h"
+#include "taco/util/env.h"
 #include "taco/lower/iterator.h"
 #include "taco/lower/merge_lattice.h"
 #include "taco/lower/mode.h"
 #include "taco/lower/mode_format_impl.h"
+#include "taco/ir/ir.h"
+#include "taco/ir/ir_generators.h"
+#include "taco/tensor.h"
 
 #include <iostream>
 #include <algorithm>
@@ -687,6 +691,15 @@ OutputRaceStrategy Parallelize::getOutputRaceStrategy() const {
   return content->output_race_strategy;
 }
 
+// Bytes that the private copies of the results of a loop parallelized with the
+// temporary output race strategy may use on CPUs, which can be set with the
+// TACO_PRIVATIZATION_BUDGET environment variable
+static size_t getPrivatizationBudget() {
+  const string budget = util::getFromEnv("TACO_PRIVATIZATION_BUDGET", "");
+  return budget.empty() ? (64u << 20)
+                        : (size_t)std::strtoull(budget.c_str(), nullptr, 10);
+}
+
 IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
   INIT_REASON(reason);
 
@@ -697,9 +710,11 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
     ProvenanceGraph provGraph;
     map<TensorVar,ir::Expr> tensorVars;
     vector<ir::Expr> assembledByUngroupedInsert;
+    vector<TensorVar> temporaries;
     set<IndexVar> definedIndexVars;
     set<IndexVar> reductionIndexVars;
     set<ParallelUnit> parentParallelUnits;
+    int loopDepth = 0;
     std::string reason = "";
 
     IndexStmt rewriteParallel(IndexStmt stmt) {
@@ -717,6 +732,7 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
       }
 
       tensorVars = createIRTensorVars(stmt);
+      temporaries = getTemporaries(stmt);
 
       assembledByUngroupedInsert.clear();
       for (const auto& result : getAssembledByUngroupedInsertion(stmt)) {
@@ -741,6 +757,17 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
           return;
         }
 
+        // Tasks run on whichever thread steals them and can be nested, so
+        // their results cannot be privatized per thread
+        if (parallelize.getParallelUnit() == ParallelUnit::CPUTask &&
+            (parallelize.getOutputRaceStrategy() == OutputRaceStrategy::Temporary ||
+             parallelize.getOutputRaceStrategy() == OutputRaceStrategy::ParallelReduction)) {
+          reason = "Precondition failed: Loops parallelized over CPU tasks "
+                   "must use the NoRaces, IgnoreRaces, or Atomics output race "
+                   "strategies";
+          return;
+        }
+
         Iterators iterators(foralli, tensorVars);
         MergeLattice lattice = MergeLattice::make(foralli, iterators, provGraph, 
                                                   definedIndexVars);
@@ -798,6 +825,68 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
           }
         }
 
+        if (parallelize.getOutputRaceStrategy() == OutputRaceStrategy::MergePath) {
+          // Rows reduce into scalars that are stored into the results once
+          // the rows are summed, which threads that end in the middle of a
+          // row carry out to be added after the loop instead
+          IndexStmt body = foralli.getStmt();
+          if (loopDepth == 0) {
+            IndexStmt promoted = scalarPromote(foralli, provGraph, true, true);
+            body = to<Forall>(promoted).getStmt();
+          }
+          if (parallelize.getParallelUnit() != ParallelUnit::CPUThread ||
+              loopDepth != 0 || util::contains(reductionIndexVars, i) ||
+              !canPartitionByMergePath(foralli, body, iterators)) {
+            reason = "Precondition failed: Loops partitioned by merge path "
+                     "must be parallelized over CPU threads and compute one "
+                     "component of a dense result per row by summing over the "
+                     "nonzeros of a compressed level under a dense level that "
+                     "the loop iterates over";
+            return;
+          }
+          stmt = forall(i, body, parallelize.getParallelUnit(),
+                        parallelize.getOutputRaceStrategy(),
+                        foralli.getAnnotations());
+          return;
+        }
+
+        if (parallelize.getOutputRaceStrategy() == OutputRaceStrategy::Temporary &&
+            parallelize.getParallelUnit() == ParallelUnit::CPUThread &&
+            util::contains(reductionIndexVars, underivedForall.getIndexVar())) {
+          // Every thread reduces into its own copy of the results, which are
+          // summed into the results after the loop, unless the copies would
+          // use more memory than the budget allows or cannot be privatized
+          OutputRaceStrategy strategy = canPrivatize(foralli.getStmt())
+                                        ? OutputRaceStrategy::Temporary
+                                        : OutputRaceStrategy::Atomics;
+          IndexStmt body = foralli.getStmt();
+          if (strategy == OutputRaceStrategy::Atomics) {
+            body = scalarPromote(body, provGraph, false, true);
+          }
+          stmt = forall(i, body, parallelize.getParallelUnit(), strategy,
+                        foralli.getAnnotations());
+          return;
+        }
+
+        if (parallelize.getOutputRaceStrategy() == OutputRaceStrategy::ParallelReduction &&
+            parallelize.getParallelUnit() == ParallelUnit::CPUThread &&
+            util::contains(reductionIndexVars, underivedForall.getIndexVar())) {
+          // Scalar results are promoted to accumulators that the loop is
+          // annotated to reduce into with reduction clauses
+          if (!canReduceInClauses(foralli.getStmt())) {
+            reason = "Precondition failed: Loops parallelized with parallel "
+                     "reductions on CPU threads must only reduce into scalars "
+                     "with operators that OpenMP can reduce with";
+            return;
+          }
+          IndexStmt body = scalarPromote(foralli.getStmt(), provGraph,
+                                         false, true);
+          stmt = forall(i, body, parallelize.getParallelUnit(),
+                        parallelize.getOutputRaceStrategy(),
+                        foralli.getAnnotations());
+          return;
+        }
+
         if (parallelize.getOutputRaceStrategy() == OutputRaceStrategy::Temporary &&
             util::contains(reductionIndexVars, underivedForall.getIndexVar())) {
           // Need to precompute reduction
@@ -819,7 +908,7 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
           );
           taco_iassert(!precomputeAssignments.empty());
 
-          IndexStmt precomputed_stmt = forall(i, foralli.getStmt(), parallelize.getParallelUnit(), parallelize.getOutputRaceStrategy(), foralli.getUnrollFactor());
+          IndexStmt precomputed_stmt = forall(i, foralli.getStmt(), parallelize.getParallelUnit(), parallelize.getOutputRaceStrategy(), foralli.getAnnotations());
           for (auto assignment : precomputeAssignments) {
             // Construct temporary of correct type and size of outer loop
             TensorVar w(string("w_") + ParallelUnit_NAMES[(int) parallelize.getParallelUnit()], Type(assignment->lhs.getDataType(), {Dimension(i)}), taco::dense);
@@ -854,19 +943,141 @@ IndexStmt Parallelize::apply(IndexStmt stmt, std::string* reason) const {
                                          false, true);
           stmt = forall(i, body, parallelize.getParallelUnit(), 
                         parallelize.getOutputRaceStrategy(), 
-                        foralli.getUnrollFactor());
+                        foralli.getAnnotations());
           return;
         }
 
 
-        stmt = forall(i, foralli.getStmt(), parallelize.getParallelUnit(), parallelize.getOutputRaceStrategy(), foralli.getUnrollFactor());
+        stmt = forall(i, foralli.getStmt(), parallelize.getParallelUnit(), parallelize.getOutputRaceStrategy(), foralli.getAnnotations());
         return;
       }
 
       if (foralli.getParallelUnit() != ParallelUnit::NotParallel) {
         parentParallelUnits.insert(foralli.getParallelUnit());
       }
+      loopDepth++;
       IndexNotationRewriter::visit(node);
+      loopDepth--;
+    }
+
+    // True iff the results that a loop body reduces into are scalars and are
+    // combined with an operator that lowers to one of the reduction operators
+    // of OpenMP, and that is not short-circuited by breaking out of the loop
+    bool canReduceInClauses(IndexStmt body) {
+      bool reducible = true;
+      match(body,
+        function<void(const AssignmentNode*)>([&](const AssignmentNode* op) {
+          if (!op->op.defined()) {
+            return;
+          }
+          const TensorVar result = op->lhs.getTensorVar();
+          if (result.getOrder() != 0 ||
+              result.getType().getDataType().isComplex()) {
+            reducible = false;
+          }
+          else if (isa<CallNode>(op->op.ptr)) {
+            Call call = to<Call>(op->op);
+            Datatype type = result.getType().getDataType();
+            ir::Expr var = ir::Var::make(result.getName(), type);
+            ir::Expr val = ir::Var::make(result.getName() + "_val", type);
+            reducible = reducible &&
+                !findProperty<Annihilator>(call.getProperties()).defined() &&
+                !ir::getReductionOperator(var, call.getFunc()({var, val})).empty();
+          }
+          else if (!isa<AddNode>(op->op.ptr)) {
+            reducible = false;
+          }
+        })
+      );
+      return reducible;
+    }
+
+    // True iff a loop body declares a scalar that it sums the nonzeros of a
+    // compressed level into and then stores into a dense result, where the
+    // parent of the compressed level is a dense top level that the loop
+    // iterates over
+    bool canPartitionByMergePath(Forall foralli, IndexStmt body,
+                                 const Iterators& iterators) {
+      if (!isa<Where>(body)) {
+        return false;
+      }
+      Where where = to<Where>(body);
+      TensorVar temporary = where.getTemporary();
+      if (temporary.getOrder() != 0 || !isa<Assignment>(where.getConsumer()) ||
+          !isa<Forall>(where.getProducer())) {
+        return false;
+      }
+      Assignment consumer = to<Assignment>(where.getConsumer());
+      TensorVar result = consumer.getLhs().getTensorVar();
+      if (consumer.getOperator().defined() || result.getOrder() == 0 ||
+          !isDense(result.getFormat()) || util::contains(temporaries, result) ||
+          !isa<Access>(consumer.getRhs()) ||
+          !(to<Access>(consumer.getRhs()).getTensorVar() == temporary)) {
+        return false;
+      }
+
+      Forall forallj = to<Forall>(where.getProducer());
+      if (!isa<Assignment>(forallj.getStmt())) {
+        return false;
+      }
+      Assignment producer = to<Assignment>(forallj.getStmt());
+      if (!(producer.getLhs().getTensorVar() == temporary) ||
+          !isa<AddNode>(producer.getOperator().ptr) ||
+          !provGraph.isUnderived(foralli.getIndexVar()) ||
+          !provGraph.isUnderived(forallj.getIndexVar())) {
+        return false;
+      }
+
+      MergeLattice lattice = MergeLattice::make(forallj, iterators, provGraph,
+                                                definedIndexVars);
+      if (lattice.iterators().size() != 1) {
+        return false;
+      }
+      Iterator iterator = lattice.iterators()[0];
+      return !iterator.isFull() && iterator.hasPosIter() &&
+             !iterator.getParent().isRoot() &&
+             iterator.getParent().isFull() &&
+             iterator.getParent().getParent().isRoot() &&
+             iterator.getParent().getIndexVar() == foralli.getIndexVar();
+    }
+
+    // True iff the results that a loop body reduces into are dense tensors
+    // that are not temporaries and are only added to, and if the copies of
+    // them for every thread fit in the privatization budget
+    bool canPrivatize(IndexStmt body) {
+      bool privatizable = true;
+      set<TensorVar> privatized;
+      match(body,
+        function<void(const AssignmentNode*)>([&](const AssignmentNode* op) {
+          if (!op->op.defined()) {
+            return;
+          }
+          TensorVar result = op->lhs.getTensorVar();
+          if (!isa<AddNode>(op->op.ptr) || result.getOrder() == 0 ||
+              util::contains(temporaries, result) ||
+              !isDense(result.getFormat())) {
+            privatizable = false;
+          }
+          privatized.insert(result);
+        })
+      );
+      if (!privatizable) {
+        return false;
+      }
+
+      double bytes = 0.0;
+      for (const auto& result : privatized) {
+        double size = (double)result.getType().getDataType().getNumBytes();
+        for (const auto& dimension : result.getType().getShape()) {
+          if (!dimension.isFixed()) {
+            return false;
+          }
+          size *= (double)dimension.getSize();
+        }
+        bytes += size;
+      }
+      bytes *= (double)std::max(taco_get_num_threads(), 1);
+      return bytes <= (double)getPrivatizationBudget();
     }
   };
 
@@ -1027,7 +1238,7 @@ IndexStmt SetAssembleStrategy::apply(IndexStmt stmt, string* reason) const {
         stmt = op;
       } else if (s.defined()) {
         stmt = Forall(op->indexVar, s, op->parallel_unit, 
-                      op->output_race_strategy, op->unrollFactor);
+                      op->output_race_strategy, op->annotations);
       } else {
         stmt = IndexStmt();
       }
@@ -1298,7 +1509,7 @@ IndexStmt SetAssembleStrategy::apply(IndexStmt stmt, string* reason) const {
         stmt = op;
       } else if (s.defined()) {
         stmt = new ForallNode(op->indexVar, s, op->parallel_unit, 
-                              op->output_race_strategy, op->unrollFactor);
+                              op->output_race_strategy, op->annotations);
       } else {
         stmt = IndexStmt();
       }
@@ -1383,13 +1594,101 @@ IndexStmt parallelizeOuterLoop(IndexStmt stmt) {
   else {
     IndexStmt parallelized = Parallelize(forall.getIndexVar(), ParallelUnit::CPUThread, OutputRaceStrategy::NoRaces).apply(stmt, &reason);
     if (parallelized == IndexStmt()) {
-      // can't parallelize
-      return stmt;
+      // can't parallelize without races
+      if (taco_get_num_threads() > 1) {
+        // Loops that reduce into dense results are parallelized if the results
+        // can be privatized
+        IndexStmt privatized = Parallelize(forall.getIndexVar(),
+                                           ParallelUnit::CPUThread,
+                                           OutputRaceStrategy::Temporary)
+                               .apply(stmt, &reason);
+        bool isPrivatized = false;
+        match(privatized,
+          function<void(const ForallNode*)>([&](const ForallNode* node) {
+            isPrivatized = isPrivatized ||
+                node->output_race_strategy == OutputRaceStrategy::Temporary;
+          })
+        );
+        if (isPrivatized) {
+          return privatized;
+        }
+
+        // Loops that reduce into scalars are parallelized with reduction
+        // clauses
+        IndexStmt reduced = Parallelize(forall.getIndexVar(),
+                                        ParallelUnit::CPUThread,
+                                        OutputRaceStrategy::ParallelReduction)
+                            .apply(stmt, &reason);
+        if (reduced.defined()) {
+          return reduced;
+        }
+      }
+      return parallelizeAssembly(stmt);
     }
     return parallelized;
   }
 }
 
+IndexStmt parallelizeAssembly(IndexStmt stmt) {
+  const vector<TensorVar> results = getResults(stmt);
+  if (taco_get_num_threads() <= 1 || should_use_CUDA_codegen() ||
+      isa<Assemble>(stmt) || results.size() != 1) {
+    return stmt;
+  }
+  TensorVar result = results[0];
+  const auto modeFormats = result.getFormat().getModeFormats();
+  if (!util::any(modeFormats, [](const ModeFormat& modeFormat) {
+        return modeFormat.hasSeqInsertEdge();
+      })) {
+    return stmt;
+  }
+
+  string reason;
+  IndexStmt assembled = SetAssembleStrategy(result, AssembleStrategy::Insert,
+                                            true).apply(stmt, &reason);
+  if (!assembled.defined() || !isa<Assemble>(assembled)) {
+    return stmt;
+  }
+
+  // Returns the index variable of the outermost forall of a statement
+  auto getOuterIndexVar = [](IndexStmt stmt) {
+    IndexVar indexVar;
+    bool matched = false;
+    match(stmt,
+      function<void(const ForallNode*)>([&](const ForallNode* node) {
+        if (!matched) indexVar = node->indexVar;
+        matched = true;
+      })
+    );
+    return make_pair(indexVar, matched);
+  };
+
+  // The numeric phase inserts into the fibers that the symbolic phase counted
+  // the nonzeros of, so it must be parallelized for the assembly to pay off
+  auto computeVar = getOuterIndexVar(assembled.as<Assemble>().getCompute());
+  if (!computeVar.second) {
+    return stmt;
+  }
+  IndexStmt parallelized = Parallelize(computeVar.first, ParallelUnit::CPUThread,
+                                       OutputRaceStrategy::NoRaces)
+                           .apply(assembled, &reason);
+  if (!parallelized.defined()) {
+    return stmt;
+  }
+
+  auto queryVar = getOuterIndexVar(parallelized.as<Assemble>().getQueries());
+  if (queryVar.second) {
+    IndexStmt parallelQueries = Parallelize(queryVar.first,
+                                            ParallelUnit::CPUThread,
+                                            OutputRaceStrategy::NoRaces)
+                                .apply(parallelized, &reason);
+    if (parallelQueries.defined()) {
+      parallelized = parallelQueries;
+    }
+  }
+  return parallelized;
+}
+
 // Takes in a set of pairs of IndexVar and level for a given tensor and orders
 // the IndexVars by tensor level
 static vector<pair<IndexVar, bool>> 
@@ -1486,7 +1785,18 @@ topologicallySort(map<IndexVar,set<IndexVar>> hardDeps,
 }
 
 
-IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
+// The first contiguous section of foralls of a statement, and the constraints
+// that the tensors accessed in it place on the order of those foralls
+struct LoopNest {
+  vector<IndexVar> originalOrder;
+  IndexStmt innerBody;
+  map<IndexVar, ParallelUnit> forallParallelUnit;
+  map<IndexVar, OutputRaceStrategy> forallOutputRaceStrategy;
+  map<IndexVar, set<IndexVar>> hardDeps;
+  map<IndexVar, multiset<IndexVar>> softDeps;
+};
+
+static LoopNest getLoopNest(IndexStmt stmt) {
   // Collect tensorLevelVars which stores the pairs of IndexVar and tensor
   // level that each tensor is accessed at
   struct DAGBuilder : public IndexNotationVisitor {
@@ -1556,7 +1866,6 @@ IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
     tensorVarOrders[tensorLevelVar.first] = 
         varOrderFromTensorLevels(tensorLevelVar.second);
   }
-  const auto hardDeps = depsFromVarOrders(tensorVarOrders);
 
   struct CollectSoftDependencies : public IndexNotationVisitor {
     using IndexNotationVisitor::visit;
@@ -1580,9 +1889,20 @@ IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
   CollectSoftDependencies collectSoftDeps;
   stmt.accept(&collectSoftDeps);
 
-  const auto sortedVars = topologicallySort(hardDeps, collectSoftDeps.softDeps, 
-                                            dagBuilder.indexVarOriginalOrder);
+  LoopNest loopNest;
+  loopNest.originalOrder = dagBuilder.indexVarOriginalOrder;
+  loopNest.innerBody = dagBuilder.innerBody;
+  loopNest.forallParallelUnit = dagBuilder.forallParallelUnit;
+  loopNest.forallOutputRaceStrategy = dagBuilder.forallOutputRaceStrategy;
+  loopNest.hardDeps = depsFromVarOrders(tensorVarOrders);
+  loopNest.softDeps = collectSoftDeps.softDeps;
+  return loopNest;
+}
 
+// Replace the first contiguous section of foralls with foralls in the given
+// order
+static IndexStmt reorderLoopNest(IndexStmt stmt, const LoopNest& loopNest,
+                                 const vector<IndexVar>& sortedVars) {
   // Reorder Foralls use a rewriter in case new nodes introduced outside of Forall
   struct TopoReorderRewriter : public IndexNotationRewriter {
     using IndexNotationRewriter::visit;
@@ -1613,11 +1933,20 @@ IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
     }
 
   };
-  TopoReorderRewriter rewriter(sortedVars, dagBuilder.innerBody, 
-                               dagBuilder.forallParallelUnit, dagBuilder.forallOutputRaceStrategy);
+  TopoReorderRewriter rewriter(sortedVars, loopNest.innerBody,
+                               loopNest.forallParallelUnit,
+                               loopNest.forallOutputRaceStrategy);
   return rewriter.rewrite(stmt);
 }
 
+IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
+  LoopNest loopNest = getLoopNest(stmt);
+  const auto sortedVars = topologicallySort(loopNest.hardDeps,
+                                            loopNest.softDeps,
+                                            loopNest.originalOrder);
+  return reorderLoopNest(stmt, loopNest, sortedVars);
+}
+
 IndexStmt scalarPromote(IndexStmt stmt, ProvenanceGraph provGraph, 
                         bool isWholeStmt, bool promoteScalar) {
   std::map<Access,const ForallNode*> hoistLevel;
@@ -1754,7 +2083,7 @@ IndexStmt scalarPromote(IndexStmt stmt, ProvenanceGraph provGraph,
       }
 
       stmt = forall(i, body, foralli.getParallelUnit(),
-                    foralli.getOutputRaceStrategy(), foralli.getUnrollFactor());
+                    foralli.getOutputRaceStrategy(), foralli.getAnnotations());
       for (const auto& consumer : consumers) {
         stmt = where(consumer, stmt);
       }
@@ -1886,4 +2215,980 @@ IndexStmt insertTemporaries(IndexStmt stmt)
   return stmt;
 }
 
+static bool isDense(TensorVar tensorVar) {
+  for (auto& modeFormat : tensorVar.getFormat().getModeFormats()) {
+    if (!modeFormat.isFull()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// True iff the tensors accessed by a producer can be accessed at a point of
+/// its free variables, that is, if the levels that the free variables index
+/// are full levels above every other level.
+static bool isLocatable(Assignment producer) {
+  const auto freeVars = producer.getFreeVars();
+  bool locatable = true;
+  match(producer.getRhs(),
+    function<void(const AccessNode*)>([&](const AccessNode* op) {
+      const Format format = op->tensorVar.getFormat();
+      const vector<ModeFormat> modeFormats = format.getModeFormats();
+      bool aboveFreeVar = false;
+      for (int level = (int)modeFormats.size() - 1; level >= 0; level--) {
+        const IndexVar var = op->indexVars[format.getModeOrdering()[level]];
+        if (util::contains(freeVars, var)) {
+          aboveFreeVar = true;
+          if (!modeFormats[level].isFull()) {
+            locatable = false;
+          }
+        }
+        else if (aboveFreeVar) {
+          locatable = false;
+        }
+      }
+    })
+  );
+  return locatable;
+}
+
+IndexStmt fuseAssignments(Assignment consumer,
+                          const map<TensorVar,Assignment>& producers) {
+  struct FuseProducers : public IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+
+    const map<TensorVar,Assignment>& producers;
+    vector<IndexVar> loopVars;
+    bool fused = false;
+
+    FuseProducers(const map<TensorVar,Assignment>& producers)
+        : producers(producers) {}
+
+    void visit(const ForallNode* node) {
+      loopVars.push_back(node->indexVar);
+      IndexNotationRewriter::visit(node);
+      loopVars.pop_back();
+    }
+
+    /// Returns the access through which a producer can be fused into an
+    /// assignment, or an undefined access. Every access to the producer must
+    /// be the same, and must be indexed by all the loops around the
+    /// assignment so that each value of the producer is computed once.
+    Access getFusableAccess(Assignment assignment, TensorVar producer) {
+      const AccessNode* fusableNode = nullptr;
+      bool isFusable = true;
+      match(assignment.getRhs(),
+        function<void(const AccessNode*)>([&](const AccessNode* op) {
+          if (!(op->tensorVar == producer)) {
+            return;
+          }
+          Access access(op);
+          if (access.hasWindowedModes() || access.hasIndexSetModes() ||
+              (fusableNode != nullptr &&
+               fusableNode->indexVars != access.getIndexVars())) {
+            isFusable = false;
+          }
+          fusableNode = op;
+        })
+      );
+      if (!isFusable || fusableNode == nullptr) {
+        return Access();
+      }
+      Access fusable(fusableNode);
+      const auto indexVars = fusable.getIndexVars();
+      if (util::toSet(indexVars).size() != indexVars.size() ||
+          util::toSet(indexVars) != util::toSet(loopVars)) {
+        return Access();
+      }
+
+      Assignment producerAssignment = producers.at(producer);
+      if (producerAssignment.getOperator().defined() ||
+          producerAssignment.getLhs().hasWindowedModes() ||
+          producerAssignment.getLhs().hasIndexSetModes() ||
+          !isLocatable(producerAssignment) ||
+          util::contains(getArguments(producerAssignment), producer)) {
+        return Access();
+      }
+      return fusable;
+    }
+
+    /// Compute the producer at the point of the access into a scalar.
+    IndexStmt getProducerStmt(Access access, TensorVar temporary) {
+      Assignment producer = producers.at(access.getTensorVar());
+      vector<IndexVar> freeVars = producer.getLhs().getIndexVars();
+
+      IndexStmt stmt = makeConcreteNotation(producer);
+      for (size_t i = 0; i < freeVars.size(); i++) {
+        taco_iassert(isa<Forall>(stmt) &&
+                     to<Forall>(stmt).getIndexVar() == freeVars[i]);
+        stmt = to<Forall>(stmt).getStmt();
+      }
+
+      // The free variables of the producer become the variables of the
+      // access, and its reduction variables become new variables
+      map<IndexVar,IndexVar> substitutions;
+      for (size_t i = 0; i < freeVars.size(); i++) {
+        substitutions.insert({freeVars[i], access.getIndexVars()[i]});
+      }
+      for (auto& var : stmt.getIndexVars()) {
+        if (!util::contains(substitutions, var)) {
+          substitutions.insert({var, IndexVar()});
+        }
+      }
+      stmt = replace(stmt, substitutions);
+
+      struct ReplaceResult : public IndexNotationRewriter {
+        using IndexNotationRewriter::visit;
+        TensorVar result;
+        TensorVar temporary;
+        void visit(const AssignmentNode* node) {
+          if (node->lhs.getTensorVar() == result) {
+            stmt = Assignment(temporary, {}, node->rhs, node->op);
+          }
+          else {
+            stmt = node;
+          }
+        }
+      };
+      ReplaceResult replaceResult;
+      replaceResult.result = access.getTensorVar();
+      replaceResult.temporary = temporary;
+      return replaceResult.rewrite(stmt);
+    }
+
+    void visit(const AssignmentNode* node) {
+      Assignment assignment(node);
+
+      // The producers' values replace accesses of the assignment, so the
+      // assignment must iterate over every value regardless of the others
+      bool accessesDense = isDense(assignment.getLhs().getTensorVar());
+      match(assignment.getRhs(),
+        function<void(const AccessNode*)>([&](const AccessNode* op) {
+          accessesDense = accessesDense && isDense(op->tensorVar);
+        })
+      );
+      if (!accessesDense) {
+        stmt = node;
+        return;
+      }
+
+      map<IndexExpr,IndexExpr> substitutions;
+      vector<IndexStmt> producerStmts;
+      for (auto& argument : getArguments(assignment)) {
+        if (!util::contains(producers, argument)) {
+          continue;
+        }
+        Access access = getFusableAccess(assignment, argument);
+        if (!access.defined()) {
+          continue;
+        }
+        TensorVar temporary(argument.getName() + "_val",
+                            Type(argument.getType().getDataType()));
+        producerStmts.push_back(rewrite(getProducerStmt(access, temporary)));
+        match(assignment.getRhs(),
+          function<void(const AccessNode*)>([&](const AccessNode* op) {
+            if (op->tensorVar == argument) {
+              substitutions.insert({op, Access(temporary)});
+            }
+          })
+        );
+      }
+      if (producerStmts.empty()) {
+        stmt = node;
+        return;
+      }
+
+      fused = true;
+      stmt = Assignment(assignment.getLhs(),
+                        replace(assignment.getRhs(), substitutions),
+                        assignment.getOperator());
+      for (auto& producerStmt : producerStmts) {
+        stmt = where(stmt, producerStmt);
+      }
+    }
+  };
+
+  FuseProducers fuseProducers(producers);
+  IndexStmt stmt = fuseProducers.rewrite(
+      makeConcreteNotation(makeReductionNotation(consumer)));
+  return fuseProducers.fused ? stmt : IndexStmt();
+}
+
+
+// Cost model of the autoscheduler
+
+// Density assumed for sparse tensors without statistics
+static const double defaultDensity = 0.01;
+
+// Size assumed for dimensions that are not known at compile time
+static const double defaultDimension = 1000.0;
+
+// Cost of a strided access to a dense level relative to a contiguous access
+static const double stridePenalty = 4.0;
+
+// Deepest loop nest for which every loop order is considered
+static const size_t maxAutoscheduleLoops = 6;
+
+static double getDimension(const TensorVar& tensor, int level) {
+  int mode = tensor.getFormat().getModeOrdering()[level];
+  Dimension dimension = tensor.getType().getShape().getDimension(mode);
+  return dimension.isFixed() ? (double)dimension.getSize() : defaultDimension;
+}
+
+// The number of coordinates stored in each level of a tensor
+static vector<double>
+getLevelSizes(const TensorVar& tensor,
+              const map<TensorVar,TensorStatistics>& statistics) {
+  vector<double> levelSizes;
+  if (util::contains(statistics, tensor) &&
+      statistics.at(tensor).levelSizes.size() == (size_t)tensor.getOrder()) {
+    for (size_t levelSize : statistics.at(tensor).levelSizes) {
+      levelSizes.push_back(std::max((double)levelSize, 1.0));
+    }
+    return levelSizes;
+  }
+
+  // Assume the nonzeros of the tensor are uniformly distributed
+  const Format& format = tensor.getFormat();
+  double denseSize = 1.0;
+  for (int level = 0; level < tensor.getOrder(); level++) {
+    denseSize *= getDimension(tensor, level);
+  }
+  double nnz = isDense(format) ? denseSize
+                               : std::max(denseSize * defaultDensity, 1.0);
+  double levelSize = 1.0;
+  for (int level = 0; level < tensor.getOrder(); level++) {
+    levelSize *= getDimension(tensor, level);
+    if (!format.getModeFormats()[level].isFull()) {
+      levelSize = std::min(levelSize, nnz);
+    }
+    levelSizes.push_back(levelSize);
+  }
+  return levelSizes;
+}
+
+// The storage level of an access that is indexed by i, or -1 if none is
+static int getLevel(const Access& access, IndexVar i) {
+  const auto& modeOrdering = access.getTensorVar().getFormat().getModeOrdering();
+  for (size_t level = 0; level < modeOrdering.size(); level++) {
+    if (access.getIndexVars()[modeOrdering[level]] == i) {
+      return (int)level;
+    }
+  }
+  return -1;
+}
+
+// Estimate the number of iterations of a forall over i, given the index
+// variables of the loops that enclose it. Sparse levels that are intersected
+// are co-iterated until the shortest fiber is exhausted, while dense levels and
+// unions iterate over the whole dimension. Returns infinity if a sparse level
+// is iterated before the levels above it.
+static double getTripCount(IndexVar i, IndexStmt body,
+                           const set<IndexVar>& bound,
+                           const map<TensorVar,TensorStatistics>& statistics) {
+  double denseSize = 0.0;
+  double resultSize = 0.0;
+  double sparseSum = 0.0;
+  double sparseMin = numeric_limits<double>::infinity();
+  bool isUnion = false;
+  bool isDiscordant = false;
+  match(body,
+    function<void(const AssignmentNode*)>([&](const AssignmentNode* op) {
+      int resultLevel = getLevel(op->lhs, i);
+      if (resultLevel >= 0) {
+        resultSize = std::max(resultSize,
+                              getDimension(op->lhs.getTensorVar(), resultLevel));
+      }
+      match(op->rhs,
+        function<void(const AccessNode*)>([&](const AccessNode* node) {
+          Access access(node);
+          int level = getLevel(access, i);
+          if (level < 0) {
+            return;
+          }
+          TensorVar tensor = access.getTensorVar();
+          if (tensor.getFormat().getModeFormats()[level].isFull()) {
+            denseSize = std::max(denseSize, getDimension(tensor, level));
+            return;
+          }
+          const auto& modeOrdering = tensor.getFormat().getModeOrdering();
+          for (int parent = 0; parent < level; parent++) {
+            if (!util::contains(bound,
+                                access.getIndexVars()[modeOrdering[parent]])) {
+              isDiscordant = true;
+            }
+          }
+          vector<double> levelSizes = getLevelSizes(tensor, statistics);
+          double fiberLength = levelSizes[level] /
+                               (level > 0 ? levelSizes[level-1] : 1.0);
+          sparseSum += fiberLength;
+          sparseMin = std::min(sparseMin, fiberLength);
+        }),
+        function<void(const AddNode*)>([&](const AddNode*) {
+          isUnion = true;
+        }),
+        function<void(const SubNode*)>([&](const SubNode*) {
+          isUnion = true;
+        })
+      );
+    })
+  );
+
+  if (isDiscordant) {
+    return numeric_limits<double>::infinity();
+  }
+  if (sparseSum == 0.0) {
+    return denseSize > 0.0 ? denseSize
+                           : (resultSize > 0.0 ? resultSize : 1.0);
+  }
+  if (isUnion) {
+    return denseSize > 0.0 ? denseSize : sparseSum;
+  }
+  return sparseMin;
+}
+
+// The relative cost of an access made in the loop over innermost, which is
+// higher if it strides over a dense level that is not the last level of the
+// tensor.
+static double getAccessCost(const Access& access, IndexVar innermost) {
+  int level = getLevel(access, innermost);
+  const Format& format = access.getTensorVar().getFormat();
+  if (level < 0 || level == access.getTensorVar().getOrder() - 1) {
+    return 1.0;
+  }
+  for (int child = level; child < access.getTensorVar().getOrder(); child++) {
+    if (!format.getModeFormats()[child].isFull()) {
+      return 1.0;
+    }
+  }
+  return stridePenalty;
+}
+
+static double getCost(IndexStmt stmt, double iterations,
+                      set<IndexVar> bound, IndexVar innermost,
+                      const map<TensorVar,TensorStatistics>& statistics) {
+  if (isa<Forall>(stmt)) {
+    Forall forall = to<Forall>(stmt);
+    IndexVar i = forall.getIndexVar();
+    double tripCount = getTripCount(i, forall.getStmt(), bound, statistics);
+    bound.insert(i);
+    double cost = iterations * tripCount +
+                  getCost(forall.getStmt(), iterations * tripCount, bound, i,
+                          statistics);
+    if (forall.getParallelUnit() == ParallelUnit::CPUThread) {
+      cost /= std::max(taco_get_num_threads(), 1);
+    }
+    return cost;
+  }
+  if (isa<Assignment>(stmt)) {
+    Assignment assignment = to<Assignment>(stmt);
+    double cost = getAccessCost(assignment.getLhs(), innermost);
+    match(assignment.getRhs(),
+      function<void(const AccessNode*)>([&](const AccessNode* node) {
+        cost += getAccessCost(Access(node), innermost);
+      })
+    );
+    return iterations * cost;
+  }
+  if (isa<Where>(stmt)) {
+    Where where = to<Where>(stmt);
+    // Workspaces must be cleared each time the where statement executes
+    TensorVar temporary = where.getTemporary();
+    double clearCost = 0.0;
+    if (temporary.getOrder() > 0) {
+      clearCost = iterations;
+      for (int level = 0; level < temporary.getOrder(); level++) {
+        clearCost *= getDimension(temporary, level);
+      }
+    }
+    return clearCost +
+           getCost(where.getConsumer(), iterations, bound, innermost,
+                   statistics) +
+           getCost(where.getProducer(), iterations, bound, innermost,
+                   statistics);
+  }
+  if (isa<Sequence>(stmt)) {
+    Sequence sequence = to<Sequence>(stmt);
+    return getCost(sequence.getDefinition(), iterations, bound, innermost,
+                   statistics) +
+           getCost(sequence.getMutation(), iterations, bound, innermost,
+                   statistics);
+  }
+  if (isa<Multi>(stmt)) {
+    Multi multi = to<Multi>(stmt);
+    return getCost(multi.getStmt1(), iterations, bound, innermost,
+                   statistics) +
+           getCost(multi.getStmt2(), iterations, bound, innermost,
+                   statistics);
+  }
+  if (isa<SuchThat>(stmt)) {
+    return getCost(to<SuchThat>(stmt).getStmt(), iterations, bound, innermost,
+                   statistics);
+  }
+  return 0.0;
+}
+
+double estimateCost(IndexStmt stmt,
+                    const map<TensorVar,TensorStatistics>& statistics) {
+  return getCost(stmt, 1.0, {}, IndexVar(), statistics);
+}
+
+// Check whether a statement scatters into a result that can only be appended
+// to, i.e. whether a reduction loop encloses a loop over a result level.
+static bool scattersIntoAppendOnlyResult(IndexStmt stmt) {
+  struct FindScatter : public IndexNotationVisitor {
+    using IndexNotationVisitor::visit;
+
+    vector<IndexVar> loops;
+    bool scatters = false;
+
+    void visit(const ForallNode* node) {
+      loops.push_back(node->indexVar);
+      IndexNotationVisitor::visit(node);
+      loops.pop_back();
+    }
+
+    void visit(const AssignmentNode* node) {
+      const Format& format = node->lhs.getTensorVar().getFormat();
+      bool appendOnly = false;
+      for (const auto& modeFormat : format.getModeFormats()) {
+        appendOnly = appendOnly || !modeFormat.hasInsert();
+      }
+      if (!appendOnly) {
+        return;
+      }
+      const auto& resultVars = node->lhs.getIndexVars();
+      bool reduced = false;
+      for (const auto& loop : loops) {
+        if (!util::contains(resultVars, loop)) {
+          reduced = true;
+        } else if (reduced) {
+          scatters = true;
+        }
+      }
+    }
+  };
+  FindScatter findScatter;
+  stmt.accept(&findScatter);
+  return findScatter.scatters;
+}
+
+// Enumerate the orders of the loops of a loop nest in which every loop comes
+// after the loops that it depends on
+static void getLegalOrders(const LoopNest& loopNest,
+                           vector<IndexVar>& order,
+                           vector<vector<IndexVar>>* orders) {
+  if (order.size() == loopNest.originalOrder.size()) {
+    orders->push_back(order);
+    return;
+  }
+  for (const auto& var : loopNest.originalOrder) {
+    if (util::contains(order, var)) {
+      continue;
+    }
+    bool free = true;
+    if (util::contains(loopNest.hardDeps, var)) {
+      for (const auto& dep : loopNest.hardDeps.at(var)) {
+        free = free && util::contains(order, dep);
+      }
+    }
+    if (free) {
+      order.push_back(var);
+      getLegalOrders(loopNest, order, orders);
+      order.pop_back();
+    }
+  }
+}
+
+vector<vector<IndexVar>> getLegalLoopOrders(IndexStmt stmt) {
+  LoopNest loopNest = getLoopNest(stmt);
+  const auto sortedVars = topologicallySort(loopNest.hardDeps,
+                                            loopNest.softDeps,
+                                            loopNest.originalOrder);
+  vector<vector<IndexVar>> orders = {sortedVars};
+  if (loopNest.originalOrder.size() > maxAutoscheduleLoops) {
+    return orders;
+  }
+
+  vector<IndexVar> order;
+  vector<vector<IndexVar>> legalOrders;
+  getLegalOrders(loopNest, order, &legalOrders);
+  for (const auto& legalOrder : legalOrders) {
+    if (legalOrder != sortedVars) {
+      orders.push_back(legalOrder);
+    }
+  }
+  return orders;
+}
+
+IndexStmt applyLoopOrder(IndexStmt stmt, const vector<IndexVar>& order) {
+  LoopNest loopNest = getLoopNest(stmt);
+  if (order.size() != loopNest.originalOrder.size()) {
+    return IndexStmt();
+  }
+  for (const auto& var : order) {
+    if (!util::contains(loopNest.originalOrder, var)) {
+      return IndexStmt();
+    }
+  }
+
+  IndexStmt reordered = reorderLoopNest(stmt, loopNest, order);
+  IndexStmt scheduled = insertTemporaries(reordered);
+  if (scheduled == reordered && scattersIntoAppendOnlyResult(scheduled)) {
+    return IndexStmt();
+  }
+  return scheduled;
+}
+
+IndexStmt autoschedule(IndexStmt stmt,
+                       const map<TensorVar,TensorStatistics>& statistics) {
+  // The topological order is always legal, so it is kept unless another
+  // order is estimated to be strictly cheaper.
+  IndexStmt best = reorderLoopsTopologically(stmt);
+  best = parallelizeOuterLoop(insertTemporaries(best));
+  double bestCost = estimateCost(best, statistics);
+
+  vector<vector<IndexVar>> orders = getLegalLoopOrders(stmt);
+  for (size_t i = 1; i < orders.size(); i++) {
+    IndexStmt candidate = applyLoopOrder(stmt, orders[i]);
+    if (!candidate.defined()) {
+      continue;
+    }
+    candidate = parallelizeOuterLoop(candidate);
+    double cost = estimateCost(candidate, statistics);
+    if (cost < bestCost) {
+      best = candidate;
+      bestCost = cost;
+    }
+  }
+  return best;
+}
+
+
+// Contraction order optimization
+
+// Most factors of a product for which every contraction order is considered
+static const size_t maxContractionFactors = 8;
+
+// Collect the accesses multiplied by an expression that consists of products
+// and sums over reduction variables. Returns false if the expression has any
+// other form.
+static bool getFactors(IndexExpr expr, vector<const AccessNode*>* factors) {
+  if (isa<AccessNode>(expr.ptr)) {
+    factors->push_back(to<AccessNode>(expr.ptr));
+    return true;
+  }
+  if (isa<MulNode>(expr.ptr)) {
+    const MulNode* mul = to<MulNode>(expr.ptr);
+    return getFactors(mul->a, factors) && getFactors(mul->b, factors);
+  }
+  if (isa<ReductionNode>(expr.ptr)) {
+    const ReductionNode* reduction = to<ReductionNode>(expr.ptr);
+    return isa<AddNode>(reduction->op.ptr) && getFactors(reduction->a, factors);
+  }
+  return false;
+}
+
+namespace {
+/// A contraction of a subset of the factors of a product, which is computed
+/// into a dense temporary unless it is the whole product.
+struct ContractionPlan {
+  double cost = numeric_limits<double>::infinity();
+  unsigned left = 0;
+  unsigned right = 0;
+  vector<IndexVar> indexVars;  // The index variables of the temporary
+  double density = 1.0;
+};
+}
+
+IndexStmt optimizeContractionOrder(Assignment assignment,
+                          const map<TensorVar,TensorStatistics>& statistics) {
+  vector<const AccessNode*> factors;
+  TensorVar result = assignment.getLhs().getTensorVar();
+  if (assignment.getOperator().defined() || !isDense(result) ||
+      !getFactors(assignment.getRhs(), &factors) || factors.size() < 3 ||
+      factors.size() > maxContractionFactors) {
+    return IndexStmt();
+  }
+
+  // The dimension of every index variable and the density of every factor
+  map<IndexVar,double> dimensions;
+  vector<double> densities;
+  for (auto& factor : factors) {
+    if (factor->tensorVar == result || !factor->windowedModes.empty() ||
+        !factor->indexSetModes.empty()) {
+      return IndexStmt();
+    }
+    double size = 1.0;
+    for (size_t mode = 0; mode < factor->indexVars.size(); mode++) {
+      Dimension dimension = factor->tensorVar.getType().getShape()
+                                                   .getDimension(mode);
+      if (!dimension.isFixed() ||
+          util::contains(set<IndexVar>(factor->indexVars.begin(),
+                                       factor->indexVars.begin() + mode),
+                         factor->indexVars[mode])) {
+        return IndexStmt();
+      }
+      dimensions[factor->indexVars[mode]] = (double)dimension.getSize();
+      size *= (double)dimension.getSize();
+    }
+    vector<double> levelSizes = getLevelSizes(factor->tensorVar, statistics);
+    densities.push_back(levelSizes.empty()
+                        ? 1.0 : std::min(levelSizes.back() / size, 1.0));
+  }
+  const vector<IndexVar>& resultVars = assignment.getLhs().getIndexVars();
+
+  // Returns the index variables of the factors in a subset in the order that
+  // they are first accessed
+  auto getIndexVars = [&](unsigned subset) {
+    vector<IndexVar> indexVars;
+    for (size_t k = 0; k < factors.size(); k++) {
+      if (subset & (1u << k)) {
+        for (auto& indexVar : factors[k]->indexVars) {
+          if (!util::contains(indexVars, indexVar)) {
+            indexVars.push_back(indexVar);
+          }
+        }
+      }
+    }
+    return indexVars;
+  };
+
+  // Find the cheapest contraction of every subset of the factors. The cost of
+  // a contraction is the number of iterations of its loop nest, which iterates
+  // over the nonzeros of sparse factors and over the whole of the dense
+  // temporaries that hold earlier contractions, plus the cost of clearing its
+  // temporary.
+  const unsigned all = (1u << factors.size()) - 1;
+  vector<ContractionPlan> plans(all + 1);
+  auto getFactor = [](unsigned subset) {
+    size_t k = 0;
+    while (!(subset & (1u << k))) {
+      k++;
+    }
+    return k;
+  };
+  for (unsigned subset = 1; subset <= all; subset++) {
+    ContractionPlan& plan = plans[subset];
+    if ((subset & (subset - 1)) == 0) {
+      plan.cost = 0.0;
+      plan.indexVars = factors[getFactor(subset)]->indexVars;
+      plan.density = densities[getFactor(subset)];
+      continue;
+    }
+
+    // Index variables that are read outside the subset are kept
+    double size = 1.0;
+    for (auto& indexVar : getIndexVars(subset)) {
+      if (util::contains(resultVars, indexVar) ||
+          util::contains(getIndexVars(all & ~subset), indexVar)) {
+        plan.indexVars.push_back(indexVar);
+        size *= dimensions.at(indexVar);
+      }
+    }
+
+    for (unsigned left = (subset - 1) & subset; left > 0;
+         left = (left - 1) & subset) {
+      // The first factor is kept on the left to not consider a split twice
+      unsigned right = subset & ~left;
+      if (!(left & (subset & (~subset + 1)))) {
+        continue;
+      }
+      set<IndexVar> loopVars(plans[left].indexVars.begin(),
+                             plans[left].indexVars.end());
+      loopVars.insert(plans[right].indexVars.begin(),
+                      plans[right].indexVars.end());
+      double iterations = plans[left].density * plans[right].density;
+      for (auto& indexVar : loopVars) {
+        iterations *= dimensions.at(indexVar);
+      }
+      double cost = plans[left].cost + plans[right].cost + iterations +
+                    (subset != all ? size : 0.0);
+      if (cost < plan.cost) {
+        plan.cost = cost;
+        plan.left = left;
+        plan.right = right;
+      }
+    }
+  }
+
+  // Build a loop nest for every contraction, which writes its temporary before
+  // the contractions that read it
+  vector<IndexStmt> producers;
+  function<IndexExpr(unsigned)> contract = [&](unsigned subset) -> IndexExpr {
+    const ContractionPlan& plan = plans[subset];
+    if (plan.left == 0) {
+      return Access(factors[getFactor(subset)]);
+    }
+    IndexExpr expr = contract(plan.left) * contract(plan.right);
+    if (subset == all) {
+      return expr;
+    }
+    vector<Dimension> shape;
+    for (auto& indexVar : plan.indexVars) {
+      shape.push_back(Dimension((size_t)dimensions.at(indexVar)));
+    }
+    TensorVar temporary("t" + util::toString(producers.size()) + "_" +
+                        util::join(plan.indexVars, ""),
+                        Type(result.getType().getDataType(), Shape(shape)),
+                        Format(vector<ModeFormatPack>(shape.size(), dense)));
+    Assignment producer(temporary, plan.indexVars, expr);
+    producers.push_back(reorderLoopsTopologically(
+        makeConcreteNotation(makeReductionNotation(producer))));
+    return Access(temporary, plan.indexVars);
+  };
+  Assignment consumer(result, resultVars, contract(all));
+  IndexStmt contracted = reorderLoopsTopologically(
+      makeConcreteNotation(makeReductionNotation(consumer)));
+  for (auto it = producers.rbegin(); it != producers.rend(); ++it) {
+    contracted = where(contracted, *it);
+  }
+
+  // Keep the single loop nest unless the contractions are estimated to be
+  // cheaper
+  IndexStmt single = autoschedule(
+      makeConcreteNotation(makeReductionNotation(assignment)), statistics);
+  if (estimateCost(contracted, statistics) >= estimateCost(single, statistics)) {
+    return IndexStmt();
+  }
+  return contracted;
+}
+
+
+// Algebraic rewriting
+
+// True iff an expression is a literal zero
+static bool isZeroLiteral(IndexExpr expr) {
+  return isa<LiteralNode>(expr.ptr) &&
+         equals(expr, Literal::zero(expr.getDataType()));
+}
+
+// The index variables that an expression accesses
+static set<IndexVar> getAccessedIndexVars(IndexExpr expr) {
+  set<IndexVar> indexVars;
+  match(expr,
+    function<void(const AccessNode*)>([&](const AccessNode* op) {
+      indexVars.insert(op->indexVars.begin(), op->indexVars.end());
+    })
+  );
+  return indexVars;
+}
+
+// Flatten a tree of multiplications into its factors
+static void getProductFactors(IndexExpr expr, vector<IndexExpr>* factors) {
+  if (isa<MulNode>(expr.ptr)) {
+    getProductFactors(to<MulNode>(expr.ptr)->a, factors);
+    getProductFactors(to<MulNode>(expr.ptr)->b, factors);
+    return;
+  }
+  factors->push_back(expr);
+}
+
+static IndexExpr makeProduct(const vector<IndexExpr>& factors) {
+  IndexExpr product = factors[0];
+  for (size_t k = 1; k < factors.size(); k++) {
+    product = product * factors[k];
+  }
+  return product;
+}
+
+namespace {
+/// A term of a sum, which is subtracted if it is negated.
+struct SumTerm {
+  IndexExpr expr;
+  bool negated;
+};
+}
+
+// Flatten a tree of additions and subtractions into its terms
+static void getSumTerms(IndexExpr expr, bool negated, vector<SumTerm>* terms) {
+  if (isa<AddNode>(expr.ptr)) {
+    getSumTerms(to<AddNode>(expr.ptr)->a, negated, terms);
+    getSumTerms(to<AddNode>(expr.ptr)->b, negated, terms);
+    return;
+  }
+  if (isa<SubNode>(expr.ptr)) {
+    getSumTerms(to<SubNode>(expr.ptr)->a, negated, terms);
+    getSumTerms(to<SubNode>(expr.ptr)->b, !negated, terms);
+    return;
+  }
+  terms->push_back({expr, negated});
+}
+
+static IndexExpr makeSum(const vector<SumTerm>& terms) {
+  IndexExpr sum = terms[0].negated ? -terms[0].expr : terms[0].expr;
+  for (size_t k = 1; k < terms.size(); k++) {
+    sum = terms[k].negated ? sum - terms[k].expr : sum + terms[k].expr;
+  }
+  return sum;
+}
+
+// Factor the factor that most products among the terms of a sum share out of
+// them, and repeat until no products share a factor
+static IndexExpr factorSum(const vector<SumTerm>& terms) {
+  vector<vector<IndexExpr>> factors(terms.size());
+  for (size_t k = 0; k < terms.size(); k++) {
+    getProductFactors(terms[k].expr, &factors[k]);
+  }
+
+  // Terms that are not products are kept whole, since factoring them out
+  // would add a dense literal one to the sum
+  auto find = [](const vector<IndexExpr>& factors, IndexExpr factor) {
+    for (size_t k = 0; k < factors.size(); k++) {
+      if (equals(factors[k], factor)) {
+        return (int)k;
+      }
+    }
+    return -1;
+  };
+  IndexExpr common;
+  size_t commonCount = 1;
+  for (size_t k = 0; k < terms.size(); k++) {
+    for (auto& factor : (factors[k].size() > 1 ? factors[k]
+                                                : vector<IndexExpr>())) {
+      size_t count = 0;
+      for (auto& termFactors : factors) {
+        if (termFactors.size() > 1 && find(termFactors, factor) >= 0) {
+          count++;
+        }
+      }
+      if (count > commonCount) {
+        common = factor;
+        commonCount = count;
+      }
+    }
+  }
+  if (!common.defined()) {
+    return makeSum(terms);
+  }
+
+  vector<SumTerm> remainders;
+  vector<SumTerm> factored;
+  for (size_t k = 0; k < terms.size(); k++) {
+    int position = (factors[k].size() > 1) ? find(factors[k], common) : -1;
+    if (position < 0) {
+      factored.push_back(terms[k]);
+      continue;
+    }
+    factors[k].erase(factors[k].begin() + position);
+    remainders.push_back({makeProduct(factors[k]), terms[k].negated});
+  }
+  factored.insert(factored.begin(), {common * factorSum(remainders), false});
+  return factorSum(factored);
+}
+
+IndexStmt simplifyAlgebraically(IndexStmt stmt) {
+  struct SimplifyAlgebraically : public IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+
+    void visit(const AddNode* op) {
+      visitSum(op);
+    }
+
+    void visit(const SubNode* op) {
+      visitSum(op);
+    }
+
+    void visitSum(const IndexExprNode* op) {
+      vector<SumTerm> terms;
+      getSumTerms(op, false, &terms);
+      vector<SumTerm> nonzero;
+      for (auto& term : terms) {
+        IndexExpr rewritten = rewrite(term.expr);
+        if (!isZeroLiteral(rewritten)) {
+          nonzero.push_back({rewritten, term.negated});
+        }
+      }
+      expr = nonzero.empty() ? Literal::zero(op->getDataType())
+                             : factorSum(nonzero);
+    }
+
+    // Products with a zero factor are only zero for integer and boolean
+    // components, since NaN and infinite floating-point values times zero are
+    // NaN
+    void visit(const MulNode* op) {
+      IndexNotationRewriter::visit(op);
+      if (op->getDataType().isFloat() || op->getDataType().isComplex()) {
+        return;
+      }
+      vector<IndexExpr> factors;
+      getProductFactors(expr, &factors);
+      for (auto& factor : factors) {
+        if (isZeroLiteral(factor)) {
+          expr = Literal::zero(op->getDataType());
+          return;
+        }
+      }
+    }
+
+    void visit(const CallNode* op) {
+      IndexNotationRewriter::visit(op);
+      if (!isa<CallNode>(expr.ptr)) {
+        return;
+      }
+      const CallNode* call = to<CallNode>(expr.ptr);
+      Annihilator annihilator = findProperty<Annihilator>(call->properties);
+      Identity identity = findProperty<Identity>(call->properties);
+      IndexExpr simplified;
+      if (annihilator.defined()) {
+        simplified = annihilator.annihilates(call->args);
+      }
+      if (!simplified.defined() && identity.defined()) {
+        simplified = identity.simplify(call->args);
+      }
+      if (simplified.defined()) {
+        expr = simplified;
+      }
+    }
+
+    // Factors of a sum reduction that do not depend on its variable are
+    // hoisted out of it, so that the reduction only multiplies the operands
+    // that it iterates over
+    void visit(const ReductionNode* op) {
+      IndexNotationRewriter::visit(op);
+      if (!isa<AddNode>(op->op.ptr) || !isa<ReductionNode>(expr.ptr)) {
+        return;
+      }
+      const ReductionNode* reduction = to<ReductionNode>(expr.ptr);
+      if (isZeroLiteral(reduction->a)) {
+        expr = reduction->a;
+        return;
+      }
+
+      vector<IndexExpr> factors;
+      getProductFactors(reduction->a, &factors);
+      vector<IndexExpr> invariant;
+      vector<IndexExpr> variant;
+      for (auto& factor : factors) {
+        if (util::contains(getAccessedIndexVars(factor), reduction->var)) {
+          variant.push_back(factor);
+        }
+        else {
+          invariant.push_back(factor);
+        }
+      }
+      if (invariant.empty() || variant.empty()) {
+        return;
+      }
+      invariant.push_back(Reduction(reduction->op, reduction->var,
+                                    makeProduct(variant)));
+      expr = makeProduct(invariant);
+    }
+  };
+
+  IndexStmt simplified = SimplifyAlgebraically().rewrite(stmt);
+
+  // Assignments whose right-hand side simplifies to a literal are kept, since
+  // the literal would not bind the variables of their loops
+  bool simplifiedToLiteral = false;
+  match(simplified,
+    function<void(const AssignmentNode*)>([&](const AssignmentNode* op) {
+      if (isa<LiteralNode>(op->rhs.ptr) && !op->lhs.getIndexVars().empty()) {
+        simplifiedToLiteral = true;
+      }
+    })
+  );
+  return simplifiedToLiteral ? stmt : simplified;
+}
+
 }
@@ -852,6 +852,15 @@ Stmt Sort::make(std::vector<Expr> args) {
 }
 
 
+// Prefetch
+Stmt Prefetch::make(Expr arr, Expr loc) {
+  Prefetch* prefetch = new Prefetch;
+  prefetch->arr = arr;
+  prefetch->loc = loc;
+  return prefetch;
+}
+
+
 // GetProperty
 Expr GetProperty::make(Expr tensor, TensorProperty property, int mode) {
   GetProperty* gp = new GetProperty;
@@ -996,6 +1005,8 @@ template<> void StmtNode<Sort>::accept(IRVisitorStrict *v)
   const { v->visit((const Sort*)this); }
 template<> void StmtNode<Break>::accept(IRVisitorStrict *v)
   const { v->visit((const Break*)this); }
+template<> void StmtNode<Prefetch>::accept(IRVisitorStrict *v)
+  const { v->visit((const Prefetch*)this); }
 
 // printing methods
 std::ostream& operator<<(std::ostream& os, const Stmt& stmt) {
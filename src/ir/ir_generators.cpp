@@ -20,6 +20,29 @@ Stmt compoundAssign(Expr a, Expr val, bool use_atomics, ParallelUnit atomic_para
   return Assign::make(a, add, use_atomics, atomic_parallel_unit);
 }
 
+std::string getReductionOperator(Expr var, Expr rhs) {
+  if (isa<Add>(rhs) && to<Add>(rhs)->a == var) {
+    return "+";
+  } else if (isa<Mul>(rhs) && to<Mul>(rhs)->a == var) {
+    return "*";
+  } else if (isa<Min>(rhs) && to<Min>(rhs)->operands.size() == 2 &&
+             to<Min>(rhs)->operands[0] == var) {
+    return "min";
+  } else if (isa<Max>(rhs) && to<Max>(rhs)->operands.size() == 2 &&
+             to<Max>(rhs)->operands[0] == var) {
+    return "max";
+  } else if (isa<And>(rhs) && to<And>(rhs)->a == var) {
+    return "&&";
+  } else if (isa<Or>(rhs) && to<Or>(rhs)->a == var) {
+    return "||";
+  } else if (isa<BitAnd>(rhs) && to<BitAnd>(rhs)->a == var) {
+    return "&";
+  } else if (isa<BitOr>(rhs) && to<BitOr>(rhs)->a == var) {
+    return "|";
+  }
+  return "";
+}
+
 Expr conjunction(std::vector<Expr> exprs) {
   taco_iassert(exprs.size() > 0) << "No expressions to and";
   Expr conjunction = exprs[0];
@@ -605,6 +605,18 @@ void IRPrinter::visit(const Sort* op) {
   stream << endl;
 }
 
+void IRPrinter::visit(const Prefetch* op) {
+  doIndent();
+  stream << "__builtin_prefetch(&";
+  parentPrecedence = Precedence::LOAD;
+  op->arr.accept(this);
+  stream << "[";
+  parentPrecedence = Precedence::LOAD;
+  op->loc.accept(this);
+  stream << "]);";
+  stream << endl;
+}
+
 
 void IRPrinter::resetNameCounters() {
   // seed the unique names with all C99 keywords
@@ -493,6 +493,17 @@ void IRRewriter::visit(const GetProperty* op) {
   }
 }
 
+void IRRewriter::visit(const Prefetch* op) {
+  Expr arr = rewrite(op->arr);
+  Expr loc = rewrite(op->loc);
+  if (arr == op->arr && loc == op->loc) {
+    stmt = op;
+  }
+  else {
+    stmt = Prefetch::make(arr, loc);
+  }
+}
+
 void IRRewriter::visit(const Sort* op) {
   std::vector<Expr> args;
   bool rewritten = false;
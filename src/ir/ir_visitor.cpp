@@ -249,5 +249,10 @@ void IRVisitor::visit(const Sort* op) {
     e.accept(this);
 }
 
+void IRVisitor::visit(const Prefetch* op) {
+  op->arr.accept(this);
+  op->loc.accept(this);
+}
+
 }  // namespace ir
 }  // namespace taco
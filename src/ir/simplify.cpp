@@ -1,7 +1,9 @@
 #include "taco/ir/simplify.h"
 
+#include <functional>
 #include <map>
 #include <queue>
+#include <set>
 
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_visitor.h"
@@ -380,6 +382,11 @@ ir::Stmt simplify(const ir::Stmt& stmt) {
     }
 
     void visit(const VarDecl* op) {
+      // Variables that are declared more than once cannot be propagated
+      // across their declarations
+      if (util::contains(defLevel, op->var)) {
+        loopDependentVars.insert(op->var);
+      }
       defLevel.insert({op->var, loopLevel});
     }
 
@@ -617,6 +624,9 @@ ir::Stmt simplify(const ir::Stmt& stmt) {
       void visit(const Sort *op) {
         stmt = Stmt();
       }
+      void visit(const Prefetch *op) {
+        stmt = Stmt();
+      }
       void visit(const Break *op) {
         stmt = Stmt();
       }
@@ -718,6 +728,377 @@ ir::Stmt simplify(const ir::Stmt& stmt) {
   };
   simplifiedStmt = RemoveRedundantLoops().rewrite(simplifiedStmt);
 
+  // The loop optimizations below declare new variables, which coroutines
+  // would have to save across yields.
+  struct FindYields : public IRVisitor {
+    bool hasYields = false;
+
+    using IRVisitor::visit;
+
+    void visit(const Yield* op) {
+      hasYields = true;
+    }
+  };
+  FindYields findYields;
+  simplifiedStmt.accept(&findYields);
+  if (findYields.hasYields) {
+    return simplifiedStmt;
+  }
+
+  // Identify the variables that a loop body declares or modifies.
+  struct FindModifiedVars : public IRVisitor {
+    std::set<Expr> modifiedVars;
+    std::map<Expr,int> numDecls;
+    std::set<Expr> assignedVars;
+
+    using IRVisitor::visit;
+
+    void visit(const VarDecl* op) {
+      modifiedVars.insert(op->var);
+      numDecls[op->var]++;
+      IRVisitor::visit(op);
+    }
+
+    void visit(const Assign* op) {
+      if (isa<Var>(op->lhs)) {
+        modifiedVars.insert(op->lhs);
+        assignedVars.insert(op->lhs);
+      }
+      IRVisitor::visit(op);
+    }
+
+    void visit(const For* op) {
+      modifiedVars.insert(op->var);
+      IRVisitor::visit(op);
+    }
+
+    void visit(const Allocate* op) {
+      if (isa<Var>(op->var)) {
+        modifiedVars.insert(op->var);
+        assignedVars.insert(op->var);
+      }
+      IRVisitor::visit(op);
+    }
+  };
+
+  // Check whether an expression can be computed ahead of a loop, which may
+  // not run at all, from the variables that are not modified by the loop.
+  // Loads, calls, and divisions are never computed ahead, since they may not
+  // be valid when the loop does not run. Tensor dimensions are not modified
+  // by kernels, but the other properties of tensors may be reallocated.
+  struct IsInvariant : public IRVisitor {
+    const std::set<Expr>& modifiedVars;
+    bool isInvariant = true;
+
+    using IRVisitor::visit;
+
+    IsInvariant(const std::set<Expr>& modifiedVars) :
+        modifiedVars(modifiedVars) {}
+
+    void visit(const Var* op) {
+      isInvariant = isInvariant && !util::contains(modifiedVars, op);
+    }
+    void visit(const Load* op) {
+      isInvariant = false;
+    }
+    void visit(const Call* op) {
+      isInvariant = false;
+    }
+    void visit(const Div* op) {
+      isInvariant = false;
+    }
+    void visit(const Rem* op) {
+      isInvariant = false;
+    }
+    void visit(const GetProperty* op) {
+      isInvariant = isInvariant && op->property == TensorProperty::Dimension;
+    }
+    void visit(const BinOp* op) {
+      isInvariant = false;
+    }
+    void visit(const Malloc* op) {
+      isInvariant = false;
+    }
+  };
+  auto isInvariant = [](Expr expr, const std::set<Expr>& modifiedVars) {
+    IsInvariant isInvariant(modifiedVars);
+    expr.accept(&isInvariant);
+    return isInvariant.isInvariant;
+  };
+
+  // Names of the scalar variables and tensor dimensions that variables
+  // introduced by the loop optimizations are named after.
+  static auto getName = [](Expr expr) -> std::string {
+    if (isa<Var>(expr) && !to<Var>(expr)->is_ptr) {
+      return to<Var>(expr)->name;
+    }
+    if (isa<GetProperty>(expr) &&
+        to<GetProperty>(expr)->property == TensorProperty::Dimension) {
+      return to<GetProperty>(expr)->name;
+    }
+    return "";
+  };
+
+  // Loop-invariant code motion. Declarations at the top level of a serial
+  // loop body that are computed from variables the loop does not modify are
+  // moved ahead of the loop, as are products of such variables in the other
+  // declarations of the loop body, e.g.
+  //
+  //   for (int j = 0; j < n; j++) {
+  //     int jA = i * A2_dimension + j;
+  //
+  // becomes
+  //
+  //   int i_A2_dimension = i * A2_dimension;
+  //   for (int j = 0; j < n; j++) {
+  //     int jA = i_A2_dimension + j;
+  struct HoistLoopInvariants : public IRRewriter {
+    std::function<bool(Expr, const std::set<Expr>&)> isInvariant;
+
+    using IRRewriter::visit;
+
+    struct HoistProducts : public IRRewriter {
+      std::function<bool(Expr)> isInvariant;
+      std::vector<Stmt> hoisted;
+
+      using IRRewriter::visit;
+
+      void visit(const Mul* op) {
+        if (!op->type.isInt() && !op->type.isUInt()) {
+          IRRewriter::visit(op);
+          return;
+        }
+        if ((isa<Literal>(op->a) && isa<Literal>(op->b)) ||
+            !isInvariant(op)) {
+          IRRewriter::visit(op);
+          return;
+        }
+        std::string name = "invariant";
+        if (!getName(op->a).empty() && !getName(op->b).empty()) {
+          name = getName(op->a) + "_" + getName(op->b);
+        }
+        expr = Var::make(name, op->type);
+        hoisted.push_back(VarDecl::make(expr, op));
+      }
+    };
+
+    Stmt hoist(Stmt contents, Expr loopVar, std::vector<Stmt>* hoisted) {
+      FindModifiedVars findModifiedVars;
+      contents.accept(&findModifiedVars);
+      std::set<Expr> modifiedVars = findModifiedVars.modifiedVars;
+      if (loopVar.defined()) {
+        modifiedVars.insert(loopVar);
+      }
+
+      bool isScope = isa<Scope>(contents);
+      Stmt body = isScope ? to<Scope>(contents)->scopedStmt : contents;
+      std::vector<Stmt> stmts;
+      std::function<void(Stmt)> flatten = [&](Stmt stmt) {
+        if (isa<Block>(stmt)) {
+          for (auto& content : to<Block>(stmt)->contents) {
+            flatten(content);
+          }
+        }
+        else {
+          stmts.push_back(stmt);
+        }
+      };
+      flatten(body);
+      std::vector<Stmt> remaining;
+      bool changed = false;
+      for (auto& stmt : stmts) {
+        const VarDecl* decl = stmt.as<VarDecl>();
+        if (decl == nullptr) {
+          remaining.push_back(stmt);
+          continue;
+        }
+        if (findModifiedVars.numDecls.at(decl->var) == 1 &&
+            !util::contains(findModifiedVars.assignedVars, decl->var) &&
+            isInvariant(decl->rhs, modifiedVars)) {
+          hoisted->push_back(stmt);
+          modifiedVars.erase(decl->var);
+          changed = true;
+          continue;
+        }
+        HoistProducts hoistProducts;
+        hoistProducts.isInvariant = [&](Expr expr) {
+          return isInvariant(expr, modifiedVars);
+        };
+        Expr rhs = hoistProducts.rewrite(decl->rhs);
+        if (rhs != decl->rhs) {
+          util::append(*hoisted, hoistProducts.hoisted);
+          remaining.push_back(VarDecl::make(decl->var, rhs));
+          changed = true;
+          continue;
+        }
+        remaining.push_back(stmt);
+      }
+      if (!changed) {
+        return contents;
+      }
+      body = Block::make(remaining);
+      return isScope ? Scope::make(body) : body;
+    }
+
+    void visit(const For* op) {
+      IRRewriter::visit(op);
+      if (op->kind != LoopKind::Serial ||
+          op->parallel_unit != ParallelUnit::NotParallel) {
+        return;
+      }
+      const For* loop = stmt.as<For>();
+      std::vector<Stmt> hoisted;
+      Stmt contents = hoist(loop->contents, loop->var, &hoisted);
+      if (hoisted.empty()) {
+        return;
+      }
+      stmt = Block::make(Block::make(hoisted),
+                         For::make(loop->var, loop->start, loop->end,
+                                   loop->increment, contents, loop->kind,
+                                   loop->parallel_unit, loop->unrollFactor,
+                                   loop->vec_width));
+    }
+
+    void visit(const While* op) {
+      IRRewriter::visit(op);
+      if (op->kind != LoopKind::Serial) {
+        return;
+      }
+      const While* loop = stmt.as<While>();
+      std::vector<Stmt> hoisted;
+      Stmt contents = hoist(loop->contents, Expr(), &hoisted);
+      if (hoisted.empty()) {
+        return;
+      }
+      stmt = Block::make(Block::make(hoisted),
+                         While::make(loop->cond, contents, loop->kind,
+                                     loop->vec_width));
+    }
+  };
+  HoistLoopInvariants hoistLoopInvariants;
+  hoistLoopInvariants.isInvariant = isInvariant;
+  simplifiedStmt = hoistLoopInvariants.rewrite(simplifiedStmt);
+
+  // Strength reduction. Products of the variable of a serial loop with a
+  // variable that the loop does not modify are replaced by a variable that is
+  // incremented with the loop variable, e.g.
+  //
+  //   for (int i = 0; i < m; i++) {
+  //     ... i * A2_dimension ...
+  //   }
+  //
+  // becomes
+  //
+  //   int i_A2_dimension = 0;
+  //   for (int i = 0; i < m; i++) {
+  //     ... i_A2_dimension ...
+  //     i_A2_dimension += A2_dimension;
+  //   }
+  struct ReduceStrength : public IRRewriter {
+    std::function<bool(Expr, const std::set<Expr>&)> isInvariant;
+
+    using IRRewriter::visit;
+
+    // Continue statements of the loop itself would skip the increments
+    struct FindContinues : public IRVisitor {
+      int loopDepth = 0;
+      bool hasContinues = false;
+
+      using IRVisitor::visit;
+
+      void visit(const For* op) {
+        loopDepth++;
+        IRVisitor::visit(op);
+        loopDepth--;
+      }
+      void visit(const While* op) {
+        loopDepth++;
+        IRVisitor::visit(op);
+        loopDepth--;
+      }
+      void visit(const Continue* op) {
+        hasContinues = hasContinues || loopDepth == 0;
+      }
+    };
+
+    struct ReplaceProducts : public IRRewriter {
+      Expr loopVar;
+      std::function<bool(Expr)> isInvariant;
+      std::map<Expr,Expr> reduced;
+      std::vector<Expr> strides;
+
+      using IRRewriter::visit;
+
+      void visit(const Mul* op) {
+        Expr stride = (op->a == loopVar) ? op->b :
+                      (op->b == loopVar) ? op->a : Expr();
+        if (!stride.defined() || getName(stride).empty() ||
+            stride.type() != op->type || !isInvariant(stride)) {
+          IRRewriter::visit(op);
+          return;
+        }
+        if (!util::contains(reduced, stride)) {
+          reduced.insert({stride,
+              Var::make(getName(loopVar) + "_" + getName(stride), op->type)});
+          strides.push_back(stride);
+        }
+        expr = reduced.at(stride);
+      }
+    };
+
+    void visit(const For* op) {
+      IRRewriter::visit(op);
+      const For* loop = stmt.as<For>();
+      if (loop->kind != LoopKind::Serial ||
+          loop->parallel_unit != ParallelUnit::NotParallel ||
+          !isa<Literal>(loop->increment) ||
+          (!loop->var.type().isInt() && !loop->var.type().isUInt())) {
+        return;
+      }
+
+      FindModifiedVars findModifiedVars;
+      loop->contents.accept(&findModifiedVars);
+      FindContinues findContinues;
+      loop->contents.accept(&findContinues);
+      if (util::contains(findModifiedVars.modifiedVars, loop->var) ||
+          findContinues.hasContinues) {
+        return;
+      }
+
+      ReplaceProducts replaceProducts;
+      replaceProducts.loopVar = loop->var;
+      replaceProducts.isInvariant = [&](Expr expr) {
+        return isInvariant(expr, findModifiedVars.modifiedVars);
+      };
+      Stmt contents = replaceProducts.rewrite(loop->contents);
+      if (replaceProducts.strides.empty()) {
+        return;
+      }
+
+      std::vector<Stmt> decls;
+      std::vector<Stmt> increments;
+      for (auto& stride : replaceProducts.strides) {
+        Expr var = replaceProducts.reduced.at(stride);
+        decls.push_back(VarDecl::make(var,
+            simplify(Mul::make(loop->start, stride))));
+        increments.push_back(Assign::make(var,
+            Add::make(var, simplify(Mul::make(loop->increment, stride)))));
+      }
+      bool isScope = isa<Scope>(contents);
+      Stmt body = isScope ? to<Scope>(contents)->scopedStmt : contents;
+      body = Block::make(body, Block::make(increments));
+      stmt = Block::make(Block::make(decls),
+                         For::make(loop->var, loop->start, loop->end,
+                                   loop->increment,
+                                   isScope ? Scope::make(body) : body,
+                                   loop->kind, loop->parallel_unit,
+                                   loop->unrollFactor, loop->vec_width));
+    }
+  };
+  ReduceStrength reduceStrength;
+  reduceStrength.isInvariant = isInvariant;
+  simplifiedStmt = reduceStrength.rewrite(simplifiedStmt);
+
   return simplifiedStmt;
 }
 
@@ -381,6 +381,21 @@ Stmt Iterator::getSeqInsertEdge(const Expr& parentPos,
                                                           queries, getMode());
 }
 
+Stmt Iterator::getParInsertEdge(const Expr& parentPos,
+    const std::vector<Expr>& coords,
+    const std::vector<AttrQueryResult>& queries) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->getParInsertEdge(parentPos, coords,
+                                                          queries, getMode());
+}
+
+Stmt Iterator::getParFinalizeEdges(const Expr& prevSize,
+    const std::vector<AttrQueryResult>& queries) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->getParFinalizeEdges(prevSize, queries,
+                                                             getMode());
+}
+
 Stmt Iterator::getInitCoords(const Expr& prevSize, 
     const std::vector<AttrQueryResult>& queries) const {
   taco_iassert(defined() && content->mode.defined());
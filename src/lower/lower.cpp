@@ -12,6 +12,8 @@
 #include "taco/ir/ir.h"
 #include "taco/ir/simplify.h"
 #include "taco/ir/ir_generators.h"
+#include "taco/ir/ir_rewriter.h"
+#include "taco/ir/ir_visitor.h"
 #include "taco/ir/ir_printer.h"
 
 #include "taco/lower/lowerer_impl.h"
@@ -44,6 +46,46 @@ std::shared_ptr<LowererImpl> Lowerer::getLowererImpl() {
   return impl;
 }
 
+// Simplification enables further simplification, e.g. hoisting a declaration
+// out of a loop can make it invariant in the enclosing loop, so it is repeated
+// until the code no longer changes. Kernels converge in a few passes, and the
+// bound stops simplifications that undo each other.
+static const int maxSimplifyPasses = 8;
+
+/// Simplify the body of a lowered function, so that code generators declare
+/// the variables that simplification introduces and do not load tensor
+/// properties that it no longer reads. Coroutines, which yield, are left alone.
+static ir::Stmt simplifyFunction(ir::Stmt function) {
+  const ir::Function* func = function.as<ir::Function>();
+  if (func == nullptr) {
+    return function;
+  }
+  struct HasYields : public IRVisitor {
+    using IRVisitor::visit;
+    bool hasYields = false;
+    void visit(const Yield*) {
+      hasYields = true;
+    }
+  };
+  HasYields hasYields;
+  func->body.accept(&hasYields);
+  if (hasYields.hasYields) {
+    return function;
+  }
+
+  Stmt body = func->body;
+  for (int pass = 0; pass < maxSimplifyPasses; pass++) {
+    Stmt simplified = ir::simplify(body);
+    if (simplified == body) {
+      break;
+    }
+    body = simplified;
+  }
+  return (body == func->body)
+         ? function
+         : ir::Function::make(func->name, func->outputs, func->inputs, body);
+}
+
 ir::Stmt lower(IndexStmt stmt, std::string name, 
                bool assemble, bool compute, bool pack, bool unpack,
                Lowerer lowerer) {
@@ -60,7 +102,100 @@ ir::Stmt lower(IndexStmt stmt, std::string name,
   //   std::cerr << "Verifier messages:\n" << messages << "\n";
   // }
 
-  return lowered;
+  return simplifyFunction(lowered);
+}
+
+
+ir::Stmt specializeDimensions(ir::Stmt function,
+    const map<TensorVar,map<int,int>>& dimensions) {
+  const ir::Function* func = function.as<ir::Function>();
+  taco_iassert(func != nullptr);
+
+  // The kernel names its tensors after the tensor variables
+  map<string,map<int,int>> dimensionsByName;
+  for (auto& tensorDimensions : dimensions) {
+    dimensionsByName.insert({tensorDimensions.first.getName(),
+                             tensorDimensions.second});
+  }
+
+  // The variables that the specialized body declares are renamed, so that
+  // they are declared once and copies of them can still be propagated
+  struct SpecializeDimensions : public IRRewriter {
+    const map<string,map<int,int>>& dimensions;
+    map<Expr,Expr> renamed;
+    bool specialized = false;
+
+    using IRRewriter::visit;
+
+    SpecializeDimensions(const map<string,map<int,int>>& dimensions)
+        : dimensions(dimensions) {}
+
+    void rename(Expr var) {
+      const Var* op = var.as<Var>();
+      if (op != nullptr && !util::contains(renamed, var)) {
+        renamed.insert({var, Var::make(op->name, op->type, op->is_ptr,
+                                       op->is_tensor, op->is_parameter)});
+      }
+    }
+
+    void visit(const Var* op) {
+      Expr var = op;
+      expr = util::contains(renamed, var) ? renamed.at(var) : var;
+    }
+
+    void visit(const VarDecl* op) {
+      rename(op->var);
+      IRRewriter::visit(op);
+    }
+
+    void visit(const For* op) {
+      rename(op->var);
+      IRRewriter::visit(op);
+    }
+
+    void visit(const GetProperty* op) {
+      expr = op;
+      if (op->property != TensorProperty::Dimension || !isa<Var>(op->tensor)) {
+        return;
+      }
+      const string& name = to<Var>(op->tensor)->name;
+      if (util::contains(dimensions, name) &&
+          util::contains(dimensions.at(name), op->mode)) {
+        expr = ir::Literal::make(dimensions.at(name).at(op->mode), op->type);
+        specialized = true;
+      }
+    }
+  };
+  SpecializeDimensions specializer(dimensionsByName);
+  Stmt specialized = specializer.rewrite(func->body);
+  if (!specializer.specialized) {
+    return function;
+  }
+
+  // Tensors that are both read and written are passed once
+  vector<Expr> tensors = func->outputs;
+  for (auto& input : func->inputs) {
+    if (!util::contains(tensors, input)) {
+      tensors.push_back(input);
+    }
+  }
+  Expr guard;
+  for (auto& tensor : tensors) {
+    const string& name = to<Var>(tensor)->name;
+    if (!util::contains(dimensionsByName, name)) {
+      continue;
+    }
+    for (auto& dimension : dimensionsByName.at(name)) {
+      Expr check = ir::Eq::make(
+          GetProperty::make(tensor, TensorProperty::Dimension, dimension.first),
+          ir::Literal::make(dimension.second));
+      guard = guard.defined() ? ir::And::make(guard, check) : check;
+    }
+  }
+  taco_iassert(guard.defined());
+
+  return simplifyFunction(ir::Function::make(func->name, func->outputs,
+      func->inputs, IfThenElse::make(guard, specialized, func->body)));
 }
 
 
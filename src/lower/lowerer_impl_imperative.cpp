@@ -11,6 +11,7 @@
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_generators.h"
 #include "taco/ir/ir_visitor.h"
+#include "taco/ir/ir_rewriter.h"
 #include "taco/ir/simplify.h"
 #include "taco/lower/iterator.h"
 #include "taco/lower/merge_lattice.h"
@@ -109,6 +110,47 @@ static void getDependentTensors(IndexStmt stmt, std::set<TensorVar>& tensors) {
   } while (prev != tensors);
 }
 
+/// True iff an expression adds and subtracts the accesses of a set of tensors,
+/// such that replacing the accesses of any subset of them with zero gives the
+/// same expression as zeroing them in a merge lattice.
+static bool addsOperands(IndexExpr expr, const set<TensorVar>& operands) {
+  auto readsOperands = [&](IndexExpr e) {
+    bool reads = false;
+    match(e,
+      function<void(const AccessNode*)>([&](const AccessNode* op) {
+        reads = reads || util::contains(operands, op->tensorVar);
+      })
+    );
+    return reads;
+  };
+
+  if (isa<AddNode>(expr.ptr)) {
+    return addsOperands(to<AddNode>(expr.ptr)->a, operands) &&
+           addsOperands(to<AddNode>(expr.ptr)->b, operands);
+  }
+  else if (isa<SubNode>(expr.ptr)) {
+    return addsOperands(to<SubNode>(expr.ptr)->a, operands) &&
+           addsOperands(to<SubNode>(expr.ptr)->b, operands);
+  }
+  else if (isa<NegNode>(expr.ptr)) {
+    return addsOperands(to<NegNode>(expr.ptr)->a, operands);
+  }
+  else if (isa<MulNode>(expr.ptr)) {
+    // Scaling a sum by an expression of other tensors keeps it a sum
+    auto mul = to<MulNode>(expr.ptr);
+    return (!readsOperands(mul->a) && addsOperands(mul->b, operands)) ||
+           (!readsOperands(mul->b) && addsOperands(mul->a, operands));
+  }
+  else if (isa<DivNode>(expr.ptr)) {
+    auto div = to<DivNode>(expr.ptr);
+    return !readsOperands(div->b) && addsOperands(div->a, operands);
+  }
+  else if (isa<AccessNode>(expr.ptr)) {
+    return !to<AccessNode>(expr.ptr)->isAccessingStructure;
+  }
+  return !readsOperands(expr);
+}
+
 static bool returnsTrue(IndexExpr expr) {
   struct ReturnsTrue : public IndexExprRewriterStrict {
     void visit(const AccessNode* op) {
@@ -195,6 +237,78 @@ static bool needComputeValues(IndexStmt stmt, TensorVar tensor) {
   return needComputeValue;
 }
 
+/// True iff the outermost loop of a statement is parallelized on CPU threads.
+static bool hasParallelOuterLoop(IndexStmt stmt) {
+  bool parallel = false;
+  bool matched = false;
+  match(stmt,
+    function<void(const ForallNode*)>([&](const ForallNode* n) {
+      if (!matched) {
+        parallel = (n->parallel_unit == ParallelUnit::CPUThread);
+        matched = true;
+      }
+    })
+  );
+  return parallel;
+}
+
+/// True iff the iterations of a parallel loop run concurrently. Loops that
+/// reduce into scalars on CPU threads combine the partial results of the
+/// threads through reduction clauses, while other parallel reductions run
+/// serially within the parallel unit that performs them.
+static bool isConcurrentLoop(Forall forall) {
+  return forall.getParallelUnit() != ParallelUnit::NotParallel &&
+         (forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction ||
+          forall.getParallelUnit() == ParallelUnit::CPUThread);
+}
+
+/// Get the kind of loop that a concurrent loop is lowered to. Loops over CPU
+/// tasks are split into tasks, while other loops are shared by the threads
+/// that run them.
+static LoopKind getConcurrentLoopKind(Forall forall) {
+  return (forall.getParallelUnit() == ParallelUnit::CPUTask)
+         ? LoopKind::Task : LoopKind::Runtime;
+}
+
+/// Rename the variables that a statement declares, so that a copy of code that
+/// was lowered twice does not declare the same variables as the original. The
+/// copies are named with a suffix rather than numbered by code generators,
+/// since numbered names can coincide with those of other variables, such as
+/// the outer variable i0 of a split of i.
+static Stmt renameDeclaredVars(Stmt stmt, string suffix) {
+  struct RenameDeclaredVars : IRRewriter {
+    using IRRewriter::visit;
+    string suffix;
+    map<Expr,Expr> renamed;
+
+    RenameDeclaredVars(string suffix) : suffix(suffix) {}
+
+    void rename(Expr var) {
+      const Var* op = var.as<Var>();
+      if (op != nullptr && !util::contains(renamed, var)) {
+        renamed.insert({var, Var::make(op->name + suffix, op->type, op->is_ptr,
+                                       op->is_tensor, op->is_parameter)});
+      }
+    }
+
+    void visit(const Var* op) {
+      Expr var = op;
+      expr = util::contains(renamed, var) ? renamed.at(var) : var;
+    }
+
+    void visit(const VarDecl* op) {
+      rename(op->var);
+      IRRewriter::visit(op);
+    }
+
+    void visit(const For* op) {
+      rename(op->var);
+      IRRewriter::visit(op);
+    }
+  };
+  return RenameDeclaredVars(suffix).rewrite(stmt);
+}
+
 /// Returns the set of result tensors that is assembled by inserting a sparse 
 /// set of coordinates (meaning they will not be fully initialized without an 
 /// explicit zero-initialization loop).
@@ -243,7 +357,7 @@ LowererImplImperative::lower(IndexStmt stmt, string name,
   // Create result and parameter variables
   vector<TensorVar> results = getResults(stmt);
   vector<TensorVar> arguments = getArguments(stmt);
-  vector<TensorVar> temporaries = getTemporaries(stmt);
+  temporaries = getTemporaries(stmt);
 
   needCompute = {};
   if (generateAssembleCode()) {
@@ -302,6 +416,15 @@ LowererImplImperative::lower(IndexStmt stmt, string name,
 
   provGraph = ProvenanceGraph(stmt);
 
+  unguardedVars.clear();
+  for (const IndexVar& indexVar : provGraph.getAllIndexVars()) {
+    if (provGraph.getTailStrategy(indexVar) == TailStrategy::RoundUp) {
+      for (const IndexVar& parent : provGraph.getParents(indexVar)) {
+        unguardedVars.insert(parent);
+      }
+    }
+  }
+
   for (const IndexVar& indexVar : provGraph.getAllIndexVars()) {
     if (iterators.modeIterators().count(indexVar)) {
       indexVarToExprMap.insert({indexVar, iterators.modeIterators()[indexVar].getIteratorVar()});
@@ -647,7 +770,13 @@ LowererImplImperative::splitAppenderAndInserters(const vector<Iterator>& results
 Stmt LowererImplImperative::lowerForall(Forall forall)
 {
   bool hasExactBound = provGraph.hasExactBound(forall.getIndexVar());
-  bool forallNeedsUnderivedGuards = !hasExactBound && emitUnderivedGuards;
+  bool isUnguarded = util::all(
+      provGraph.getUnderivedAncestors(forall.getIndexVar()),
+      [&](const IndexVar& ancestor) {
+        return util::contains(unguardedVars, ancestor);
+      });
+  bool forallNeedsUnderivedGuards = !hasExactBound && !isUnguarded &&
+                                    emitUnderivedGuards;
   if (!ignoreVectorize && forallNeedsUnderivedGuards &&
       (forall.getParallelUnit() == ParallelUnit::CPUVector ||
        forall.getUnrollFactor() > 0)) {
@@ -664,7 +793,8 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
     // place pos guard
     if (forallNeedsUnderivedGuards && provGraph.isCoordVariable(varToRecover) &&
         provGraph.getChildren(varToRecover).size() == 1 &&
-        provGraph.isPosVariable(provGraph.getChildren(varToRecover)[0])) {
+        provGraph.isPosVariable(provGraph.getChildren(varToRecover)[0]) &&
+        !util::contains(unguardedVars, provGraph.getChildren(varToRecover)[0])) {
       IndexVar posVar = provGraph.getChildren(varToRecover)[0];
       std::vector<ir::Expr> iterBounds = provGraph.deriveIterBounds(posVar, definedIndexVarsOrdered, underivedBounds, indexVarToExprMap, iterators);
 
@@ -702,7 +832,8 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
     // place underived guard
     std::vector<ir::Expr> iterBounds = provGraph.deriveIterBounds(varToRecover, definedIndexVarsOrdered, underivedBounds, indexVarToExprMap, iterators);
     if (forallNeedsUnderivedGuards && underivedBounds.count(varToRecover) &&
-        !provGraph.hasPosDescendant(varToRecover)) {
+        !provGraph.hasPosDescendant(varToRecover) &&
+        !util::contains(unguardedVars, varToRecover)) {
 
       // FIXME: [Olivia] Check this with someone
       // Removed underived guard if indexVar is bounded is divisible by its split child indexVar
@@ -762,7 +893,10 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
   definedIndexVars.insert(forall.getIndexVar());
   definedIndexVarsOrdered.push_back(forall.getIndexVar());
 
-  if (forall.getParallelUnit() != ParallelUnit::NotParallel) {
+  // Loops over CPU tasks can be nested, and their sizes are not needed to
+  // launch them
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel &&
+      forall.getParallelUnit() != ParallelUnit::CPUTask) {
     taco_iassert(!parallelUnitSizes.count(forall.getParallelUnit()));
     taco_iassert(!parallelUnitIndexVars.count(forall.getParallelUnit()));
     parallelUnitIndexVars[forall.getParallelUnit()] = forall.getIndexVar();
@@ -793,6 +927,18 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
     temporaryValuesInitFree = codeToInitializeTemporaryParallel(temp->second, forall.getParallelUnit());
   }
 
+  // Privatize the results that threads race to reduce into
+  vector<Stmt> privatizedInitReduce = {Stmt(), Stmt()};
+  vector<TensorVar> privatized;
+  if (forall.getParallelUnit() == ParallelUnit::CPUThread &&
+      forall.getOutputRaceStrategy() == OutputRaceStrategy::Temporary &&
+      generateComputeCode()) {
+    vector<Stmt> privatizeStmts = codeToPrivatizeResults(reducedAccesses,
+                                                         &privatized);
+    privatizedInitReduce = {privatizeStmts[0], privatizeStmts[2]};
+    recoveryStmt = Block::make(recoveryStmt, privatizeStmts[1]);
+  }
+
   Stmt loops;
   // Emit a loop that iterates over over a single iterator (optimization)
   if (caseLattice.iterators().size() == 1 && caseLattice.iterators()[0].isUnique()) {
@@ -872,7 +1018,8 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
     std::vector<IndexVar> underivedAncestors = provGraph.getUnderivedAncestors(forall.getIndexVar());
     taco_iassert(underivedAncestors.size() == 1); // TODO: add support for fused coordinate of pos loop
     loops = lowerMergeLattice(caseLattice, underivedAncestors[0],
-                              forall.getStmt(), reducedAccesses);
+                              forall.getStmt(), reducedAccesses,
+                              forall.getMergeStrategy());
   }
 //  taco_iassert(loops.defined());
 
@@ -881,10 +1028,26 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
     // omitted.
     loops = Stmt();
   }
+  if (generateComputeCode() && forall.getAccumulators() > 1) {
+    loops = codeToSplitAccumulators(forall, loops);
+  }
+  if (generateComputeCode() && !forall.getPrefetches().empty()) {
+    loops = codeToPrefetch(forall, loops);
+  }
+  if (generateComputeCode() &&
+      forall.getOutputRaceStrategy() == OutputRaceStrategy::MergePath) {
+    loops = codeToPartitionByMergePath(forall, loops);
+  }
+  for (const auto& result : privatized) {
+    temporaryArrays.erase(result);
+  }
   definedIndexVars.erase(forall.getIndexVar());
   definedIndexVarsOrdered.pop_back();
   if (forall.getParallelUnit() != ParallelUnit::NotParallel) {
     inParallelLoopDepth--;
+  }
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel &&
+      forall.getParallelUnit() != ParallelUnit::CPUTask) {
     taco_iassert(parallelUnitSizes.count(forall.getParallelUnit()));
     taco_iassert(parallelUnitIndexVars.count(forall.getParallelUnit()));
     parallelUnitIndexVars.erase(forall.getParallelUnit());
@@ -892,7 +1055,9 @@ Stmt LowererImplImperative::lowerForall(Forall forall)
   }
   return Block::blanks(preInitValues,
                        temporaryValuesInitFree[0],
+                       privatizedInitReduce[0],
                        loops,
+                       privatizedInitReduce[1],
                        temporaryValuesInitFree[1]);
 }
 
@@ -902,10 +1067,15 @@ Stmt LowererImplImperative::lowerForallCloned(Forall forall) {
   // construct guard
   // underived or pos variables that have a descendant that has not been defined yet
   vector<IndexVar> varsWithGuard;
+  bool hasUnguardedVars = false;
   for (auto var : provGraph.getAllIndexVars()) {
     if (provGraph.isRecoverable(var, definedIndexVars)) {
       continue; // already recovered
     }
+    if (util::contains(unguardedVars, var)) {
+      hasUnguardedVars = true;
+      continue; // known to be in bounds
+    }
     if (provGraph.isUnderived(var) && !provGraph.hasPosDescendant(var)) { // if there is pos descendant then will be guarded already
       varsWithGuard.push_back(var);
     }
@@ -985,6 +1155,13 @@ Stmt LowererImplImperative::lowerForallCloned(Forall forall) {
 
   Stmt unvectorizedLoop;
 
+  if (!guardCondition.defined() && hasUnguardedVars) {
+    emitUnderivedGuards = false;
+    Stmt loop = lowerForall(forall);
+    emitUnderivedGuards = true;
+    return loop;
+  }
+
   taco_uassert(guardCondition.defined())
     << "Unable to vectorize or unroll loop over unbound variable " << forall.getIndexVar();
 
@@ -1197,6 +1374,21 @@ Stmt LowererImplImperative::lowerForallDimension(Forall forall,
 {
   Expr coordinate = getCoordinateVar(forall.getIndexVar());
 
+  // The outer loop of a split with the peel tail strategy is emitted as a main
+  // loop over the strips that are fully in bounds, whose body does not check
+  // the bounds of the split variable, and an epilogue over the last strip
+  IndexVar peeledVar;
+  IndexVar peeledInnerVar;
+  bool peel = false;
+  if (emitUnderivedGuards &&
+      provGraph.getTailStrategy(forall.getIndexVar()) == TailStrategy::Peel) {
+    peeledVar = provGraph.getParents(forall.getIndexVar())[0];
+    peeledInnerVar = provGraph.getChildren(peeledVar)[1];
+    peel = provGraph.isUnderived(peeledVar) &&
+           !util::contains(unguardedVars, peeledVar) &&
+           !util::contains(definedIndexVars, peeledInnerVar);
+  }
+
   if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
     markAssignsAtomicDepth++;
     atomicParallelUnit = forall.getParallelUnit();
@@ -1204,6 +1396,14 @@ Stmt LowererImplImperative::lowerForallDimension(Forall forall,
 
   Stmt body = lowerForallBody(coordinate, forall.getStmt(), locators, inserters,
                               appenders, caseLattice, reducedAccesses);
+  Stmt peeledBody;
+  if (peel) {
+    unguardedVars.insert(peeledVar);
+    peeledBody = lowerForallBody(coordinate, forall.getStmt(), locators,
+                                 inserters, appenders, caseLattice,
+                                 reducedAccesses);
+    unguardedVars.erase(peeledVar);
+  }
 
   if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
     markAssignsAtomicDepth--;
@@ -1220,9 +1420,31 @@ Stmt LowererImplImperative::lowerForallDimension(Forall forall,
   if (forall.getParallelUnit() == ParallelUnit::CPUVector && !ignoreVectorize) {
     kind = LoopKind::Vectorized;
   }
-  else if (forall.getParallelUnit() != ParallelUnit::NotParallel
-            && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
-    kind = LoopKind::Runtime;
+  else if (isConcurrentLoop(forall) && !ignoreVectorize) {
+    kind = getConcurrentLoopKind(forall);
+  }
+
+  if (peel) {
+    vector<Expr> peeledBounds = provGraph.deriveIterBounds(peeledVar,
+        definedIndexVarsOrdered, underivedBounds, indexVarToExprMap,
+        iterators);
+    Expr splitFactor = provGraph.deriveIterBounds(peeledInnerVar,
+        definedIndexVarsOrdered, underivedBounds, indexVarToExprMap,
+        iterators)[1];
+    Expr fullStrips = ir::simplify(ir::Add::make(bounds[0],
+        ir::Div::make(ir::Sub::make(peeledBounds[1], peeledBounds[0]),
+                      splitFactor)));
+    // The main loop and the epilogue are lowered from the same body, so the
+    // variables that the body of the main loop declares are renamed
+    Stmt mainBody = renameDeclaredVars(Block::make({recoveryStmt, peeledBody}),
+                                       "_main");
+    return Block::blanks(For::make(coordinate, bounds[0], fullStrips, 1,
+                                   mainBody, kind,
+                                   ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), ignoreVectorize ? 0 : forall.getUnrollFactor()),
+                         For::make(coordinate, fullStrips, bounds[1], 1, body,
+                                   kind,
+                                   ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), ignoreVectorize ? 0 : forall.getUnrollFactor()),
+                         posAppend);
   }
 
   return Block::blanks(For::make(coordinate, bounds[0], bounds[1], 1, body,
@@ -1279,9 +1501,8 @@ Stmt LowererImplImperative::lowerForallDimension(Forall forall,
     if (forall.getParallelUnit() == ParallelUnit::CPUVector && !ignoreVectorize) {
       kind = LoopKind::Vectorized;
     }
-    else if (forall.getParallelUnit() != ParallelUnit::NotParallel
-             && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
-      kind = LoopKind::Runtime;
+    else if (isConcurrentLoop(forall) && !ignoreVectorize) {
+      kind = getConcurrentLoopKind(forall);
     }
 
     return Block::blanks(For::make(loopVar, 0, indexListSize, 1, body, kind,
@@ -1330,7 +1551,8 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
       // If this forall is being parallelized via CPU threads (OpenMP), then we can't
       // emit a `break` statement, since OpenMP doesn't support breaking out of a
       // parallel loop. Instead, we'll bound the top of the loop and omit the check.
-      if (forall.getParallelUnit() != ParallelUnit::CPUThread) {
+      if (forall.getParallelUnit() != ParallelUnit::CPUThread &&
+          forall.getParallelUnit() != ParallelUnit::CPUTask) {
         boundsGuard = this->upperBoundGuardForWindowPosition(iterator, coordinate);
       }
     }
@@ -1374,7 +1596,8 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
       // As discussed above, if this position loop is parallelized over CPU
       // threads (OpenMP), then we need to have an explicit upper bound to
       // the for loop, instead of breaking out of the loop in the middle.
-      if (forall.getParallelUnit() == ParallelUnit::CPUThread) {
+      if (forall.getParallelUnit() == ParallelUnit::CPUThread ||
+          forall.getParallelUnit() == ParallelUnit::CPUTask) {
         endBound = this->searchForEndOfWindowPosition(iterator, startBoundCopy, endBound);
       }
     }
@@ -1395,9 +1618,8 @@ Stmt LowererImplImperative::lowerForallPosition(Forall forall, Iterator iterator
   if (forall.getParallelUnit() == ParallelUnit::CPUVector && !ignoreVectorize) {
     kind = LoopKind::Vectorized;
   }
-  else if (forall.getParallelUnit() != ParallelUnit::NotParallel
-           && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
-    kind = LoopKind::Runtime;
+  else if (isConcurrentLoop(forall) && !ignoreVectorize) {
+    kind = getConcurrentLoopKind(forall);
   }
 
   // Loop with preamble and postamble
@@ -1561,9 +1783,8 @@ Stmt LowererImplImperative::lowerForallFusedPosition(Forall forall, Iterator ite
   if (forall.getParallelUnit() == ParallelUnit::CPUVector && !ignoreVectorize) {
     kind = LoopKind::Vectorized;
   }
-  else if (forall.getParallelUnit() != ParallelUnit::NotParallel
-           && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
-    kind = LoopKind::Runtime;
+  else if (isConcurrentLoop(forall) && !ignoreVectorize) {
+    kind = getConcurrentLoopKind(forall);
   }
   // Loop with preamble and postamble
   return Block::blanks(boundsCompute,
@@ -1578,7 +1799,8 @@ Stmt LowererImplImperative::lowerForallFusedPosition(Forall forall, Iterator ite
 
 Stmt LowererImplImperative::lowerMergeLattice(MergeLattice caseLattice, IndexVar coordinateVar,
                                     IndexStmt statement, 
-                                    const std::set<Access>& reducedAccesses)
+                                    const std::set<Access>& reducedAccesses,
+                                    MergeStrategy mergeStrategy)
 {
   // Lower merge lattice always gets called from lowerForAll. So we want loop lattice
   MergeLattice loopLattice = caseLattice.getLoopLattice();
@@ -1604,7 +1826,7 @@ Stmt LowererImplImperative::lowerMergeLattice(MergeLattice caseLattice, IndexVar
     // points in the merge lattice.
     IndexStmt zeroedStmt = zero(statement, getExhaustedAccesses(point, caseLattice));
     MergeLattice sublattice = caseLattice.subLattice(point);
-    Stmt mergeLoop = lowerMergePoint(sublattice, coordinate, coordinateVar, zeroedStmt, reducedAccesses, resolvedCoordDeclared);
+    Stmt mergeLoop = lowerMergePoint(sublattice, coordinate, coordinateVar, zeroedStmt, reducedAccesses, resolvedCoordDeclared, mergeStrategy);
     mergeLoopsVec.push_back(mergeLoop);
   }
   Stmt mergeLoops = Block::make(mergeLoopsVec);
@@ -1619,7 +1841,8 @@ Stmt LowererImplImperative::lowerMergeLattice(MergeLattice caseLattice, IndexVar
 
 Stmt LowererImplImperative::lowerMergePoint(MergeLattice pointLattice,
                                   ir::Expr coordinate, IndexVar coordinateVar, IndexStmt statement,
-                                  const std::set<Access>& reducedAccesses, bool resolvedCoordDeclared)
+                                  const std::set<Access>& reducedAccesses, bool resolvedCoordDeclared,
+                                  MergeStrategy mergeStrategy)
 {
   MergePoint point = pointLattice.points().front();
 
@@ -1632,6 +1855,56 @@ Stmt LowererImplImperative::lowerMergePoint(MergeLattice pointLattice,
   taco_iassert(mergers.size() > 0);
   taco_iassert(rangers.size() > 0);
 
+  // Loops over intersections of compressed levels can gallop: every iterator
+  // is advanced to the largest of the coordinates of the iterators, and the
+  // statement is computed where they all agree
+  vector<Expr> crdArrays;
+  bool gallop = mergeStrategy == MergeStrategy::Gallop &&
+                pointLattice.points().size() == 1 && mergers.size() > 1 &&
+                iterators.size() == mergers.size() &&
+                !(isa<Assignment>(statement) &&
+                  returnsTrue(to<Assignment>(statement).getRhs()));
+  for (auto& merger : mergers) {
+    if (!gallop) {
+      break;
+    }
+    gallop = merger.hasPosIter() && merger.isUnique() &&
+             !merger.isWindowed() && !merger.hasIndexSet();
+    if (gallop) {
+      ModeFunction posAccess = merger.posAccess(merger.getPosVar(),
+                                                coordinates(merger));
+      auto load = posAccess[0].as<Load>();
+      gallop = !posAccess.compute().defined() && load != nullptr &&
+               ir::simplify(load->loc) == merger.getPosVar();
+      if (gallop) {
+        crdArrays.push_back(load->arr);
+      }
+    }
+  }
+
+  // Loops over unions of compressed levels that add their operands can
+  // compute the statement once per coordinate, from the values of the
+  // operands that are at the coordinate and zero for the others
+  MergeLattice loopLattice = pointLattice.getLoopLattice();
+  set<TensorVar> mergedTensors;
+  bool branchless = mergeStrategy == MergeStrategy::Branchless &&
+                    loopLattice.points().size() > 1 && mergers.size() > 1 &&
+                    iterators.size() == mergers.size() &&
+                    isa<Assignment>(statement) &&
+                    !(pointLattice.anyModeIteratorIsLeaf() &&
+                      pointLattice.needExplicitZeroChecks());
+  for (auto& merger : mergers) {
+    if (!branchless) {
+      break;
+    }
+    branchless = merger.hasPosIter() && merger.isUnique() &&
+                 !merger.isWindowed() && !merger.hasIndexSet();
+    mergedTensors.insert(
+        this->iterators.modeAccess(merger).getAccess().getTensorVar());
+  }
+  branchless = branchless &&
+               addsOperands(to<Assignment>(statement).getRhs(), mergedTensors);
+
   // Load coordinates from position iterators
   Stmt loadPosIterCoordinates = codeToLoadCoordinatesFromPosIterators(iterators, !resolvedCoordDeclared);
 
@@ -1678,7 +1951,17 @@ Stmt LowererImplImperative::lowerMergePoint(MergeLattice pointLattice,
   }
 
   // Merge iterator coordinate variables
-  Stmt resolvedCoordinate = resolveCoordinate(mergers, coordinate, !resolvedCoordDeclared);
+  Stmt resolvedCoordinate;
+  if (gallop) {
+    Expr largest = Max::make(coordinates(mergers));
+    resolvedCoordinate = resolvedCoordDeclared
+                         ? Assign::make(coordinate, largest)
+                         : VarDecl::make(coordinate, largest);
+  }
+  else {
+    resolvedCoordinate = resolveCoordinate(mergers, coordinate,
+                                           !resolvedCoordDeclared);
+  }
 
   // Locate positions
   Stmt loadLocatorPosVars = declLocatePosVars(locators);
@@ -1691,11 +1974,93 @@ Stmt LowererImplImperative::lowerMergePoint(MergeLattice pointLattice,
                                                        alwaysReduce);
 
   // One case for each child lattice point lp
-  Stmt caseStmts = lowerMergeCases(coordinate, coordinateVar, statement, pointLattice,
-                                   reducedAccesses);
+  Stmt caseStmts;
+  if (branchless) {
+    vector<Iterator> appenders;
+    vector<Iterator> inserters;
+    tie(appenders, inserters) = splitAppenderAndInserters(loopLattice.results());
+    Stmt body = lowerForallBody(coordinate, statement, {}, inserters, appenders,
+                                MergeLattice({loopLattice.points()[0]}),
+                                reducedAccesses);
+
+    // Select the values of the operands that are at the coordinate. The loop
+    // only runs while no iterator is exhausted, so the values at the positions
+    // of the iterators are in bounds and are loaded before the selects, which
+    // then choose between registers
+    struct SelectValues : IRRewriter {
+      using IRRewriter::visit;
+      vector<tuple<Expr,Iterator,string>> values;
+      Expr coordinate;
+      map<size_t,Expr> loadedValues;
+      vector<Stmt> loads;
+
+      void visit(const Load* op) {
+        IRRewriter::visit(op);
+        for (size_t i = 0; i < values.size(); i++) {
+          Expr valuesArr = get<0>(values[i]);
+          Iterator merger = get<1>(values[i]);
+          auto gp = op->arr.as<GetProperty>();
+          auto valuesGp = valuesArr.as<GetProperty>();
+          bool isValues = op->arr == valuesArr ||
+                          (gp && valuesGp && gp->tensor == valuesGp->tensor &&
+                           gp->property == valuesGp->property);
+          if (isValues && ir::simplify(op->loc) == merger.getPosVar()) {
+            if (!util::contains(loadedValues, i)) {
+              Expr value = Var::make(get<2>(values[i]) + "_val", op->type);
+              loads.push_back(VarDecl::make(value, expr));
+              loadedValues.insert({i, value});
+            }
+            Expr present = Eq::make(merger.getCoordVar(), coordinate);
+            expr = ir::Call::make("TACO_SELECT",
+                                  {present, loadedValues.at(i),
+                                   ir::Literal::zero(op->type)},
+                                  op->type);
+            return;
+          }
+        }
+      }
+    };
+    SelectValues selectValues;
+    selectValues.coordinate = coordinate;
+    for (auto& merger : mergers) {
+      TensorVar tensor =
+          this->iterators.modeAccess(merger).getAccess().getTensorVar();
+      selectValues.values.push_back(make_tuple(getValuesArray(tensor), merger,
+                                               tensor.getName()));
+    }
+    body = selectValues.rewrite(body);
+    caseStmts = Block::make(Block::make(selectValues.loads), body);
+  }
+  else {
+    caseStmts = lowerMergeCases(coordinate, coordinateVar, statement,
+                                pointLattice, reducedAccesses);
+  }
 
   // Increment iterator position variables
-  Stmt incIteratorVarStmts = codeToIncIteratorVars(coordinate, coordinateVar, iterators, mergers);
+  Stmt incIteratorVarStmts;
+  if (gallop) {
+    // The iterators step past coordinates where they all agree, and gallop
+    // to the largest coordinate otherwise
+    vector<Expr> matches;
+    vector<Stmt> steps;
+    vector<Stmt> gallops;
+    for (size_t i = 0; i < mergers.size(); i++) {
+      Expr ivar = mergers[i].getIteratorVar();
+      matches.push_back(Eq::make(mergers[i].getCoordVar(), coordinate));
+      steps.push_back(compoundAssign(ivar, 1));
+      gallops.push_back(Assign::make(ivar,
+          ir::Call::make("taco_gallop", {crdArrays[i], ivar,
+                                         mergers[i].getEndVar(), coordinate},
+                         ivar.type())));
+    }
+    incIteratorVarStmts = IfThenElse::make(conjunction(matches),
+                                           Block::make(steps),
+                                           Block::make(gallops));
+  }
+  else {
+    incIteratorVarStmts = codeToIncIteratorVars(coordinate, coordinateVar,
+                                                iterators, mergers);
+  }
 
   /// While loop over rangers
   return While::make(checkThatNoneAreExhausted(rangers),
@@ -2386,6 +2751,66 @@ vector<Stmt> LowererImplImperative::codeToInitializeTemporaryParallel(Where wher
   return {initializeTemporary, freeTemporary};
 }
 
+// Private copies of results are denoted by result.getName() + '_private'
+vector<Stmt> LowererImplImperative::codeToPrivatizeResults(
+    const set<Access>& reducedAccesses, vector<TensorVar>* privatized) {
+  vector<Stmt> initStmts;
+  vector<Stmt> declStmts;
+  vector<Stmt> reduceStmts;
+  for (const auto& access : reducedAccesses) {
+    TensorVar result = access.getTensorVar();
+    if (result.getOrder() == 0 || !isDense(result.getFormat()) ||
+        util::contains(temporaries, result) ||
+        util::contains(*privatized, result)) {
+      continue;
+    }
+    privatized->push_back(result);
+
+    Expr tensor = getTensorVar(result);
+    Expr size = 1;
+    for (int mode = 0; mode < result.getOrder(); mode++) {
+      size = ir::Mul::make(size, GetProperty::make(tensor,
+                                     TensorProperty::Dimension, mode));
+    }
+    size = ir::simplify(size);
+    const Datatype type = result.getType().getDataType();
+    Expr threadNum = ir::Call::make("omp_get_thread_num", {}, size.type());
+
+    // The number of copies is read once, so that the loop that sums them does
+    // not call into OpenMP in its condition
+    Expr numThreads = Var::make(result.getName() + "_num_threads", size.type());
+    initStmts.push_back(VarDecl::make(numThreads,
+        ir::Call::make("omp_get_max_threads", {}, size.type())));
+
+    // Every thread reduces into a zeroed copy of the result
+    Expr valuesAll = Var::make(result.getName() + "_private_all", type, true,
+                               false);
+    Expr callocValues = ir::Call::make("calloc",
+                                       {ir::Mul::make(size, numThreads),
+                                        Sizeof::make(type)}, type);
+    initStmts.push_back(VarDecl::make(valuesAll, callocValues));
+
+    Expr values = Var::make(result.getName() + "_private", type, true, false);
+    declStmts.push_back(VarDecl::make(values,
+        ir::Add::make(valuesAll, ir::Mul::make(size, threadNum))));
+    temporaryArrays.insert({result, {values}});
+
+    // The copies are summed into the result in parallel over its components
+    Expr p = Var::make("p" + result.getName(), Int());
+    Expr t = Var::make("t" + result.getName(), Int());
+    Expr resultValues = GetProperty::make(tensor, TensorProperty::Values);
+    Stmt reduceThreads = For::make(t, 0, numThreads, 1,
+        compoundStore(resultValues, p,
+                      Load::make(valuesAll,
+                                 ir::Add::make(ir::Mul::make(t, size), p))));
+    reduceStmts.push_back(For::make(p, 0, size, 1, reduceThreads,
+                                    LoopKind::Static_Chunked));
+    reduceStmts.push_back(Free::make(valuesAll));
+  }
+  return {Block::make(initStmts), Block::make(declStmts),
+          Block::make(reduceStmts)};
+}
+
 vector<Stmt> LowererImplImperative::codeToInitializeTemporary(Where where) {
   TensorVar temporary = where.getTemporary();
 
@@ -2596,6 +3021,9 @@ Stmt LowererImplImperative::lowerAssemble(Assemble assemble) {
   std::tie(resultAccesses, reducedAccesses) = 
       getResultAccesses(assemble.getCompute());
   const auto& queryResults = assemble.getAttrQueryResults();
+  const bool parallelQueries = assemble.getQueries().defined() &&
+                               hasParallelOuterLoop(assemble.getQueries()) &&
+                               !should_use_CUDA_codegen();
 
   std::vector<Stmt> initAssembleStmts;
   for (const auto& resultAccess : resultAccesses) {
@@ -2620,8 +3048,17 @@ Stmt LowererImplImperative::lowerAssemble(Assemble assemble) {
                                                           queryResults);
           initAssembleStmts.push_back(initEdges);
 
-          Stmt insertEdgeLoop = resultIterator.getSeqInsertEdge(
-              resultIterator.getParent().getPosVar(), coords, queryResults);
+          // Edges of different parents are inserted in parallel if the
+          // attribute queries are computed in parallel
+          Expr parentPos = resultIterator.getParent().getPosVar();
+          Stmt insertEdgeLoop = parallelQueries
+              ? resultIterator.getParInsertEdge(parentPos, coords, queryResults)
+              : Stmt();
+          const bool parallelEdges = insertEdgeLoop.defined();
+          if (!parallelEdges) {
+            insertEdgeLoop = resultIterator.getSeqInsertEdge(parentPos, coords,
+                                                             queryResults);
+          }
           auto locateCoords = coords;
           for (auto iter = resultIterator.getParent(); !iter.isRoot();
                iter = iter.getParent()) {
@@ -2631,14 +3068,22 @@ Stmt LowererImplImperative::lowerAssemble(Assemble assemble) {
                   resultModeOrdering[iter.getMode().getLevel() - 1]);
               Expr pos = iter.getPosVar();
               Stmt initPos = VarDecl::make(pos, iter.locate(locateCoords)[0]);
+              LoopKind kind = (parallelEdges && iter.getParent().isRoot())
+                              ? LoopKind::Static_Chunked : LoopKind::Serial;
               insertEdgeLoop = For::make(coords.back(), 0, dim, 1,
-                                         Block::make(initPos, insertEdgeLoop));
+                                         Block::make(initPos, insertEdgeLoop),
+                                         kind);
             } else {
               taco_not_supported_yet;
             }
             locateCoords.pop_back();
           }
           initAssembleStmts.push_back(insertEdgeLoop);
+          if (parallelEdges) {
+            Stmt finalizeEdges = resultIterator.getParFinalizeEdges(
+                prevSize, queryResults);
+            initAssembleStmts.push_back(finalizeEdges);
+          }
         }
 
         Stmt initCoords = resultIterator.getInitCoords(prevSize, queryResults);
@@ -3895,6 +4340,496 @@ bool LowererImplImperative::isNonFullyInitialized(Expr result) {
 }
 
 
+Stmt LowererImplImperative::codeToPrefetch(Forall forall, Stmt loops) {
+  if (!loops.defined()) {
+    return loops;
+  }
+
+  // The values arrays of the prefetched tensors, mapped to their distances
+  vector<pair<Expr,size_t>> prefetched;
+  for (const auto& prefetch : forall.getPrefetches()) {
+    if (util::contains(tensorVars, prefetch.first)) {
+      prefetched.push_back({getValuesArray(prefetch.first), prefetch.second});
+    }
+  }
+  auto getDistance = [&](Expr arr) -> size_t {
+    for (const auto& values : prefetched) {
+      if (arr == values.first) {
+        return values.second;
+      }
+      auto gp = arr.as<GetProperty>();
+      auto valuesGp = values.first.as<GetProperty>();
+      if (gp && valuesGp && gp->tensor == valuesGp->tensor &&
+          gp->property == valuesGp->property) {
+        return values.second;
+      }
+    }
+    return 0;
+  };
+
+  struct InsertPrefetches : IRRewriter {
+    using IRRewriter::visit;
+    function<size_t(Expr)> getDistance;
+
+    InsertPrefetches(function<size_t(Expr)> getDistance)
+        : getDistance(getDistance) {}
+
+    void visit(const For* op) {
+      // Collect the definitions of the variables of the loop body and the
+      // loads of prefetched values. Variables that are redefined or updated in
+      // the body cannot be computed ahead.
+      struct FindLoads : IRVisitor {
+        using IRVisitor::visit;
+        function<size_t(Expr)> getDistance;
+        map<Expr,Expr> definitions;
+        set<Expr> bodyVars;
+        vector<pair<const Load*,size_t>> loads;
+
+        void visit(const VarDecl* op) {
+          if (util::contains(bodyVars, op->var)) {
+            definitions.erase(op->var);
+          }
+          else {
+            definitions.insert({op->var, op->rhs});
+          }
+          bodyVars.insert(op->var);
+          IRVisitor::visit(op);
+        }
+        void visit(const Assign* op) {
+          definitions.erase(op->lhs);
+          bodyVars.insert(op->lhs);
+          IRVisitor::visit(op);
+        }
+        void visit(const For* op) {
+          // Loads in nested loops are prefetched for their first iteration
+          if (util::contains(bodyVars, op->var)) {
+            definitions.erase(op->var);
+          }
+          else {
+            definitions.insert({op->var, op->start});
+          }
+          bodyVars.insert(op->var);
+          IRVisitor::visit(op);
+        }
+        void visit(const Load* op) {
+          const size_t distance = getDistance(op->arr);
+          if (distance > 0) {
+            loads.push_back({op, distance});
+          }
+          IRVisitor::visit(op);
+        }
+      };
+      FindLoads findLoads;
+      findLoads.getDistance = getDistance;
+      op->contents.accept(&findLoads);
+
+      // Compute the locations of the loads of an iteration ahead from the
+      // loop variable and the variables that are defined outside the loop
+      struct ComputeAhead : IRRewriter {
+        using IRRewriter::visit;
+        Expr loopVar;
+        Expr ahead;
+        const map<Expr,Expr>& definitions;
+        const set<Expr>& bodyVars;
+        bool computable = true;
+
+        ComputeAhead(Expr loopVar, Expr ahead,
+                     const map<Expr,Expr>& definitions,
+                     const set<Expr>& bodyVars)
+            : loopVar(loopVar), ahead(ahead), definitions(definitions),
+              bodyVars(bodyVars) {}
+
+        void visit(const Var* op) {
+          Expr var = op;
+          if (var == loopVar) {
+            expr = ahead;
+          }
+          else if (util::contains(definitions, var)) {
+            expr = rewrite(definitions.at(var));
+          }
+          else {
+            computable = computable && !util::contains(bodyVars, var);
+            expr = var;
+          }
+        }
+      };
+
+      map<size_t,vector<Stmt>> prefetches;
+      map<size_t,Expr> aheads;
+      set<string> prefetchedLocs;
+      for (const auto& load : findLoads.loads) {
+        Expr stride = ir::Literal::make((int) load.second);
+        if (!isa<ir::Literal>(op->increment) ||
+            !to<ir::Literal>(op->increment)->equalsScalar(1)) {
+          stride = ir::Mul::make(stride, op->increment);
+        }
+        Expr ahead = ir::Add::make(op->var, stride);
+        ComputeAhead computeAhead(op->var, ahead, findLoads.definitions,
+                                  findLoads.bodyVars);
+        Expr loc = computeAhead.rewrite(load.first->loc);
+        Expr arr = computeAhead.rewrite(load.first->arr);
+        const string key = util::toString(Load::make(arr, loc));
+        if (!computeAhead.computable || util::contains(prefetchedLocs, key)) {
+          continue;
+        }
+        prefetchedLocs.insert(key);
+        prefetches[load.second].push_back(Prefetch::make(arr, loc));
+        aheads.insert({load.second, ahead});
+      }
+
+      if (prefetches.empty()) {
+        stmt = op;
+        return;
+      }
+
+      // Locations past the end of the loop may read past the end of the
+      // arrays that the locations are computed from
+      vector<Stmt> guardedPrefetches;
+      for (const auto& distancePrefetches : prefetches) {
+        Expr ahead = aheads.at(distancePrefetches.first);
+        guardedPrefetches.push_back(
+            IfThenElse::make(Lt::make(ahead, op->end),
+                             Block::make(distancePrefetches.second)));
+      }
+      Stmt contents = isa<Scope>(op->contents)
+                      ? to<Scope>(op->contents)->scopedStmt : op->contents;
+      contents = Block::make(Block::make(guardedPrefetches), contents);
+      stmt = For::make(op->var, op->start, op->end, op->increment, contents,
+                       op->kind, op->parallel_unit, op->unrollFactor,
+                       op->vec_width);
+    }
+  };
+  return InsertPrefetches(getDistance).rewrite(loops);
+}
+
+Stmt LowererImplImperative::codeToSplitAccumulators(Forall forall,
+                                                   Stmt loops) {
+  if (!loops.defined()) {
+    return loops;
+  }
+
+  struct SplitAccumulators : IRRewriter {
+    using IRRewriter::visit;
+    size_t accumulators;
+
+    SplitAccumulators(size_t accumulators) : accumulators(accumulators) {}
+
+    void visit(const For* op) {
+      // Only the outermost serial loop is split, and its iterations must run
+      // to completion
+      struct FindAccumulators : IRVisitor {
+        using IRVisitor::visit;
+        map<Expr,int> reads;
+        map<Expr,int> updates;
+        set<Expr> declared;
+        bool exits = false;
+
+        void visit(const VarDecl* op) {
+          declared.insert(op->var);
+          IRVisitor::visit(op);
+        }
+        void visit(const Assign* op) {
+          auto add = op->rhs.as<ir::Add>();
+          if (isa<Var>(op->lhs) && !to<Var>(op->lhs)->is_ptr &&
+              add != nullptr && add->a == op->lhs && !op->use_atomics &&
+              op->lhs.type() != Bool) {
+            updates[op->lhs]++;
+            add->b.accept(this);
+          }
+          else {
+            IRVisitor::visit(op);
+          }
+        }
+        void visit(const Var* op) {
+          reads[op]++;
+        }
+        void visit(const Continue*) {
+          exits = true;
+        }
+        void visit(const Break*) {
+          exits = true;
+        }
+      };
+      FindAccumulators findAccumulators;
+      op->contents.accept(&findAccumulators);
+
+      // Accumulators are declared before the loop and are only read by the
+      // updates that add to them
+      vector<Expr> accumulatorVars;
+      for (auto& update : findAccumulators.updates) {
+        if (!util::contains(findAccumulators.reads, update.first) &&
+            !util::contains(findAccumulators.declared, update.first)) {
+          accumulatorVars.push_back(update.first);
+        }
+      }
+      const auto increment = op->increment.as<ir::Literal>();
+      if (accumulatorVars.empty() || findAccumulators.exits ||
+          op->kind != LoopKind::Serial || increment == nullptr ||
+          increment->getIntValue() != 1) {
+        stmt = op;
+        return;
+      }
+
+      // Every unrolled iteration adds to its own copy of the accumulators,
+      // and declares its own copies of the variables of the loop body
+      struct CopyIteration : IRRewriter {
+        using IRRewriter::visit;
+        map<Expr,Expr> substitutions;
+
+        void visit(const Var* op) {
+          Expr var = op;
+          expr = util::contains(substitutions, var) ? substitutions.at(var)
+                                                    : var;
+        }
+        void visit(const VarDecl* op) {
+          substitutions[op->var] = Var::make(to<Var>(op->var)->name,
+                                             op->var.type(),
+                                             to<Var>(op->var)->is_ptr);
+          IRRewriter::visit(op);
+        }
+      };
+      Stmt contents = isa<Scope>(op->contents)
+                      ? to<Scope>(op->contents)->scopedStmt : op->contents;
+      vector<Stmt> initAccumulators;
+      vector<Stmt> iterations;
+      vector<vector<Expr>> partialSums(accumulatorVars.size());
+      for (size_t k = 0; k < accumulators; k++) {
+        CopyIteration copy;
+        if (k > 0) {
+          copy.substitutions[op->var] =
+              ir::Add::make(op->var, ir::Literal::make((int)k, op->var.type()));
+          for (size_t a = 0; a < accumulatorVars.size(); a++) {
+            Expr var = accumulatorVars[a];
+            Expr partial = Var::make(to<Var>(var)->name, var.type());
+            initAccumulators.push_back(
+                VarDecl::make(partial, ir::Literal::zero(var.type())));
+            copy.substitutions[var] = partial;
+            partialSums[a].push_back(partial);
+          }
+        }
+        iterations.push_back(copy.rewrite(contents));
+      }
+
+      // for (; var < end - (end - start) % K; var += K) { ... }
+      // for (; var < end; var++) { ... }
+      // acc += acc1 + ... + accK-1
+      Expr unrolledEnd = Var::make(to<Var>(op->var)->name + "_unrolled_end",
+                                   op->var.type());
+      Expr tripCount = ir::Sub::make(op->end, op->start);
+      Expr remainder = ir::Rem::make(tripCount,
+          ir::Literal::make((int)accumulators, op->var.type()));
+      Stmt declUnrolledEnd = VarDecl::make(unrolledEnd,
+                                           ir::Sub::make(op->end, remainder));
+      Stmt unrolledLoop = For::make(op->var, op->start, unrolledEnd,
+          ir::Literal::make((int)accumulators, op->var.type()),
+          Block::make(iterations), op->kind, op->parallel_unit,
+          op->unrollFactor, op->vec_width);
+      Stmt remainderLoop = For::make(op->var, unrolledEnd, op->end,
+                                     op->increment, op->contents, op->kind,
+                                     op->parallel_unit, op->unrollFactor,
+                                     op->vec_width);
+      vector<Stmt> combineAccumulators;
+      for (size_t a = 0; a < accumulatorVars.size(); a++) {
+        Expr sum = partialSums[a][0];
+        for (size_t k = 1; k < partialSums[a].size(); k++) {
+          sum = ir::Add::make(sum, partialSums[a][k]);
+        }
+        combineAccumulators.push_back(compoundAssign(accumulatorVars[a], sum));
+      }
+      stmt = Block::make(Block::make(initAccumulators), declUnrolledEnd,
+                         unrolledLoop, remainderLoop,
+                         Block::make(combineAccumulators));
+    }
+  };
+  return SplitAccumulators(forall.getAccumulators()).rewrite(loops);
+}
+
+Stmt LowererImplImperative::codeToPartitionByMergePath(Forall forall,
+                                                      Stmt loops) {
+  if (!loops.defined()) {
+    return loops;
+  }
+
+  struct PartitionRows : IRRewriter {
+    using IRRewriter::visit;
+    Expr row;
+
+    PartitionRows(Expr row) : row(row) {}
+
+    void visit(const For* op) {
+      if (!(op->var == row)) {
+        IRRewriter::visit(op);
+        return;
+      }
+
+      // Find the loop over the positions of a row and the store of the sum
+      // of the row into the result
+      struct FindRowLoop : IRVisitor {
+        using IRVisitor::visit;
+        Expr row;
+        map<Expr,Expr> definitions;
+        const For* positionLoop = nullptr;
+        vector<const Store*> stores;
+
+        void visit(const VarDecl* op) {
+          definitions.insert({op->var, op->rhs});
+          IRVisitor::visit(op);
+        }
+        void visit(const For* op) {
+          auto start = op->start.as<Load>();
+          if (positionLoop == nullptr && start != nullptr) {
+            Expr loc = start->loc;
+            if (util::contains(definitions, loc)) {
+              loc = definitions.at(loc);
+            }
+            if (ir::simplify(loc) == row) {
+              positionLoop = op;
+              return;
+            }
+          }
+          IRVisitor::visit(op);
+        }
+        void visit(const Store* op) {
+          stores.push_back(op);
+          IRVisitor::visit(op);
+        }
+      };
+      FindRowLoop findRowLoop;
+      findRowLoop.row = row;
+      op->contents.accept(&findRowLoop);
+      const For* positionLoop = findRowLoop.positionLoop;
+      taco_iassert(positionLoop != nullptr &&
+                   findRowLoop.stores.size() == 1);
+      taco_iassert(isa<ir::Literal>(op->start) &&
+                   to<ir::Literal>(op->start)->equalsScalar(0));
+      const Store* resultStore = findRowLoop.stores[0];
+      Expr pos = to<Load>(positionLoop->start)->arr;
+      Expr numRows = op->end;
+
+      // Restricts the loop over the positions of a row to the positions of a
+      // partition, and optionally stores the sum of the row into the carry-out
+      // arrays of a thread instead of the result
+      struct RestrictRow : IRRewriter {
+        using IRRewriter::visit;
+        const For* positionLoop;
+        Expr begin;
+        Expr end;
+        Expr carryLocs;
+        Expr carryVals;
+        Expr thread;
+
+        void visit(const For* op) {
+          if (op != positionLoop) {
+            IRRewriter::visit(op);
+            return;
+          }
+          stmt = For::make(op->var, ir::Max::make(op->start, begin),
+                           end.defined() ? end : op->end, op->increment,
+                           op->contents, op->kind, op->parallel_unit,
+                           op->unrollFactor, op->vec_width);
+        }
+        void visit(const Store* op) {
+          if (!carryLocs.defined()) {
+            IRRewriter::visit(op);
+            return;
+          }
+          stmt = Block::make(Store::make(carryLocs, thread, op->loc),
+                             Store::make(carryVals, thread, op->data));
+        }
+      };
+
+      const string name = util::toString(row);
+      const string positionName = util::toString(positionLoop->var);
+      Datatype type = row.type();
+      Expr numThreads = Var::make(name + "_threads", type);
+      Expr numItems = Var::make(name + "_items", type);
+      Expr chunk = Var::make(name + "_chunk", type);
+      Expr thread = Var::make(name + "_thread", type);
+      Expr diagonalBegin = Var::make(name + "_diagonal_begin", type);
+      Expr diagonalEnd = Var::make(name + "_diagonal_end", type);
+      Expr rowBegin = Var::make(name + "_begin", type);
+      Expr rowEnd = Var::make(name + "_end", type);
+      Expr positionBegin = Var::make(positionName + "_begin", type);
+      Expr positionEnd = Var::make(positionName + "_end", type);
+      Expr carryLocs = Var::make(name + "_carry_locs", type, true, false);
+      Expr carryVals = Var::make(name + "_carry_vals", resultStore->data.type(),
+                                 true, false);
+
+      // The merge path of the row ends and the nonzeros is split into equal
+      // parts, and every thread finds the rows and positions at the
+      // diagonals where its part begins and ends
+      vector<Stmt> partitionStmts;
+      partitionStmts.push_back(VarDecl::make(diagonalBegin,
+          ir::Min::make(ir::Mul::make(thread, chunk), numItems)));
+      partitionStmts.push_back(VarDecl::make(diagonalEnd,
+          ir::Min::make(ir::Add::make(diagonalBegin, chunk), numItems)));
+      partitionStmts.push_back(VarDecl::make(rowBegin,
+          ir::Call::make("taco_mergePathSearch",
+                         {pos, numRows, diagonalBegin}, type)));
+      partitionStmts.push_back(VarDecl::make(rowEnd,
+          ir::Call::make("taco_mergePathSearch",
+                         {pos, numRows, diagonalEnd}, type)));
+      partitionStmts.push_back(VarDecl::make(positionBegin,
+                                             ir::Sub::make(diagonalBegin,
+                                                           rowBegin)));
+      partitionStmts.push_back(VarDecl::make(positionEnd,
+                                             ir::Sub::make(diagonalEnd,
+                                                           rowEnd)));
+
+      // Rows that end in the part of a thread are stored into the results,
+      // where the first of them may have been started by earlier threads
+      RestrictRow restrictRows;
+      restrictRows.positionLoop = positionLoop;
+      restrictRows.begin = positionBegin;
+      Stmt rows = For::make(row, rowBegin, rowEnd, 1,
+                            restrictRows.rewrite(op->contents));
+      partitionStmts.push_back(rows);
+
+      // The row that the part of a thread ends in is carried out
+      RestrictRow restrictCarry;
+      restrictCarry.positionLoop = positionLoop;
+      restrictCarry.begin = positionBegin;
+      restrictCarry.end = positionEnd;
+      restrictCarry.carryLocs = carryLocs;
+      restrictCarry.carryVals = carryVals;
+      restrictCarry.thread = thread;
+      Stmt carry = restrictCarry.rewrite(op->contents);
+      carry = Block::make(VarDecl::make(row, rowEnd), isa<Scope>(carry)
+                          ? to<Scope>(carry)->scopedStmt : carry);
+      partitionStmts.push_back(IfThenElse::make(Lt::make(rowEnd, numRows),
+          carry, Store::make(carryLocs, thread, ir::Literal::make(-1))));
+      Stmt partitions = For::make(thread, 0, numThreads, 1,
+                                  Block::make(partitionStmts),
+                                  LoopKind::Static, ParallelUnit::CPUThread);
+
+      // The rows that threads carry out are added to the results in order
+      Expr carryLoc = Load::make(carryLocs, thread);
+      Stmt addCarries = For::make(thread, 0, numThreads, 1,
+          IfThenElse::make(Gte::make(carryLoc, 0),
+                           compoundStore(resultStore->arr, carryLoc,
+                                         Load::make(carryVals, thread))));
+
+      Expr items = ir::Add::make(numRows, Load::make(pos, numRows));
+      stmt = Block::make({
+        VarDecl::make(numThreads, ir::Call::make("omp_get_max_threads", {},
+                                                 type)),
+        VarDecl::make(numItems, items),
+        VarDecl::make(chunk, ir::Div::make(ir::Add::make(numItems,
+            ir::Sub::make(numThreads, 1)), numThreads)),
+        VarDecl::make(carryLocs, 0),
+        Allocate::make(carryLocs, numThreads),
+        VarDecl::make(carryVals, 0),
+        Allocate::make(carryVals, numThreads),
+        partitions,
+        addCarries,
+        Free::make(carryLocs),
+        Free::make(carryVals)
+      });
+    }
+  };
+  return PartitionRows(getCoordinateVar(forall.getIndexVar())).rewrite(loops);
+}
+
 bool LowererImplImperative::hasStores(Stmt stmt) {
   if (!stmt.defined()) {
     return false;
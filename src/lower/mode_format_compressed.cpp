@@ -231,6 +231,24 @@ Stmt CompressedModeFormat::getSeqInsertEdge(Expr parentPos,
   return Store::make(posArray, ir::Add::make(parentPos, 1), pos);
 }
 
+Stmt CompressedModeFormat::getParInsertEdge(Expr parentPos,
+    std::vector<Expr> coords, std::vector<AttrQueryResult> queries,
+    Mode mode) const {
+  // Edges are stored as the sizes of segments, which do not depend on each
+  // other, and are turned into positions by a prefix sum
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr nnz = queries[0].getResult(coords, "nnz");
+  return Store::make(posArray, ir::Add::make(parentPos, 1), nnz);
+}
+
+Stmt CompressedModeFormat::getParFinalizeEdges(Expr prevSize,
+    std::vector<AttrQueryResult> queries, Mode mode) const {
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr prefixSum = ir::Call::make("taco_prefixSum",
+                                  {posArray, ir::Add::make(prevSize, 1)}, Int());
+  return Store::make(posArray, prevSize, prefixSum);
+}
+
 Stmt CompressedModeFormat::getInitCoords(Expr prevSize, 
     std::vector<AttrQueryResult> queries, Mode mode) const {
   Expr posArray = getPosArray(mode.getModePack());
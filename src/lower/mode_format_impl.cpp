@@ -269,6 +269,16 @@ Stmt ModeFormatImpl::getSeqInsertEdge(Expr parentPos, std::vector<Expr> coords,
   return Stmt();
 }
 
+Stmt ModeFormatImpl::getParInsertEdge(Expr parentPos, std::vector<Expr> coords,
+    std::vector<AttrQueryResult> queries, Mode mode) const {
+  return Stmt();
+}
+
+Stmt ModeFormatImpl::getParFinalizeEdges(Expr prevSize,
+    std::vector<AttrQueryResult> queries, Mode mode) const {
+  return Stmt();
+}
+
 Stmt ModeFormatImpl::getInitCoords(Expr prevSize, 
     std::vector<AttrQueryResult> queries, Mode mode) const {
   return Stmt();
@@ -0,0 +1,309 @@
+#include "taco/program.h"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <map>
+#include <set>
+#include <tuple>
+
+#include "taco/index_notation/index_notation_nodes.h"
+#include "taco/error.h"
+#include "taco/util/collections.h"
+
+using namespace std;
+
+namespace taco {
+
+/// True iff a tensor is assigned an expression that is yet to be computed.
+static bool isPending(TensorBase tensor) {
+  return !tensor.needsPack() && tensor.needsCompute() &&
+         tensor.getAssignment().defined();
+}
+
+/// Returns the tensors that an expression accesses in the order that they are
+/// accessed, or false if any access is windowed or indexed by an index set.
+static bool getAccessedTensors(IndexExpr expr, vector<TensorVar>* accessed) {
+  bool plain = true;
+  match(expr,
+    function<void(const AccessNode*)>([&](const AccessNode* op) {
+      accessed->push_back(op->tensorVar);
+      plain = plain && op->windowedModes.empty() && op->indexSetModes.empty();
+    })
+  );
+  return plain;
+}
+
+/// True iff two tensors of the same type and format are assigned the same
+/// expression of the same operands, up to the names of index variables.
+static bool computeSameValues(TensorBase a, TensorBase b) {
+  if (a.getComponentType() != b.getComponentType() ||
+      a.getDimensions() != b.getDimensions() ||
+      a.getFormat() != b.getFormat() ||
+      !equals(a.getFillValue(), b.getFillValue())) {
+    return false;
+  }
+
+  vector<TensorVar> accessedA, accessedB;
+  if (!getAccessedTensors(a.getAssignment().getRhs(), &accessedA) ||
+      !getAccessedTensors(b.getAssignment().getRhs(), &accessedB) ||
+      accessedA != accessedB ||
+      util::contains(accessedA, a.getTensorVar()) ||
+      util::contains(accessedA, b.getTensorVar())) {
+    return false;
+  }
+
+  // The operands are accessed in the same order, so an isomorphism of the
+  // assignments maps every operand to itself
+  return isomorphic(a.getAssignment(), b.getAssignment());
+}
+
+
+// class TensorProgram
+TensorProgram::TensorProgram() {
+}
+
+void TensorProgram::addResult(const TensorBase& result) {
+  if (!util::contains(results, result)) {
+    results.push_back(result);
+  }
+}
+
+const std::vector<TensorBase>& TensorProgram::getResults() const {
+  return results;
+}
+
+std::vector<TensorBase> TensorProgram::getPendingTensors() const {
+  vector<TensorBase> sorted;
+  set<TensorBase> visited;
+  function<void(TensorBase)> sort = [&](TensorBase tensor) {
+    if (!isPending(tensor) || util::contains(visited, tensor)) {
+      return;
+    }
+    visited.insert(tensor);
+    for (auto& operand : tensor.getOperands()) {
+      sort(operand.second);
+    }
+    sorted.push_back(tensor);
+  };
+  for (auto& result : results) {
+    sort(result);
+  }
+  return sorted;
+}
+
+void TensorProgram::assignCopy(TensorBase tensor, TensorBase source) {
+  vector<IndexVar> indexVars(tensor.getOrder());
+  Assignment copy(tensor(indexVars), source(indexVars));
+
+  for (auto& operand : tensor.getOperands()) {
+    operand.second.removeDependentTensor(tensor);
+  }
+  source.addDependentTensor(tensor);
+  tensor.setAssignment(copy);
+  tensor.setNeedsCompile(true);
+}
+
+void TensorProgram::restoreAssignment(TensorBase tensor, TensorBase source,
+                                      Assignment assignment) {
+  if (tensor.needsCompute()) {
+    // The tensor is still pending, so it must be synced by its own operands
+    // rather than by the copied tensor
+    source.removeDependentTensor(tensor);
+    tensor.setAssignment(assignment);
+    for (auto& operand : tensor.getOperands()) {
+      operand.second.addDependentTensor(tensor);
+    }
+    tensor.setNeedsCompile(true);
+  }
+  else {
+    // The kernel of the assignment computes the same values as the kernel of
+    // the copied tensor, which is usually cached
+    tensor.setAssignment(assignment);
+    tensor.setNeedsCompile(true);
+    tensor.compile();
+  }
+}
+
+void TensorProgram::release(TensorBase tensor) {
+  const Format format = tensor.getFormat();
+  TensorStorage storage(tensor.getComponentType(), tensor.getDimensions(),
+                        format, tensor.getFillValue());
+  vector<ModeIndex> modeIndices(format.getOrder());
+  for (int i = 0; i < format.getOrder(); ++i) {
+    if (format.getModeFormats()[i].getName() == Dense.getName()) {
+      const size_t idx = format.getModeOrdering()[i];
+      modeIndices[i] = ModeIndex({makeArray({tensor.getDimension(idx)})});
+    }
+  }
+  storage.setIndex(Index(format, modeIndices));
+  tensor.content->storage = storage;
+  tensor.content->valuesSize = 0;
+  tensor.setNeedsAssemble(true);
+  tensor.setNeedsCompute(true);
+
+  // The tensor is recomputed from its operands if it is read again, so changes
+  // to them must first sync it
+  for (auto& operand : tensor.content->planOperands) {
+    operand.addDependentTensor(tensor);
+  }
+}
+
+void TensorProgram::evaluate() {
+  // Pending tensors that no result depends on are never visited
+  vector<TensorBase> tensors = getPendingTensors();
+
+  // Share common subexpressions. A tensor that computes the same values as a
+  // tensor before it is reassigned a copy of it, which is fused into the
+  // tensors that read the copy where possible. The tensor gets its own
+  // assignment back once the program is evaluated.
+  vector<tuple<TensorBase,TensorBase,Assignment>> copies;
+  for (size_t i = 0; i < tensors.size(); i++) {
+    for (size_t j = 0; j < i; j++) {
+      if (computeSameValues(tensors[j], tensors[i])) {
+        copies.emplace_back(tensors[i], tensors[j], tensors[i].getAssignment());
+        assignCopy(tensors[i], tensors[j]);
+        break;
+      }
+    }
+  }
+  if (!copies.empty()) {
+    tensors = getPendingTensors();
+  }
+
+  // Temporaries that are read by one tensor of the program are fused into its
+  // kernel, while results and temporaries that are read by several tensors are
+  // computed on their own.
+  map<TensorBase,size_t> numReaders;
+  for (auto& tensor : tensors) {
+    for (auto& operand : tensor.getOperands()) {
+      if (!(operand.second == tensor)) {
+        numReaders[operand.second]++;
+      }
+    }
+  }
+  set<TensorBase> materialized(results.begin(), results.end());
+  set<TensorVar> unfused;
+  for (auto& tensor : tensors) {
+    if (util::contains(materialized, tensor) || numReaders[tensor] != 1) {
+      materialized.insert(tensor);
+      unfused.insert(tensor.getTensorVar());
+    }
+  }
+
+  // Compile the tensors that read a tensor before that tensor, so that
+  // temporaries that cannot be fused into the kernel that reads them are
+  // known to be computed on their own by the time they are compiled.
+  for (auto it = tensors.rbegin(); it != tensors.rend(); ++it) {
+    TensorBase tensor = *it;
+    if (!util::contains(materialized, tensor)) {
+      continue;
+    }
+    tensor.compile(unfused, true);
+    if (!tensor.content->hasArgumentPlan) {
+      tensor.buildArgumentPlan();
+    }
+    for (auto& operand : tensor.content->planOperands) {
+      if (isPending(operand) && !(operand == tensor)) {
+        materialized.insert(operand);
+        unfused.insert(operand.getTensorVar());
+      }
+    }
+  }
+
+  // Group the tensors into levels that only read tensors of earlier levels,
+  // and count the tensors that read each temporary
+  map<TensorBase,size_t> level;
+  vector<vector<TensorBase>> levels;
+  map<TensorBase,size_t> remainingReaders;
+  for (auto& tensor : tensors) {
+    if (!util::contains(materialized, tensor)) {
+      continue;
+    }
+    size_t tensorLevel = 0;
+    for (auto& operand : tensor.content->planOperands) {
+      if (operand == tensor) {
+        continue;
+      }
+      if (util::contains(level, operand)) {
+        tensorLevel = std::max(tensorLevel, level.at(operand) + 1);
+        remainingReaders[operand]++;
+      }
+      else {
+        // Operands that are not computed by the program are packed up front,
+        // since they cannot be synced concurrently
+        operand.syncValues();
+      }
+    }
+    level.insert({tensor, tensorLevel});
+    if (levels.size() <= tensorLevel) {
+      levels.resize(tensorLevel + 1);
+    }
+    levels[tensorLevel].push_back(tensor);
+  }
+
+  for (auto& levelTensors : levels) {
+    // Kernels that share a module are run by the same thread
+    map<ir::Module*,vector<TensorBase>> groups;
+    for (auto& tensor : levelTensors) {
+      // Operands no longer need to sync the tensor once it is computed, and
+      // are not modified by the threads that compute it
+      for (auto& operand : tensor.content->planOperands) {
+        for (auto& dependent : operand.getDependentTensors()) {
+          if (dependent == tensor) {
+            operand.removeDependentTensor(tensor);
+          }
+        }
+      }
+      groups[tensor.content->module.get()].push_back(tensor);
+    }
+
+    // Packing the arguments of a kernel writes to the storage of its
+    // operands, which kernels of the level may share, so the arguments of
+    // every kernel are packed before any of them runs
+    map<TensorBase,vector<void*>> arguments;
+    for (auto& tensor : levelTensors) {
+      arguments.insert({tensor, tensor.packArguments()});
+    }
+
+    auto run = [&arguments](vector<TensorBase> group) {
+      for (auto& tensor : group) {
+        void** tensorArguments = arguments.at(tensor).data();
+        if (!tensor.getAssignment().getOperator().defined()) {
+          tensor.assemblePacked(tensorArguments);
+        }
+        tensor.computePacked(tensorArguments);
+      }
+    };
+    vector<future<void>> running;
+    for (auto it = groups.begin(); it != groups.end(); ++it) {
+      if (std::next(it) == groups.end()) {
+        run(it->second);
+      }
+      else {
+        running.push_back(std::async(std::launch::async, run, it->second));
+      }
+    }
+    for (auto& future : running) {
+      future.get();
+    }
+
+    // Release the temporaries that every tensor that reads them has read
+    for (auto& tensor : levelTensors) {
+      for (auto& operand : tensor.content->planOperands) {
+        if (util::contains(remainingReaders, operand) &&
+            --remainingReaders.at(operand) == 0 &&
+            !util::contains(results, operand)) {
+          release(operand);
+        }
+      }
+    }
+  }
+
+  for (auto& copy : copies) {
+    restoreAssignment(get<0>(copy), get<1>(copy), get<2>(copy));
+  }
+}
+
+}
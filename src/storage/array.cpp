@@ -1,5 +1,6 @@
 #include "taco/storage/array.h"
 
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
@@ -15,8 +16,8 @@ namespace taco {
 
 struct Array::Content : util::Uncopyable {
   Datatype   type;
-  void*  data;
-  size_t size;
+  void*  data = nullptr;
+  size_t size = 0;
   Policy policy = Array::UserOwns;
 
   ~Content() {
@@ -214,7 +215,13 @@ Array makeArray(Datatype type, size_t size) {
     return Array(type, cuda_unified_alloc(size * type.getNumBytes()), size, Array::Free);
   }
   else {
-    return Array(type, malloc(size * type.getNumBytes()), size, Array::Free);
+    // Aligned arrays can be freed with free
+    void* data = nullptr;
+    if (posix_memalign(&data, ARRAY_ALIGNMENT,
+                       size * type.getNumBytes()) != 0) {
+      data = nullptr;
+    }
+    return Array(type, data, size, Array::Free);
   }
 }
 
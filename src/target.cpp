@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "taco/target.h"
+#include "taco/util/env.h"
 
 using namespace std;
 
@@ -25,7 +26,9 @@ bool parseTargetString(Target& target, string target_string) {
   while (current_pos != string::npos) {
     tokens.push_back(rest.substr(0, current_pos));
     rest = rest.substr(current_pos+1);
+    current_pos = rest.find('-');
   }
+  tokens.push_back(rest);
   
   // now parse the tokens
   taco_uassert(tokens.size() >= 2) <<
@@ -49,7 +52,7 @@ bool parseTargetString(Target& target, string target_string) {
 } // anonymous namespace
 
 Target::Target(const std::string &s) {
-  parseTargetString(*this, s);
+  taco_uassert(parseTargetString(*this, s)) << "Invalid target string: " << s;
 }
 
 
@@ -76,6 +79,10 @@ bool Target::validateTargetString(const string &s) {
 }
 
 Target getTargetFromEnvironment() {
+  std::string target = util::getFromEnv("TACO_TARGET", "");
+  if (!target.empty()) {
+    return Target(target);
+  }
   return Target(Target::Arch::C99, Target::OS::MacOS);
 }
 } // namespace taco
@@ -1,11 +1,13 @@
 #include "taco/tensor.h"
 
+#include <algorithm>
 #include <set>
 #include <cstring>
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
 #include <climits>
+#include <cstdint>
 #include <vector>
 #include <utility>
 #include <mutex>
@@ -15,6 +17,7 @@
 #include "taco/taco_tensor_t.h"
 #include "taco/codegen/module.h"
 #include "taco/error/error_messages.h"
+#include "taco/index_notation/autotune.h"
 #include "taco/index_notation/index_notation.h"
 #include "taco/index_notation/index_notation_nodes.h"
 //#include "codegen/codegen_c.h"
@@ -34,6 +37,7 @@
 #include "taco/storage/file_io_rb.h"
 #include "taco/storage/typed_vector.h"
 #include "taco/util/collections.h"
+#include "taco/util/env.h"
 #include "taco/util/strings.h"
 #include "taco/util/timers.h"
 #include "taco/util/name_generator.h"
@@ -144,6 +148,9 @@ TensorBase::TensorBase(string name, Datatype ctype, vector<int> dimensions,
   content->needsCompile = false;
   content->needsAssemble = false;
   content->needsCompute = false;
+  content->hasArgumentPlan = false;
+  content->hasParallelSchedule = false;
+  content->chunkSize = 0;
 
   content->coordinateBuffer = shared_ptr<vector<char>>(new vector<char>);
   content->coordinateBufferUsed = 0;
@@ -249,6 +256,13 @@ void TensorBase::setAssembleWhileCompute(bool assembleWhileCompute) {
   content->assembleWhileCompute = assembleWhileCompute;
 }
 
+void TensorBase::specializeDimensions(const std::set<IndexVar>& indexVars) {
+  if (indexVars != content->specializedIndexVars) {
+    content->specializedIndexVars = indexVars;
+    setNeedsCompile(true);
+  }
+}
+
 static size_t numIntegersToCompare = 0;
 static int lexicographicalCmp(const void* a, const void* b) {
   for (size_t i = 0; i < numIntegersToCompare; i++) {
@@ -580,13 +594,15 @@ const Access TensorBase::operator()() const {
 TensorBase::KernelsCache TensorBase::computeKernels;
 std::mutex TensorBase::computeKernelsMutex;
 
-std::shared_ptr<Module> TensorBase::getComputeKernel(const IndexStmt stmt) {
+std::shared_ptr<Module> TensorBase::getComputeKernel(
+    const IndexStmt stmt, const vector<int>& specializedDimensions) {
   computeKernelsMutex.lock();
   const auto computeKernelsReverse =
       util::ReverseConstIterable<TensorBase::KernelsCache>(computeKernels);
   for (const auto& computeKernel : computeKernelsReverse) {
-    if (isomorphic(stmt, computeKernel.first)) {
-      const auto kernelModule = computeKernel.second;
+    if (specializedDimensions == std::get<1>(computeKernel) &&
+        isomorphic(stmt, std::get<0>(computeKernel))) {
+      const auto kernelModule = std::get<2>(computeKernel);
       computeKernelsMutex.unlock();
       return kernelModule;
     }
@@ -596,13 +612,75 @@ std::shared_ptr<Module> TensorBase::getComputeKernel(const IndexStmt stmt) {
 }
 
 void TensorBase::cacheComputeKernel(const IndexStmt stmt,
+                                    const vector<int>& specializedDimensions,
                                     const std::shared_ptr<Module> kernel) {
   computeKernelsMutex.lock();
-  computeKernels.emplace_back(stmt, kernel);
+  computeKernels.emplace_back(stmt, specializedDimensions, kernel);
   computeKernelsMutex.unlock();
 }
 
+/// Collect the assignments of the operands of an expression that are yet to be
+/// computed, and recursively of their operands, along with the tensors that
+/// they read. Operands in unfused are not collected.
+static void getPendingProducers(const TensorVar& result, const IndexExpr& expr,
+                                const set<TensorVar>& unfused,
+                                map<TensorVar,Assignment>* producers,
+                                map<TensorVar,TensorBase>* tensors) {
+  for (auto& operand : getTensors(expr)) {
+    tensors->insert(operand);
+    TensorBase tensor = operand.second;
+    if (operand.first == result || util::contains(*producers, operand.first) ||
+        util::contains(unfused, operand.first) ||
+        tensor.needsPack() || !tensor.needsCompute() ||
+        !tensor.getAssignment().defined()) {
+      continue;
+    }
+    producers->insert({operand.first, tensor.getAssignment()});
+    getPendingProducers(result, tensor.getAssignment().getRhs(), unfused,
+                        producers, tensors);
+  }
+}
+
+/// Summarize the sparsity structure of the packed operands of an expression
+/// for the cost model of the autoscheduler.
+static map<TensorVar, TensorStatistics> getStatistics(const IndexExpr& expr) {
+  map<TensorVar, TensorStatistics> statistics;
+  for (auto& operand : getTensors(expr)) {
+    TensorBase tensor = operand.second;
+    const Format& format = tensor.getFormat();
+    const Index& index = tensor.getStorage().getIndex();
+    if (tensor.needsPack() || index.numModeIndices() != tensor.getOrder()) {
+      continue;
+    }
+
+    TensorStatistics tensorStatistics;
+    size_t levelSize = 1;
+    for (int level = 0; level < tensor.getOrder(); level++) {
+      ModeFormat modeFormat = format.getModeFormats()[level];
+      const ModeIndex& modeIndex = index.getModeIndex(level);
+      if (modeFormat.isFull()) {
+        levelSize *= tensor.getDimension(format.getModeOrdering()[level]);
+      }
+      else if (modeFormat.getName() == "compressed" &&
+               modeIndex.numIndexArrays() > 0 &&
+               modeIndex.getIndexArray(0).getSize() > levelSize) {
+        // The last position of a compressed level is its number of coordinates
+        levelSize = modeIndex.getIndexArray(0).get(levelSize).getAsIndex();
+      }
+      tensorStatistics.levelSizes.push_back(levelSize);
+    }
+    statistics.insert({operand.first, tensorStatistics});
+  }
+  return statistics;
+}
+
 void TensorBase::compile() {
+  // Fusing operands changes when they are computed, so it is opt-in
+  compile(set<TensorVar>(), util::getFromEnv("TACO_FUSE", "0") != "0");
+}
+
+void TensorBase::compile(const std::set<TensorVar>& unfusedOperands,
+                         bool fuseOperands) {
   Assignment assignment = getAssignment();
   taco_uassert(assignment.defined())
       << error::compile_without_expr;
@@ -634,27 +712,232 @@ void TensorBase::compile() {
   assignment.getLhs().accept(&dupes);
   assignment.accept(&dupes);
 
+  // Fuse the computations of operands that are yet to be computed into the
+  // kernel, so that their values need not be stored
+  if ((needsCompile() || content->fusedStmt.defined()) && fuseOperands) {
+    map<TensorVar,Assignment> producers;
+    map<TensorVar,TensorBase> tensors;
+    getPendingProducers(getTensorVar(), assignment.getRhs(), unfusedOperands,
+                        &producers, &tensors);
+    IndexStmt fused = producers.empty()
+                      ? IndexStmt() : fuseAssignments(assignment, producers);
+
+    // Whether operands can be fused depends on whether they have been
+    // computed, so a fused kernel is only reused if it fuses the same
+    // computations and reads the same tensors.
+    if (!needsCompile() &&
+        !(fused.defined() &&
+          getArguments(fused) == getArguments(content->fusedStmt) &&
+          producers.size() == content->fusedProducers.size() &&
+          std::equal(producers.begin(), producers.end(),
+                     content->fusedProducers.begin(),
+                     [](const pair<const TensorVar,Assignment>& a,
+                        const pair<const TensorVar,Assignment>& b) {
+                       return a.first == b.first &&
+                              equals(a.second, b.second);
+                     }))) {
+      setNeedsCompile(true);
+    }
+
+    if (needsCompile() && fused.defined()) {
+      compile(parallelizeOuterLoop(fused), content->assembleWhileCompute);
+      for (auto& argument : getArguments(fused)) {
+        content->fusedOperands.insert({argument, tensors.at(argument)});
+      }
+      content->fusedStmt = fused;
+      content->fusedProducers = producers;
+      content->hasArgumentPlan = false;
+    }
+
+    if (!needsCompile()) {
+      // The fused kernel reads the producers' operands, so changes to them
+      // must first sync this tensor
+      if (needsCompute()) {
+        const auto operands = getTensors(assignment.getRhs());
+        for (auto& operand : content->fusedOperands) {
+          if (!util::contains(operands, operand.first)) {
+            operand.second.addDependentTensor(*this);
+          }
+        }
+      }
+      return;
+    }
+  }
+
   IndexStmt stmt = makeConcreteNotation(makeReductionNotation(assignment));
-  stmt = reorderLoopsTopologically(stmt);
-  stmt = insertTemporaries(stmt);
-  stmt = parallelizeOuterLoop(stmt);
+  const auto statistics = getStatistics(assignment.getRhs());
+
+  // Use the schedule found by the autotuner, if there is one
+  TunedSchedule tuned;
+  if (findTunedSchedule(getTuningKey(assignment, statistics), &tuned)) {
+    IndexStmt tunedStmt = tuned.apply(stmt);
+    if (tunedStmt.defined()) {
+      compile(tunedStmt, content->assembleWhileCompute);
+      if (tuned.parallelize) {
+        content->hasParallelSchedule = true;
+        content->parallelSchedule = tuned.parallelSchedule;
+        content->chunkSize = tuned.chunkSize;
+      }
+      return;
+    }
+  }
+
+  if (util::getFromEnv("TACO_AUTOSCHEDULE", "0") != "0") {
+    // Products of several operands are contracted two at a time when that is
+    // estimated to be cheaper than a single loop nest
+    IndexStmt contracted = optimizeContractionOrder(assignment, statistics);
+    if (contracted.defined()) {
+      stmt = contracted;
+    }
+    else {
+      IndexStmt simplified =
+          simplifyAlgebraically(makeReductionNotation(assignment));
+      stmt = autoschedule(makeConcreteNotation(simplified), statistics);
+    }
+  }
+  else {
+    stmt = reorderLoopsTopologically(stmt);
+    stmt = insertTemporaries(stmt);
+    stmt = parallelizeOuterLoop(stmt);
+  }
   compile(stmt, content->assembleWhileCompute);
 }
 
+TunedSchedule TensorBase::autotune(size_t maxCandidates) {
+  Assignment assignment = getAssignment();
+  taco_uassert(assignment.defined())
+      << error::compile_without_expr;
+
+  // Candidates are timed on the operands, so they must be packed
+  for (auto& operand : getTensors(assignment.getRhs())) {
+    operand.second.syncValues();
+  }
+  const auto statistics = getStatistics(assignment.getRhs());
+  IndexStmt stmt = makeConcreteNotation(makeReductionNotation(assignment));
+  const vector<TunedSchedule> candidates =
+      getScheduleCandidates(stmt, statistics, maxCandidates);
+
+  // Compound assignments accumulate into the result, so its values are
+  // restored before every timed run and after tuning
+  const bool accumulates = assignment.getOperator().defined();
+  vector<char> resultValues;
+  auto restoreResultValues = [&]() {
+    if (!resultValues.empty()) {
+      memcpy(getStorage().getValues().getData(), resultValues.data(),
+             resultValues.size());
+    }
+  };
+  if (accumulates) {
+    const Array values = getStorage().getValues();
+    const char* data = static_cast<const char*>(values.getData());
+    resultValues.assign(data, data +
+                        values.getSize() * values.getType().getNumBytes());
+  }
+
+  TunedSchedule best;
+  double bestTime = 0.0;
+  for (auto& candidate : candidates) {
+    setNeedsCompile(true);
+    compile(candidate.apply(stmt), content->assembleWhileCompute);
+    if (candidate.parallelize) {
+      content->hasParallelSchedule = true;
+      content->parallelSchedule = candidate.parallelSchedule;
+      content->chunkSize = candidate.chunkSize;
+    }
+
+    util::Timer timer;
+    for (int run = 0; run < 3; run++) {
+      setNeedsAssemble(true);
+      setNeedsCompute(true);
+      restoreResultValues();
+      timer.start();
+      if (!accumulates) {
+        assemble();
+      }
+      compute();
+      timer.stop();
+    }
+    const double time = timer.getResult().median;
+    if (best.loopOrder.empty() || time < bestTime) {
+      best = candidate;
+      bestTime = time;
+    }
+  }
+
+  if (!candidates.empty()) {
+    recordTunedSchedule(getTuningKey(assignment, statistics), best);
+  }
+  restoreResultValues();
+  setNeedsCompile(true);
+  setNeedsAssemble(true);
+  setNeedsCompute(true);
+  compile();
+  return best;
+}
+
+/// Get the fixed dimensions of the modes that an index statement accesses with
+/// the given index variables. The dimensions are also listed in the order in
+/// which the statement accesses the modes, with -1 for modes that are not
+/// specialized, and that list is empty if no mode is specialized.
+static map<TensorVar,map<int,int>>
+getSpecializedDimensions(IndexStmt stmt, const set<IndexVar>& indexVars,
+                         vector<int>* specializedDimensions) {
+  map<TensorVar,map<int,int>> dimensions;
+  if (indexVars.empty()) {
+    return dimensions;
+  }
+  match(stmt,
+    function<void(const AccessNode*)>([&](const AccessNode* op) {
+      const Shape shape = op->tensorVar.getType().getShape();
+      for (size_t mode = 0; mode < op->indexVars.size(); mode++) {
+        const Dimension dimension = shape.getDimension(mode);
+        if (!util::contains(indexVars, op->indexVars[mode]) ||
+            !dimension.isFixed() || util::contains(op->windowedModes, (int)mode) ||
+            util::contains(op->indexSetModes, (int)mode)) {
+          specializedDimensions->push_back(-1);
+          continue;
+        }
+        dimensions[op->tensorVar][mode] = (int)dimension.getSize();
+        specializedDimensions->push_back((int)dimension.getSize());
+      }
+    })
+  );
+  if (dimensions.empty()) {
+    specializedDimensions->clear();
+  }
+  return dimensions;
+}
+
 void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
   if (!needsCompile()) {
     return;
   }
   setNeedsCompile(false);
+  content->compiledStmt = stmt;
+  content->hasArgumentPlan = false;
+  content->hasParallelSchedule = false;
+  if (content->fusedStmt.defined()) {
+    content->fusedStmt = IndexStmt();
+    content->fusedProducers.clear();
+    content->fusedOperands.clear();
+  }
 
   IndexStmt concretizedAssign = stmt;
   IndexStmt stmtToCompile = stmt.concretize();
   stmtToCompile = scalarPromote(stmtToCompile);
 
+  // Specialized kernels are cached apart from unspecialized ones, and from
+  // kernels that are specialized to other dimensions
+  vector<int> specializedDimensions;
+  const auto dimensions =
+      getSpecializedDimensions(stmtToCompile, content->specializedIndexVars,
+                               &specializedDimensions);
+
   if (!std::getenv("CACHE_KERNELS") ||
       std::string(std::getenv("CACHE_KERNELS")) != "0") {
     concretizedAssign = stmtToCompile;
-    const auto cachedKernel = getComputeKernel(concretizedAssign);
+    const auto cachedKernel = getComputeKernel(concretizedAssign,
+                                               specializedDimensions);
     if (cachedKernel) {
       content->module = cachedKernel;
       return;
@@ -663,6 +946,12 @@ void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
 
   content->assembleFunc = lower(stmtToCompile, "assemble", true, false);
   content->computeFunc = lower(stmtToCompile, "compute",  assembleWhileCompute, true);
+  if (!dimensions.empty()) {
+    content->assembleFunc =
+        taco::specializeDimensions(content->assembleFunc, dimensions);
+    content->computeFunc =
+        taco::specializeDimensions(content->computeFunc, dimensions);
+  }
   // If we have to recompile the kernel, we need to create a new Module. Since
   // the module we are holding on to could have been retrieved from the cache,
   // we can't modify it.
@@ -670,7 +959,8 @@ void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
   content->module->addFunction(content->assembleFunc);
   content->module->addFunction(content->computeFunc);
   content->module->compile();
-  cacheComputeKernel(concretizedAssign, content->module);
+  cacheComputeKernel(concretizedAssign, specializedDimensions,
+                     content->module);
 }
 
 taco_tensor_t* TensorBase::getTacoTensorT() {
@@ -737,6 +1027,10 @@ void TensorBase::syncDependentTensors() {
   content->dependentTensors.clear();
 }
 
+map<TensorVar,TensorBase> TensorBase::getOperands() const {
+  return getTensors(getAssignment().getRhs());
+}
+
 static inline map<TensorVar, TensorBase> getTensors(const IndexExpr& expr) {
   struct GetOperands : public IndexNotationVisitor {
     using IndexNotationVisitor::visit;
@@ -775,33 +1069,95 @@ static inline map<TensorVar, TensorBase> getTensors(const IndexExpr& expr) {
   return getOperands.arguments;
 }
 
-static inline
-vector<void*> packArguments(const TensorBase& tensor) {
-  vector<void*> arguments;
+void TensorBase::buildArgumentPlan() {
+  content->planOperands.clear();
+  content->planArguments.clear();
 
-  // Pack the result tensor
-  arguments.push_back(tensor.getStorage());
-
-  // Pack any index sets on the result tensor at the front of the arguments list.
-  auto lhs = getNode(tensor.getAssignment().getLhs());
+  // Index sets on the result tensor are packed at the front of the arguments.
+  auto lhs = getNode(getAssignment().getLhs());
   // We check isa<AccessNode> rather than isa<AccessTensorNode> to catch cases
   // where the underlying access is represented with the base AccessNode class.
   if (isa<AccessNode>(lhs)) {
     auto indexSetModes = to<AccessNode>(lhs)->indexSetModes;
     for (auto& it : indexSetModes) {
-      arguments.push_back(it.second.tensor.getStorage());
+      content->planArguments.push_back(it.second.tensor);
     }
   }
 
-  // Pack operand tensors
-  auto operands = getArguments(makeConcreteNotation(tensor.getAssignment()));
-
-  auto tensors = getTensors(tensor.getAssignment().getRhs());
+  // Operand tensors follow in the order of the kernel's parameters.
+  const bool fused = content->fusedStmt.defined();
+  auto operands = getArguments(content->compiledStmt.defined()
+                               ? content->compiledStmt
+                               : makeConcreteNotation(getAssignment()));
+  auto tensors = fused ? content->fusedOperands
+                       : getTensors(getAssignment().getRhs());
   for (auto& operand : operands) {
     taco_iassert(util::contains(tensors, operand));
-    arguments.push_back(tensors.at(operand).getStorage());
+    content->planArguments.push_back(tensors.at(operand));
+  }
+  for (auto& tensor : tensors) {
+    content->planOperands.push_back(tensor.second);
   }
+  content->hasArgumentPlan = true;
+}
 
+/// Get the address ranges of the non-empty arrays of a tensor storage.
+static vector<pair<uintptr_t,uintptr_t>>
+getArrays(const TensorStorage& storage) {
+  vector<pair<uintptr_t,uintptr_t>> arrays;
+  auto addArray = [&](const Array& array) {
+    uintptr_t data = reinterpret_cast<uintptr_t>(array.getData());
+    if (data != 0 && array.getSize() > 0) {
+      arrays.push_back({data,
+                        data + array.getSize() * array.getType().getNumBytes()});
+    }
+  };
+  const Index& index = storage.getIndex();
+  for (int i = 0; i < index.numModeIndices(); i++) {
+    const ModeIndex& modeIndex = index.getModeIndex(i);
+    for (int j = 0; j < modeIndex.numIndexArrays(); j++) {
+      addArray(modeIndex.getIndexArray(j));
+    }
+  }
+  addArray(storage.getValues());
+  return arrays;
+}
+
+vector<void*> TensorBase::packArguments() {
+  if (!content->hasArgumentPlan) {
+    buildArgumentPlan();
+  }
+
+  // Generated kernels access the arrays of their tensors through restrict
+  // pointers, so the arrays of the result must not alias those of operands.
+  // The arrays of the operands follow those of the result, separated by empty
+  // ranges.
+  vector<pair<uintptr_t,uintptr_t>> arrays = getArrays(getStorage());
+  const size_t numResultArrays = arrays.size();
+  for (auto& tensor : content->planArguments) {
+    if (!(tensor == *this)) {
+      auto operandArrays = getArrays(tensor.getStorage());
+      arrays.push_back({0, 0});
+      arrays.insert(arrays.end(), operandArrays.begin(), operandArrays.end());
+    }
+  }
+  if (arrays != content->checkedArrays) {
+    for (size_t i = 0; i < numResultArrays; i++) {
+      for (size_t j = numResultArrays; j < arrays.size(); j++) {
+        taco_uassert(arrays[i].second <= arrays[j].first ||
+                     arrays[j].second <= arrays[i].first)
+            << error::compute_aliased_operand;
+      }
+    }
+    content->checkedArrays = arrays;
+  }
+
+  vector<void*> arguments;
+  arguments.reserve(content->planArguments.size() + 1);
+  arguments.push_back(getStorage());
+  for (auto& tensor : content->planArguments) {
+    arguments.push_back(tensor.getStorage());
+  }
   return arguments;
 }
 
@@ -810,14 +1166,20 @@ void TensorBase::assemble() {
   if (!needsAssemble()) {
     return;
   }
+  if (!content->hasArgumentPlan) {
+    buildArgumentPlan();
+  }
   // Sync operand tensors if needed.
-  auto operands = getTensors(getAssignment().getRhs());
-  for (auto& operand : operands) {
-    operand.second.syncValues();
+  for (auto& operand : content->planOperands) {
+    operand.syncValues();
   }
 
-  auto arguments = packArguments(*this);
-  content->module->callFuncPacked("assemble", arguments.data());
+  auto arguments = packArguments();
+  assemblePacked(arguments.data());
+}
+
+void TensorBase::assemblePacked(void** arguments) {
+  callKernel("assemble", arguments);
 
   if (!content->assembleWhileCompute) {
     setNeedsAssemble(false);
@@ -832,15 +1194,22 @@ void TensorBase::compute() {
     return;
   }
   setNeedsCompute(false);
+  if (!content->hasArgumentPlan) {
+    buildArgumentPlan();
+  }
   // Sync operand tensors if needed.
-  auto operands = getTensors(getAssignment().getRhs());
-  for (auto& operand : operands) {
-    operand.second.syncValues();
-    operand.second.removeDependentTensor(*this);
+  for (auto& operand : content->planOperands) {
+    operand.syncValues();
+    operand.removeDependentTensor(*this);
   }
 
-  auto arguments = packArguments(*this);
-  this->content->module->callFuncPacked("compute", arguments.data());
+  auto arguments = packArguments();
+  computePacked(arguments.data());
+}
+
+void TensorBase::computePacked(void** arguments) {
+  setNeedsCompute(false);
+  callKernel("compute", arguments);
 
   if (content->assembleWhileCompute) {
     setNeedsAssemble(false);
@@ -857,6 +1226,51 @@ void TensorBase::evaluate() {
   this->compute();
 }
 
+PreparedExecution TensorBase::prepare() {
+  taco_uassert(!content->assembleWhileCompute)
+      << "Cannot prepare the execution of a tensor that is assembled while "
+      << "it is computed";
+  evaluate();
+
+  PreparedExecution prepared;
+  prepared.result = *this;
+  prepared.module = content->module;
+  prepared.computeFunc = content->module->getFuncPtrSlot("_shim_compute");
+  prepared.arguments = packArguments();
+  prepared.hasParallelSchedule = content->hasParallelSchedule;
+  prepared.parallelSchedule = content->parallelSchedule;
+  prepared.chunkSize = content->chunkSize;
+  return prepared;
+}
+
+int TensorBase::callKernel(std::string name, void** arguments) {
+  void* kernel = content->module->getFuncPtr("_shim_" + name);
+  if (content->hasParallelSchedule) {
+    return content->module->callFuncPtr(kernel, arguments,
+                                        content->parallelSchedule,
+                                        content->chunkSize);
+  }
+  return content->module->callFuncPtr(kernel, arguments);
+}
+
+PreparedExecution::PreparedExecution()
+    : computeFunc(nullptr), hasParallelSchedule(false), chunkSize(0) {
+}
+
+bool PreparedExecution::operator()() {
+  taco_uassert(defined()) << "Cannot invoke an undefined prepared execution";
+  void* func = computeFunc->load(std::memory_order_acquire);
+  if (hasParallelSchedule) {
+    return module->callFuncPtr(func, arguments.data(), parallelSchedule,
+                               chunkSize) == 0;
+  }
+  return module->callFuncPtr(func, arguments.data()) == 0;
+}
+
+bool PreparedExecution::defined() const {
+  return computeFunc != nullptr;
+}
+
 void TensorBase::operator=(const IndexExpr& expr) {
   taco_uassert(getOrder() == 0)
       << "Must use index variable on the left-hand-side when assigning an "
@@ -882,6 +1296,9 @@ void TensorBase::operator=(const IndexExpr& expr) {
 
 void TensorBase::setAssignment(Assignment assignment) {
   content->assignment = makeReductionNotation(assignment);
+  content->hasArgumentPlan = false;
+  content->planOperands.clear();
+  content->planArguments.clear();
 }
 
 Assignment TensorBase::getAssignment() const {
@@ -927,6 +1344,14 @@ void TensorBase::compileSource(std::string source) {
   content->module->setSource(source + "\n" + ss.str());
   content->module->compile();
   setNeedsCompile(false);
+  content->compiledStmt = stmt;
+  content->hasArgumentPlan = false;
+  content->hasParallelSchedule = false;
+  if (content->fusedStmt.defined()) {
+    content->fusedStmt = IndexStmt();
+    content->fusedProducers.clear();
+    content->fusedOperands.clear();
+  }
 }
 
 TensorBase::HelperFuncsCache TensorBase::helperFunctions;
@@ -2,6 +2,8 @@
 #include <ftw.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <cstdlib>
+#include <fstream>
 
 namespace taco {
 namespace util {
@@ -16,6 +18,38 @@ static int unlink_cb(const char *fpath, const struct stat *sb, int typeflag, str
     return rv;
 }
 
+size_t getCacheSize(int level) {
+  const std::string cacheDir = "/sys/devices/system/cpu/cpu0/cache/";
+  for (int index = 0; ; index++) {
+    const std::string indexDir = cacheDir + "index" + std::to_string(index) + "/";
+    std::ifstream levelFile(indexDir + "level");
+    if (!levelFile) {
+      return 0;
+    }
+    int cacheLevel;
+    std::string type, size;
+    levelFile >> cacheLevel;
+    std::ifstream(indexDir + "type") >> type;
+    std::ifstream(indexDir + "size") >> size;
+    if (cacheLevel != level || type == "Instruction" || size.empty()) {
+      continue;
+    }
+
+    // Sizes are reported as, for example, 32K or 8M
+    size_t bytes = std::strtoull(size.c_str(), nullptr, 10);
+    switch (size.back()) {
+      case 'K':
+        return bytes << 10;
+      case 'M':
+        return bytes << 20;
+      case 'G':
+        return bytes << 30;
+      default:
+        return bytes;
+    }
+  }
+}
+
 void cachedtmpdirCleanup(void) {
   if (cachedtmpdir != ""){
     int rv = nftw(cachedtmpdir.c_str(), unlink_cb, 64, FTW_DEPTH | FTW_PHYS);
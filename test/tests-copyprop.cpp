@@ -13,6 +13,9 @@ using taco::ir::Neg;
 using taco::ir::Add;
 using taco::ir::While;
 using taco::ir::Scope;
+using taco::ir::For;
+using taco::ir::Mul;
+using taco::ir::isa;
 
 TEST(expr, simplify_copy) {
   auto a = Var::make("a", Int32), 
@@ -76,3 +79,66 @@ TEST(expr, simplify_dont_copy_loop_dependent_var) {
   ASSERT_EQ(simplifiedInc->lhs, b);
   ASSERT_EQ(simplifiedInc->rhs.as<Add>()->a, b);
 }
+
+TEST(expr, simplify_hoist_loop_invariant) {
+  auto i = Var::make("i", Int32),
+       n = Var::make("n", Int32),
+       a = Var::make("a", Int32),
+       s = Var::make("s", Int32),
+       t = Var::make("t", Int32);
+
+  auto tDecl = VarDecl::make(t, Add::make(a, 1)),
+       sInc = Assign::make(s, Add::make(s, t)),
+       loop = For::make(i, 0, n, 1, Block::make(tDecl, sInc));
+
+  auto simplified = simplify(loop);
+  auto *simplifiedBlock = simplified.as<Block>();
+  ASSERT_NE(simplifiedBlock, nullptr);
+  ASSERT_EQ(simplifiedBlock->contents.size(), size_t(2));
+
+  // The declaration of `t' does not depend on `i' so it is hoisted
+  auto *hoisted = simplifiedBlock->contents[0].as<Block>();
+  ASSERT_NE(hoisted, nullptr);
+  ASSERT_EQ(hoisted->contents.size(), size_t(1));
+  ASSERT_EQ(hoisted->contents[0].as<VarDecl>()->var, t);
+
+  auto *simplifiedLoop = simplifiedBlock->contents[1].as<For>();
+  auto *simplifiedBody =
+      simplifiedLoop->contents.as<Scope>()->scopedStmt.as<Block>();
+  ASSERT_EQ(simplifiedBody->contents.size(), size_t(1));
+  ASSERT_TRUE(isa<Assign>(simplifiedBody->contents[0]));
+}
+
+TEST(expr, simplify_reduce_strength) {
+  auto i = Var::make("i", Int32),
+       n = Var::make("n", Int32),
+       a = Var::make("a", Int32),
+       s = Var::make("s", Int32);
+
+  auto sInc = Assign::make(s, Add::make(s, Mul::make(i, a))),
+       loop = For::make(i, 0, n, 1, sInc);
+
+  auto simplified = simplify(loop);
+  auto *simplifiedBlock = simplified.as<Block>();
+  ASSERT_NE(simplifiedBlock, nullptr);
+  ASSERT_EQ(simplifiedBlock->contents.size(), size_t(2));
+
+  // `i * a' is replaced by a variable that starts at 0 and is incremented by
+  // `a' at the end of every iteration
+  auto *hoisted = simplifiedBlock->contents[0].as<Block>();
+  ASSERT_EQ(hoisted->contents.size(), size_t(1));
+  auto *ia = hoisted->contents[0].as<VarDecl>();
+  ASSERT_NE(ia, nullptr);
+  ASSERT_EQ(ia->var.as<Var>()->name, "i_a");
+
+  auto *simplifiedLoop = simplifiedBlock->contents[1].as<For>();
+  auto *simplifiedBody =
+      simplifiedLoop->contents.as<Scope>()->scopedStmt.as<Block>();
+  ASSERT_EQ(simplifiedBody->contents.size(), size_t(2));
+  auto *simplifiedInc = simplifiedBody->contents[0].as<Assign>();
+  ASSERT_EQ(simplifiedInc->rhs.as<Add>()->b, ia->var);
+  auto *iaInc =
+      simplifiedBody->contents[1].as<Block>()->contents[0].as<Assign>();
+  ASSERT_EQ(iaInc->lhs, ia->var);
+  ASSERT_EQ(iaInc->rhs.as<Add>()->b, a);
+}
@@ -0,0 +1,244 @@
+#include "test.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "taco/tensor.h"
+#include "taco/codegen/module.h"
+#include "taco/index_notation/index_notation.h"
+#include "taco/index_notation/transformations.h"
+#include "taco/lower/lower.h"
+
+using namespace taco;
+
+static std::shared_ptr<ir::Module> makeSquareModule(Tensor<double>& a,
+                                                    Tensor<double>& b) {
+  IndexVar i("i");
+  a(i) = b(i) * b(i);
+  IndexStmt stmt = makeConcreteNotation(a.getAssignment());
+  auto module = std::make_shared<ir::Module>();
+  module->addFunction(lower(stmt, "compute", true, true));
+  return module;
+}
+
+TEST(module, multiversioned) {
+  Tensor<double> b("b", {4}, Format({Dense}));
+  for (int i = 0; i < 4; i++) {
+    b.insert({i}, (double)i);
+  }
+  b.pack();
+  Tensor<double> a("a", {4}, Format({Dense}));
+
+  auto module = makeSquareModule(a, b);
+  module->setMultiVersioned(true);
+  module->compile();
+
+  // The most capable variant that the host supports is loaded
+  ir::KernelISA expected = ir::KernelISA::Generic;
+  for (ir::KernelISA isa : {ir::KernelISA::AVX2, ir::KernelISA::AVX512}) {
+    if (ir::isKernelISASupported(isa)) {
+      expected = isa;
+    }
+  }
+  ASSERT_EQ(expected, module->getISA());
+
+  // Every variant that the host supports computes the same values
+  for (ir::KernelISA isa : {ir::KernelISA::Generic, ir::KernelISA::AVX2,
+                            ir::KernelISA::AVX512}) {
+    if (!module->loadISA(isa)) {
+      ASSERT_LT((int)expected, (int)isa);
+      continue;
+    }
+    ASSERT_EQ(isa, module->getISA());
+
+    taco_tensor_t* result = a.getTacoTensorT();
+    module->callFuncPacked("compute", {result, b.getTacoTensorT()});
+    double* vals = (double*)result->vals;
+    for (int i = 0; i < 4; i++) {
+      ASSERT_DOUBLE_EQ((double)(i*i), vals[i]);
+      vals[i] = 0.0;
+    }
+  }
+}
+
+TEST(module, generic_by_default) {
+  Tensor<double> b("b", {4}, Format({Dense}));
+  b.pack();
+  Tensor<double> a("a", {4}, Format({Dense}));
+
+  auto module = makeSquareModule(a, b);
+  module->setMultiVersioned(false);
+  module->compile();
+  ASSERT_EQ(ir::KernelISA::Generic, module->getISA());
+}
+
+TEST(module, profile_guided) {
+  Tensor<double> b("b", {4}, Format({Dense}));
+  for (int i = 0; i < 4; i++) {
+    b.insert({i}, (double)i);
+  }
+  b.pack();
+  Tensor<double> a("a", {4}, Format({Dense}));
+
+  auto module = makeSquareModule(a, b);
+  module->setProfileGuided(2);
+  module->compile();
+  ASSERT_TRUE(module->isCollectingProfile());
+
+  // The optimized library is built after the second training call, and
+  // optimizeWithProfile waits for it to be swapped in.
+  taco_tensor_t* result = a.getTacoTensorT();
+  const std::atomic<void*>* compute = module->getFuncPtrSlot("_shim_compute");
+  ASSERT_NE(nullptr, compute);
+  for (int run = 0; run < 3; run++) {
+    if (run == 2) {
+      module->optimizeWithProfile();
+    }
+    void* args[] = {result, b.getTacoTensorT()};
+    module->callFuncPtr(compute->load(), args);
+    ASSERT_EQ(run == 0, module->isCollectingProfile());
+    double* vals = (double*)result->vals;
+    for (int i = 0; i < 4; i++) {
+      ASSERT_DOUBLE_EQ((double)(i*i), vals[i]);
+    }
+  }
+}
+
+TEST(module, profile_guided_build_failure) {
+  Tensor<double> b("b", {4}, Format({Dense}));
+  b.pack();
+  Tensor<double> a("a", {4}, Format({Dense}));
+
+  IndexVar i("i");
+  a(i) = b(i) + b(i);
+  IndexStmt stmt = makeConcreteNotation(a.getAssignment());
+  auto module = std::make_shared<ir::Module>();
+  module->addFunction(lower(stmt, "compute", true, true));
+  module->setProfileGuided(1);
+  std::string path = module->compile();
+  ASSERT_TRUE(module->isCollectingProfile());
+
+  // The optimized library cannot be built without the source, and the
+  // failure is reported rather than ignored.
+  const std::string suffix = "_instrumented.so";
+  ASSERT_EQ(suffix, path.substr(path.size() - suffix.size()));
+  ASSERT_EQ(0, remove((path.substr(0, path.size() - suffix.size()) +
+                       ".c").c_str()));
+  void* args[] = {a.getTacoTensorT(), b.getTacoTensorT()};
+  module->callFuncPtr(module->getFuncPtr("_shim_compute"), args);
+  ASSERT_THROW(module->optimizeWithProfile(), taco::TacoException);
+}
+
+TEST(module, profile_guided_concurrent) {
+  Tensor<double> b("d", {4}, Format({Dense}));
+  for (int i = 0; i < 4; i++) {
+    b.insert({i}, (double)i);
+  }
+  b.pack();
+  Tensor<double> a("c", {4}, Format({Dense}));
+
+  // Calls from several threads share the training calls, and the optimized
+  // library is swapped in while the other threads keep calling. The tensors
+  // are named apart from the other tests, so that the module does not reuse
+  // their optimized library.
+  auto module = makeSquareModule(a, b);
+  module->setProfileGuided(6);
+  module->compile();
+  const std::atomic<void*>* compute = module->getFuncPtrSlot("_shim_compute");
+  ASSERT_NE(nullptr, compute);
+
+  const int numThreads = 4;
+  std::vector<Tensor<double>> results;
+  for (int t = 0; t < numThreads; t++) {
+    results.push_back(Tensor<double>({4}, Format({Dense})));
+    results.back().pack();
+  }
+  std::vector<taco_tensor_t*> resultData;
+  for (auto& result : results) {
+    resultData.push_back(result.getTacoTensorT());
+  }
+  std::vector<int> correct(numThreads, 1);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (int run = 0; run < 4; run++) {
+        void* args[] = {resultData[t], b.getTacoTensorT()};
+        module->callFuncPtr(compute->load(), args);
+        double* vals = (double*)resultData[t]->vals;
+        for (int i = 0; i < 4; i++) {
+          correct[t] = correct[t] && (vals[i] == (double)(i*i));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_FALSE(module->isCollectingProfile());
+  for (int t = 0; t < numThreads; t++) {
+    ASSERT_TRUE(correct[t]);
+  }
+}
+
+TEST(module, profile_guided_malformed_env) {
+  const char* pgo = std::getenv("TACO_PGO");
+  const std::string previous = (pgo != nullptr) ? pgo : "";
+  setenv("TACO_PGO", "many", 1);
+  ASSERT_THROW(ir::Module(), taco::TacoException);
+  setenv("TACO_PGO", "-1", 1);
+  ASSERT_THROW(ir::Module(), taco::TacoException);
+  if (pgo != nullptr) {
+    setenv("TACO_PGO", previous.c_str(), 1);
+  } else {
+    unsetenv("TACO_PGO");
+  }
+}
+
+TEST(module, x86_intrinsics) {
+  Tensor<double> A("A", {5, 11}, CSR);
+  Tensor<double> x("x", {11}, Format({Dense}));
+  for (int i = 0; i < 5; i++) {
+    for (int j = i; j < 11; j += 2) {
+      A.insert({i, j}, (double)(i + j));
+    }
+  }
+  for (int j = 0; j < 11; j++) {
+    x.insert({j}, (double)j);
+  }
+  A.pack();
+  x.pack();
+  Tensor<double> y("y", {5}, Format({Dense}));
+
+  IndexVar i("i"), j("j"), jpos("jpos"), j0("j0"), j1("j1");
+  y(i) = A(i,j) * x(j);
+  IndexStmt stmt = y.getAssignment().concretize();
+  stmt = stmt.pos(j, jpos, A(i,j))
+             .split(jpos, j0, j1, 4)
+             .parallelize(j1, ParallelUnit::CPUVector,
+                          OutputRaceStrategy::ParallelReduction);
+
+  auto module = std::make_shared<ir::Module>(Target(Target::X86,
+                                                    Target::Linux));
+  module->addFunction(lower(scalarPromote(stmt), "compute", true, true));
+  module->compile();
+
+  // The coordinates of A are gathered from x and the products are summed
+  // into a vector accumulator.
+  std::string source = module->getSource();
+  ASSERT_NE(std::string::npos, source.find("_mm256_mask_i32gather_pd"));
+  ASSERT_NE(std::string::npos, source.find("taco_hsum_pd("));
+  ASSERT_NE(std::string::npos, source.find("#else"));
+
+  taco_tensor_t* result = y.getTacoTensorT();
+  module->callFuncPacked("compute", {result, A.getTacoTensorT(),
+                                     x.getTacoTensorT()});
+  double* vals = (double*)result->vals;
+  for (int i = 0; i < 5; i++) {
+    double expected = 0.0;
+    for (int j = i; j < 11; j += 2) {
+      expected += (double)(i + j) * j;
+    }
+    ASSERT_DOUBLE_EQ(expected, vals[i]);
+  }
+}
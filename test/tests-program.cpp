@@ -0,0 +1,118 @@
+#include "test.h"
+#include "taco/tensor.h"
+#include "taco/program.h"
+#include "taco/index_notation/index_notation_nodes.h"
+
+using namespace taco;
+
+static bool reads(const TensorBase& tensor, const TensorBase& operand) {
+  bool found = false;
+  match(tensor.getAssignment().getRhs(),
+    std::function<void(const AccessNode*)>([&](const AccessNode* op) {
+      found = found || op->tensorVar == operand.getTensorVar();
+    })
+  );
+  return found;
+}
+
+TEST(program, evaluate) {
+  IndexVar i("i"), j("j");
+  Tensor<double> A("A", {4,4}, Format({Dense,Sparse}));
+  Tensor<double> x("x", {4}, Format({Dense}));
+  Tensor<double> b("b", {4}, Format({Dense}));
+  for (int k = 0; k < 4; k++) {
+    A.insert({k, k}, 1.0 + k);
+    x.insert({k}, 2.0);
+    b.insert({k}, 1.0 * k);
+  }
+
+  Tensor<double> t("t", {4}, Format({Dense}));
+  Tensor<double> s("s", {4}, Format({Dense}));
+  Tensor<double> y("y", {4}, Format({Dense}));
+  Tensor<double> z("z", {4}, Format({Dense}));
+  Tensor<double> dead("dead", {4}, Format({Dense}));
+  t(i) = A(i,j) * x(j);
+  s(i) = b(i) * 2;
+  y(i) = t(i) + s(i);
+  z(i) = t(i) * b(i);
+  dead(i) = b(i) * 3;
+
+  TensorProgram program;
+  program.addResult(y);
+  program.addResult(z);
+  program.evaluate();
+
+  ASSERT_FALSE(y.needsCompute());
+  ASSERT_FALSE(z.needsCompute());
+
+  // Dead assignments are not computed, s is fused into y's kernel, and the
+  // storage of t is released once y and z are computed
+  ASSERT_TRUE(dead.needsCompute());
+  ASSERT_TRUE(s.needsCompute());
+  ASSERT_TRUE(t.needsCompute());
+
+  for (int k = 0; k < 4; k++) {
+    double tk = 2.0 * (1.0 + k);
+    ASSERT_DOUBLE_EQ(tk + 2.0 * k, y(k));
+    ASSERT_DOUBLE_EQ(tk * k, z(k));
+  }
+
+  // Temporaries are recomputed with the values of their operands from before
+  // they are modified
+  x.insert({0}, 0.0);
+  x.pack();
+  ASSERT_DOUBLE_EQ(2.0, t(0));
+  ASSERT_DOUBLE_EQ(3.0, dead(1));
+}
+
+TEST(program, common_subexpressions) {
+  IndexVar i("i"), j("j");
+  Tensor<double> a("a", {4}, Format({Dense}));
+  Tensor<double> b("b", {4}, Format({Dense}));
+  for (int k = 0; k < 4; k++) {
+    a.insert({k}, 1.0 + k);
+    b.insert({k}, 2.0);
+  }
+
+  Tensor<double> u("u", {4}, Format({Dense}));
+  Tensor<double> v("v", {4}, Format({Dense}));
+  Tensor<double> w("w", {4}, Format({Dense}));
+  u(i) = a(i) * b(i);
+  v(j) = a(j) * b(j);
+  w(i) = u(i) + v(i);
+
+  TensorProgram program;
+  program.addResult(w);
+  program.addResult(v);
+  program.evaluate();
+
+  // One of u and v is computed as a copy of the other, but both keep their
+  // own assignments
+  ASSERT_TRUE(reads(u, a) && !reads(u, v));
+  ASSERT_TRUE(reads(v, a) && !reads(v, u));
+  for (int k = 0; k < 4; k++) {
+    ASSERT_DOUBLE_EQ(4.0 * (1.0 + k), w(k));
+    ASSERT_DOUBLE_EQ(2.0 * (1.0 + k), v(k));
+  }
+
+  // Temporaries that are not computed are recomputed from their own operands
+  Tensor<double> s("s", {4}, Format({Dense}));
+  Tensor<double> t("t", {4}, Format({Dense}));
+  Tensor<double> r("r", {4}, Format({Dense}));
+  s(i) = a(i) * b(i);
+  t(i) = a(i) * b(i);
+  r(i) = s(i) + t(i);
+
+  TensorProgram temporaries;
+  temporaries.addResult(r);
+  temporaries.evaluate();
+  ASSERT_TRUE(reads(s, a) && !reads(s, t));
+  ASSERT_TRUE(reads(t, a) && !reads(t, s));
+  a.insert({0}, 0.0);
+  a.pack();
+  for (int k = 0; k < 4; k++) {
+    ASSERT_DOUBLE_EQ(4.0 * (1.0 + k), r(k));
+    ASSERT_DOUBLE_EQ(2.0 * (1.0 + k), s(k));
+    ASSERT_DOUBLE_EQ(2.0 * (1.0 + k), t(k));
+  }
+}
@@ -54,6 +54,8 @@ TEST(schedule_parser, normal_operation) {
         { "split(i,i0,i1,16),precompute(A(i,j)*x(j),i,i)",
                                          { { "split", "i", "i0", "i1", "16" },
                                            { "precompute", "A(i,j)*x(j)", "i", "i" } } },
+        { "split(i,i0,i1,16,Peel)",      { { "split", "i", "i0", "i1", "16", "Peel" } } },
+        { "tile({i,j},{64,8},2)",        { { "tile", "{i,j}", "{64,8}", "2" } } },
     };
     for(auto test : cases) {
         auto actual = ScheduleParser(test.str);
@@ -8,6 +8,7 @@
 #include "codegen/codegen.h"
 #include "taco/lower/lower.h"
 
+#include <algorithm>
 #include <functional>
 
 using namespace taco;
@@ -1053,3 +1054,445 @@ TEST(scheduling, divide) {
     return stmt.fuse(i, j, f).pos(f, fpos, A(i, j)).divide(fpos, f0, f1, 4).split(f1, i1, i2, 16).split(i2, i3, i4, 8);
   });
 }
+
+TEST(scheduling, vectorizeReductionPragma) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  Tensor<double> a("a");
+  Tensor<double> b("b", {19}, Format({Dense}));
+  Tensor<double> c("c", {19}, Format({Dense}));
+  for (int i = 0; i < 19; i++) {
+    b.insert({i}, (double) i);
+    c.insert({i}, 2.0);
+  }
+  b.pack();
+  c.pack();
+
+  IndexVar i("i"), i0("i0"), i1("i1");
+  a = b(i) * c(i);
+  IndexStmt stmt = a.getAssignment().concretize();
+  stmt = stmt.split(i, i0, i1, 8)
+             .parallelize(i1, ParallelUnit::CPUVector,
+                          OutputRaceStrategy::ParallelReduction);
+
+  // The vectorized loop accumulates into a scalar, which GCC needs to be told
+  // about through the reduction clause of the omp simd pragma.
+  std::stringstream source;
+  auto codegen = ir::CodeGen::init_default(source,
+                                           ir::CodeGen::ImplementationGen);
+  codegen->compile(lower(scalarPromote(stmt), "compute", false, true), true);
+  ASSERT_NE(std::string::npos, source.str().find("#pragma clang loop"));
+  ASSERT_NE(std::string::npos, source.str().find("#pragma omp simd reduction(+:"));
+
+  a.compile(stmt);
+  a.assemble();
+  a.compute();
+  ASSERT_DOUBLE_EQ(342.0, a.begin()->second);
+}
+
+TEST(scheduling, vectorizeDependentStoresPragma) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  // Every iteration of the vectorized loop loads the element that the
+  // previous iteration stored, so it must not be annotated with the GCC
+  // pragmas that assert that iterations are independent.
+  ir::Expr a = ir::Var::make("a", Float64, true);
+  ir::Expr n = ir::Var::make("n", Int32);
+  ir::Expr iv = ir::Var::make("iv", Int32);
+  ir::Stmt loop = ir::For::make(iv, 0, n, 1,
+      ir::Store::make(a, ir::Add::make(iv, 1),
+                      ir::Add::make(ir::Load::make(a, iv),
+                                    ir::Literal::make(1.0))),
+      ir::LoopKind::Vectorized, ParallelUnit::CPUVector);
+  std::stringstream source;
+  auto codegen = ir::CodeGen::init_default(source,
+                                           ir::CodeGen::ImplementationGen);
+  codegen->compile(ir::Function::make("compute", {a}, {n}, loop), true);
+  ASSERT_NE(std::string::npos, source.str().find("#pragma clang loop"));
+  ASSERT_EQ(std::string::npos, source.str().find("#pragma omp simd"));
+  ASSERT_EQ(std::string::npos, source.str().find("#pragma GCC ivdep"));
+}
+
+TEST(scheduling, splitTailStrategies) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  Tensor<double> b("b", {19}, Format({Dense}));
+  Tensor<double> c("c", {19}, Format({Dense}));
+  for (int i = 0; i < 19; i++) {
+    b.insert({i}, (double) i);
+    c.insert({i}, 2.0);
+  }
+  b.pack();
+  c.pack();
+
+  IndexVar i("i"), i0("i0"), i1("i1");
+  auto compute = [&](TailStrategy tail, std::string* source) {
+    Tensor<double> a("a", {19}, Format({Dense}));
+    a(i) = b(i) * c(i);
+    IndexStmt stmt = a.getAssignment().concretize();
+    stmt = stmt.split(i, i0, i1, 8, tail)
+               .parallelize(i1, ParallelUnit::CPUVector,
+                            OutputRaceStrategy::IgnoreRaces);
+    a.compile(stmt);
+    a.assemble();
+    a.compute();
+    *source = a.getSource();
+    return a;
+  };
+
+  Tensor<double> expected("expected", {19}, Format({Dense}));
+  expected(i) = b(i) * c(i);
+  expected.evaluate();
+
+  // The full strips of a peeled split are computed by a main loop without
+  // bounds checks, followed by an epilogue that checks the bounds of the last
+  // strip
+  std::string guarded, peeled;
+  ASSERT_TENSOR_EQ(expected, compute(TailStrategy::Guard, &guarded));
+  ASSERT_TENSOR_EQ(expected, compute(TailStrategy::Peel, &peeled));
+  const std::string outerLoop = "for (int32_t i0 = ";
+  ASSERT_EQ(guarded.find(outerLoop), guarded.rfind(outerLoop));
+  ASSERT_NE(peeled.find(outerLoop), peeled.rfind(outerLoop));
+  ASSERT_EQ(peeled.find("continue"), peeled.rfind("continue"));
+  ASSERT_NE(std::string::npos, peeled.find("int32_t i_main = "));
+
+  // Rounded up splits do not check bounds at all
+  Tensor<double> d("d", {16}, Format({Dense}));
+  Tensor<double> e("e", {16}, Format({Dense}));
+  for (int k = 0; k < 16; k++) {
+    d.insert({k}, (double) k);
+  }
+  d.pack();
+  e(i) = d(i) * 3.0;
+  IndexStmt stmt = e.getAssignment().concretize();
+  e.compile(stmt.split(i, i0, i1, 4, TailStrategy::RoundUp)
+                .parallelize(i1, ParallelUnit::CPUVector,
+                             OutputRaceStrategy::IgnoreRaces));
+  e.assemble();
+  e.compute();
+  ASSERT_EQ(std::string::npos, e.getSource().find("continue"));
+  for (int k = 0; k < 16; k++) {
+    ASSERT_DOUBLE_EQ(3.0 * k, e(k));
+  }
+
+  ASSERT_THROW(stmt.divide(i, i0, i1, 4, TailStrategy::Peel), TacoException);
+}
+
+TEST(scheduling, tile) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  Tensor<double> B("B", {21, 19}, Format({Dense, Dense}));
+  Tensor<double> C("C", {19, 17}, Format({Dense, Dense}));
+  for (int i = 0; i < 21; i++) {
+    for (int k = 0; k < 19; k++) {
+      B.insert({i, k}, (double) (i + k));
+    }
+  }
+  for (int k = 0; k < 19; k++) {
+    for (int j = 0; j < 17; j++) {
+      C.insert({k, j}, (double) (k - j));
+    }
+  }
+  B.pack();
+  C.pack();
+
+  IndexVar i("i"), j("j"), k("k");
+  Tensor<double> expected("expected", {21, 17}, Format({Dense, Dense}));
+  expected(i,j) = B(i,k) * C(k,j);
+  expected.evaluate();
+
+  IndexVar i0("i0"), i1("i1"), i2("i2"), j0("j0"), j1("j1"), j2("j2");
+  auto tile = [&](std::vector<size_t> sizes, bool parallelize) {
+    Tensor<double> A("A", {21, 17}, Format({Dense, Dense}));
+    A(i,j) = B(i,k) * C(k,j);
+    IndexStmt stmt = A.getAssignment().concretize();
+    stmt = stmt.tile({i, j}, {{i0, i1, i2}, {j0, j1, j2}}, sizes);
+    if (parallelize) {
+      stmt = stmt.parallelize(i0, ParallelUnit::CPUThread,
+                              OutputRaceStrategy::NoRaces);
+    }
+    A.compile(stmt);
+    A.assemble();
+    A.compute();
+    return A;
+  };
+
+  // The loops over the tiles of each level enclose the loops of the next level
+  Tensor<double> tiled = tile({8, 4}, false);
+  ASSERT_TENSOR_EQ(expected, tiled);
+  const std::string source = tiled.getSource();
+  std::vector<size_t> loops;
+  for (auto var : {"i0", "j0", "i1", "j1", "i2", "j2"}) {
+    loops.push_back(source.find(std::string("for (int32_t ") + var + " = "));
+    ASSERT_NE(std::string::npos, loops.back());
+  }
+  ASSERT_TRUE(std::is_sorted(loops.begin(), loops.end()));
+
+  // Tiles can be sized to fit in the caches and composed with parallelize
+  ASSERT_TENSOR_EQ(expected, tile({}, false));
+  ASSERT_TENSOR_EQ(expected, tile({8, 4}, true));
+
+  Tensor<double> A("A", {21, 17}, Format({Dense, Dense}));
+  A(i,j) = B(i,k) * C(k,j);
+  IndexStmt stmt = A.getAssignment().concretize();
+  ASSERT_THROW(stmt.tile({i, j}, {{i0, i1, i2}, {j0, j1, j2}}, {8, 3}),
+               TacoException);
+  ASSERT_THROW(stmt.tile({i, j}, {{i0, i1, i2}, {j0, j1}}, {8, 4}),
+               TacoException);
+}
+
+TEST(scheduling, prefetch) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  Tensor<double> A("A", {64, 48}, CSR);
+  Tensor<double> x("x", {48}, Format({Dense}));
+  for (int i = 0; i < 64; i++) {
+    for (int j = (i * 7) % 5; j < 48; j += 3 + i % 4) {
+      A.insert({i, j}, (double) (i + j));
+    }
+  }
+  for (int j = 0; j < 48; j++) {
+    x.insert({j}, (double) j);
+  }
+  A.pack();
+  x.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> expected("expected", {64}, Format({Dense}));
+  expected(i) = A(i,j) * x(j);
+  expected.evaluate();
+
+  // The values of x are prefetched for the nonzero that is 8 iterations ahead,
+  // and the coordinates of that nonzero are only read if it is in the row
+  Tensor<double> y("y", {64}, Format({Dense}));
+  y(i) = A(i,j) * x(j);
+  IndexStmt stmt = y.getAssignment().concretize();
+  stmt = stmt.prefetch(j, x(j), 8);
+  y.compile(stmt);
+  y.assemble();
+  y.compute();
+  ASSERT_TENSOR_EQ(expected, y);
+  const std::string source = y.getSource();
+  ASSERT_NE(std::string::npos, source.find("if (jA + 8 < A2_pos[(i + 1)])"));
+  ASSERT_NE(std::string::npos,
+            source.find("__builtin_prefetch(&x_vals[A2_crd[(jA + 8)]]);"));
+
+  // Loops that do not read the tensor cannot prefetch it
+  Tensor<double> z("z", {48}, Format({Dense}));
+  ASSERT_THROW(stmt.prefetch(i, z(j), 8), TacoException);
+  ASSERT_THROW(stmt.prefetch(j, x(j), 0), TacoException);
+}
+
+TEST(scheduling, parallelizeTasks) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  // The fibers of B have very different lengths
+  Tensor<double> B("B", {8, 40, 40}, Format({Dense, Sparse, Sparse}));
+  Tensor<double> c("c", {40}, Format({Dense}));
+  for (int i = 0; i < 8; i++) {
+    for (int j = 0; j < 40; j += (i == 3) ? 1 : 7) {
+      for (int k = j % 3; k < 40; k += (i == 3) ? 1 : 11) {
+        B.insert({i, j, k}, (double) (i + j - k));
+      }
+    }
+  }
+  for (int k = 0; k < 40; k++) {
+    c.insert({k}, (double) k);
+  }
+  B.pack();
+  c.pack();
+
+  IndexVar i("i"), j("j"), k("k");
+  Tensor<double> expected("expected", {8, 40}, Format({Dense, Dense}));
+  expected(i,j) = B(i,j,k) * c(k);
+  expected.evaluate();
+
+  // Loops over tasks can be nested, and only the outermost one starts a
+  // parallel region
+  Tensor<double> A("A", {8, 40}, Format({Dense, Dense}));
+  A(i,j) = B(i,j,k) * c(k);
+  IndexStmt stmt = A.getAssignment().concretize();
+  stmt = stmt.parallelize(i, ParallelUnit::CPUTask, OutputRaceStrategy::NoRaces)
+             .parallelize(j, ParallelUnit::CPUTask, OutputRaceStrategy::NoRaces);
+  A.compile(stmt);
+  A.assemble();
+  A.compute();
+  ASSERT_TENSOR_EQ(expected, A);
+  const std::string source = A.getSource();
+  const std::string taskloop = "#pragma omp taskloop";
+  ASSERT_NE(std::string::npos, source.find(taskloop));
+  ASSERT_NE(source.find(taskloop), source.rfind(taskloop));
+  const std::string region = "#pragma omp parallel\n";
+  ASSERT_NE(std::string::npos, source.find(region));
+  ASSERT_EQ(source.find(region), source.rfind(region));
+
+  // Results of tasks cannot be privatized per thread
+  IndexStmt reduction = A.getAssignment().concretize();
+  ASSERT_THROW(reduction.parallelize(k, ParallelUnit::CPUTask,
+                                     OutputRaceStrategy::Temporary),
+               TacoException);
+}
+
+TEST(scheduling, parallelizeMergePath) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  // One row of A holds most of the nonzeros
+  Tensor<double> A("A", {50, 50}, CSR);
+  Tensor<double> x("x", {50}, Format({Dense}));
+  for (int i = 0; i < 50; i++) {
+    for (int j = i % 3; j < 50; j += (i == 7) ? 1 : 13) {
+      A.insert({i, j}, (double) (i - j));
+    }
+    x.insert({i}, (double) i);
+  }
+  A.pack();
+  x.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> expected("expected", {50}, Format({Dense}));
+  expected(i) = A(i,j) * x(j);
+  expected.evaluate();
+
+  Tensor<double> y("y", {50}, Format({Dense}));
+  y(i) = A(i,j) * x(j);
+  IndexStmt stmt = y.getAssignment().concretize();
+  stmt = stmt.parallelize(i, ParallelUnit::CPUThread,
+                          OutputRaceStrategy::MergePath);
+  y.compile(stmt);
+  y.assemble();
+  y.compute();
+  ASSERT_TENSOR_EQ(expected, y);
+  ASSERT_NE(std::string::npos, y.getSource().find("taco_mergePathSearch"));
+
+  // The rows must be a dense level above the compressed level
+  Tensor<double> B("B", {50, 50}, DCSR);
+  Tensor<double> z("z", {50}, Format({Dense}));
+  z(i) = B(i,j) * x(j);
+  IndexStmt dcsr = z.getAssignment().concretize();
+  ASSERT_THROW(dcsr.parallelize(i, ParallelUnit::CPUThread,
+                                OutputRaceStrategy::MergePath),
+               TacoException);
+}
+
+TEST(scheduling, mergebyGallop) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  // The rows of C are much shorter than the rows of B
+  Tensor<double> B("B", {4, 1000}, CSR);
+  Tensor<double> C("C", {4, 1000}, CSR);
+  for (int i = 0; i < 4; i++) {
+    for (int j = i; j < 1000; j += 2) {
+      B.insert({i, j}, (double) (i + j));
+    }
+    for (int j = 3 * i; j < 1000; j += 37 + i) {
+      C.insert({i, j}, (double) (j - i));
+    }
+  }
+  B.pack();
+  C.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> expected("expected", {4, 1000}, CSR);
+  expected(i,j) = B(i,j) * C(i,j);
+  expected.evaluate();
+
+  Tensor<double> A("A", {4, 1000}, CSR);
+  A(i,j) = B(i,j) * C(i,j);
+  IndexStmt stmt = A.getAssignment().concretize();
+  stmt = stmt.mergeby(j, MergeStrategy::Gallop);
+  A.compile(stmt);
+  A.assemble();
+  A.compute();
+  ASSERT_TENSOR_EQ(expected, A);
+  ASSERT_NE(std::string::npos, A.getSource().find("= taco_gallop("));
+
+  // Unions are merged one coordinate at a time
+  Tensor<double> D("D", {4, 1000}, Format({Dense, Dense}));
+  D(i,j) = B(i,j) + C(i,j);
+  IndexStmt unionStmt = D.getAssignment().concretize();
+  D.compile(unionStmt.mergeby(j, MergeStrategy::Gallop));
+  ASSERT_EQ(std::string::npos, D.getSource().find("= taco_gallop("));
+}
+
+TEST(scheduling, mergebyBranchless) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  Tensor<double> B("B", {6, 200}, CSR);
+  Tensor<double> C("C", {6, 200}, CSR);
+  for (int i = 0; i < 6; i++) {
+    for (int j = i; j < 200; j += 3) {
+      B.insert({i, j}, (double) (i + j));
+    }
+    for (int j = 2 * i; j < 200; j += 5 + i) {
+      C.insert({i, j}, (double) (j - i));
+    }
+  }
+  B.pack();
+  C.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> expected("expected", {6, 200}, CSR);
+  expected(i,j) = B(i,j) - 2 * C(i,j);
+  expected.evaluate();
+
+  Tensor<double> A("A", {6, 200}, CSR);
+  A(i,j) = B(i,j) - 2 * C(i,j);
+  IndexStmt stmt = A.getAssignment().concretize();
+  A.compile(stmt.mergeby(j, MergeStrategy::Branchless));
+  A.assemble();
+  A.compute();
+  ASSERT_TENSOR_EQ(expected, A);
+  ASSERT_NE(std::string::npos, A.getSource().find("TACO_SELECT(("));
+  ASSERT_NE(std::string::npos, A.getSource().find("double B_val = B_vals["));
+
+  // Products of the operands are computed in cases
+  Tensor<double> D("D", {6, 200}, Format({Dense, Dense}));
+  D(i,j) = B(i,j) * C(i,j) + B(i,j);
+  IndexStmt productStmt = D.getAssignment().concretize();
+  D.compile(productStmt.mergeby(j, MergeStrategy::Branchless));
+  ASSERT_EQ(std::string::npos, D.getSource().find("TACO_SELECT(("));
+}
+
+TEST(scheduling, unrollReduction) {
+  if (should_use_CUDA_codegen()) {
+    return;
+  }
+  // Rows of every length modulo the number of accumulators
+  Tensor<double> A("A", {12, 40}, CSR);
+  Tensor<double> x("x", {40}, Format({Dense}));
+  for (int i = 0; i < 12; i++) {
+    for (int j = 0; j < 3 * i + 1; j++) {
+      A.insert({i, j}, 1.0 / (i + j + 1));
+    }
+  }
+  for (int j = 0; j < 40; j++) {
+    x.insert({j}, (double) (j % 7) - 3.0);
+  }
+  A.pack();
+  x.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> expected("expected", {12}, Format({Dense}));
+  expected(i) = A(i,j) * x(j);
+  expected.evaluate();
+
+  Tensor<double> y("y", {12}, Format({Dense}));
+  y(i) = A(i,j) * x(j);
+  IndexStmt stmt = y.getAssignment().concretize();
+  y.compile(stmt.unrollReduction(j, 4));
+  y.assemble();
+  y.compute();
+  ASSERT_TENSOR_EQ(expected, y);
+  ASSERT_NE(std::string::npos, y.getSource().find("_unrolled_end"));
+
+  ASSERT_THROW(stmt.unrollReduction(j, 1), TacoException);
+}
@@ -3,6 +3,7 @@
 #include "taco/tensor.h"
 #include "test_tensors.h"
 
+#include <cstdlib>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -519,3 +520,148 @@ TEST(tensor, cache) {
   // ability to answer a request for the first query.
   c(i, j) = a(i, j); c.evaluate();
 }
+
+TEST(tensor, prepare) {
+  IndexVar i("i");
+  Tensor<double> a("a", {3}, Format({Dense}));
+  Tensor<double> b("b", {3}, Format({Sparse}));
+  Tensor<double> c("c", {3}, Format({Dense}));
+  b.insert({0}, 1.0);
+  b.insert({2}, 2.0);
+  c.insert({0}, 3.0);
+  c.insert({1}, 4.0);
+  c.insert({2}, 5.0);
+
+  a(i) = b(i) * c(i);
+  PreparedExecution run = a.prepare();
+  ASSERT_TRUE(run.defined());
+  ASSERT_DOUBLE_EQ(3.0, a(0));
+  ASSERT_DOUBLE_EQ(10.0, a(2));
+
+  // Modify the operand values in place and rerun the prepared kernel.
+  double* cvals = (double*)c.getStorage().getValues().getData();
+  for (int k = 0; k < 3; k++) {
+    cvals[k] *= 2.0;
+  }
+  ASSERT_TRUE(run());
+  ASSERT_DOUBLE_EQ(6.0, a(0));
+  ASSERT_DOUBLE_EQ(0.0, a(1));
+  ASSERT_DOUBLE_EQ(20.0, a(2));
+}
+
+TEST(tensor, fuse) {
+  IndexVar i("i"), j("j");
+  Tensor<double> A("A", {4,4}, Format({Dense,Sparse}));
+  Tensor<double> x("x", {4}, Format({Dense}));
+  Tensor<double> b("b", {4}, Format({Dense}));
+  for (int k = 0; k < 4; k++) {
+    A.insert({k, k}, 1.0 + k);
+    A.insert({k, (k + 1) % 4}, 2.0);
+    x.insert({k}, 1.0 + k);
+    b.insert({k}, -1.0);
+  }
+
+  // Operands are not fused unless TACO_FUSE is set
+  const char* fuse = std::getenv("TACO_FUSE");
+  const std::string previous = (fuse != nullptr) ? fuse : "";
+  unsetenv("TACO_FUSE");
+  Tensor<double> unfusedT("unfusedT", {4}, Format({Dense}));
+  Tensor<double> unfusedY("unfusedY", {4}, Format({Dense}));
+  Tensor<double> unfusedZ("unfusedZ", {4}, Format({Dense}));
+  unfusedT(i) = A(i,j) * x(j);
+  unfusedY(i) = unfusedT(i) + b(i);
+  unfusedZ(i) = unfusedY(i) * unfusedY(i);
+  unfusedZ.evaluate();
+  ASSERT_FALSE(unfusedT.needsCompute());
+  ASSERT_FALSE(unfusedY.needsCompute());
+
+  setenv("TACO_FUSE", "1", 1);
+  Tensor<double> t("t", {4}, Format({Dense}));
+  Tensor<double> y("y", {4}, Format({Dense}));
+  Tensor<double> z("z", {4}, Format({Dense}));
+  t(i) = A(i,j) * x(j);
+  y(i) = t(i) + b(i);
+  z(i) = y(i) * y(i);
+  z.evaluate();
+
+  // The intermediates are computed in z's kernel and are not stored
+  ASSERT_TRUE(t.needsCompute());
+  ASSERT_TRUE(y.needsCompute());
+  ASSERT_EQ(std::string::npos, z.getSource().find("t_vals"));
+  ASSERT_EQ(std::string::npos, z.getSource().find("y_vals"));
+
+  // (A*x)(i) = (1+i)^2 + 2*(1+(i+1)%4)
+  for (int k = 0; k < 4; k++) {
+    double yk = (1.0 + k) * (1.0 + k) + 2.0 * (1.0 + (k + 1) % 4) - 1.0;
+    ASSERT_DOUBLE_EQ(yk * yk, z(k));
+    ASSERT_DOUBLE_EQ(yk, y(k));
+  }
+
+  // Intermediates that are read elsewhere are computed on their own, with the
+  // values of the operands from before they are modified
+  t(i) = A(i,j) * x(j);
+  y(i) = t(i) + b(i);
+  z(i) = y(i) * y(i);
+  x.insert({0}, 0.0);
+  x.pack();
+  for (int k = 0; k < 4; k++) {
+    double yk = (1.0 + k) * (1.0 + k) + 2.0 * (1.0 + (k + 1) % 4) - 1.0;
+    ASSERT_DOUBLE_EQ(yk * yk, z(k));
+  }
+
+  if (fuse != nullptr) {
+    setenv("TACO_FUSE", previous.c_str(), 1);
+  } else {
+    unsetenv("TACO_FUSE");
+  }
+}
+
+TEST(tensor, aliased_operand) {
+  IndexVar i("i");
+  Tensor<double> a("a", {4}, Format({Dense}));
+  Tensor<double> b("b", {4}, Format({Dense}));
+  for (int k = 0; k < 4; k++) {
+    b.insert({k}, 1.0 + k);
+  }
+  b.pack();
+
+  // Kernels assume that the arrays of a result do not alias its operands
+  a.setStorage(b.getStorage());
+  a(i) = b(i) * 2.0;
+  ASSERT_THROW(a.evaluate(), taco::TacoException);
+}
+
+TEST(tensor, specialize_dimensions) {
+  IndexVar i("i"), j("j"), k("k");
+  Tensor<double> B("B", {8,8}, Format({Dense,Sparse}));
+  Tensor<double> C("C", {8,4}, Format({Dense,Dense}));
+  for (int n = 0; n < 8; n++) {
+    B.insert({n, (3 * n) % 8}, 1.0 + n);
+    for (int m = 0; m < 4; m++) {
+      C.insert({n, m}, 1.0 * m - n);
+    }
+  }
+  B.pack();
+  C.pack();
+
+  Tensor<double> A("A", {8,4}, Format({Dense,Dense}));
+  A(i,k) = B(i,j) * C(j,k);
+  A.specializeDimensions({k});
+  A.evaluate();
+
+  // The dimension of k is compiled into the kernel, which checks it before it
+  // runs the specialized code
+  ASSERT_NE(std::string::npos, A.getSource().find("== 4"));
+  for (int n = 0; n < 8; n++) {
+    for (int m = 0; m < 4; m++) {
+      ASSERT_DOUBLE_EQ((1.0 + n) * (1.0 * m - (3 * n) % 8), A(n,m));
+    }
+  }
+
+  // Unspecialized kernels of the same expression are cached separately
+  Tensor<double> D("D", {8,4}, Format({Dense,Dense}));
+  D(i,k) = B(i,j) * C(j,k);
+  D.evaluate();
+  ASSERT_EQ(std::string::npos, D.getSource().find("== 4"));
+  ASSERT_TRUE(equals(A, D));
+}
@@ -1,10 +1,18 @@
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+
 #include "test.h"
 #include "test_tensors.h"
+#include "op_factory.h"
 
+#include "taco/index_notation/autotune.h"
 #include "taco/index_notation/schedule.h"
 #include "taco/index_notation/transformations.h"
 #include "taco/index_notation/index_notation.h"
+#include "taco/index_notation/index_notation_nodes.h"
 #include "taco/util/name_generator.h"
+#include "taco/util/env.h"
 #include "taco/tensor.h"
 
 using namespace taco;
@@ -328,6 +336,437 @@ INSTANTIATE_TEST_CASE_P(spmm, insertTemporaries, Values(
                                           w(j) += B(i,k) * C(k,j))))))
 ));
 
+TEST(autoschedule, loopOrder) {
+  // The contiguous dense level is iterated by the inner loop
+  IndexStmt stmt = forall(j, forall(i, W(i,j) = G(i,j)));
+  IndexStmt expected = parallelizeOuterLoop(forall(i, forall(j, W(i,j) = G(i,j))));
+  ASSERT_NOTATION_EQ(expected, autoschedule(stmt));
+}
+
+TEST(autoschedule, statistics) {
+  TensorVar s("s", Float64);
+  IndexStmt ij = forall(i, forall(j, s() += b(i) * c(j)));
+  IndexStmt ji = forall(j, forall(i, s() += b(i) * c(j)));
+
+  // The loop over the vector with fewer nonzeros is placed outermost
+  std::map<TensorVar,TensorStatistics> shortB = {{b, {{10}}}, {c, {{1000}}}};
+  std::map<TensorVar,TensorStatistics> longB = {{b, {{1000}}}, {c, {{10}}}};
+  ASSERT_LT(estimateCost(ij, shortB), estimateCost(ji, shortB));
+  ASSERT_LT(estimateCost(ji, longB), estimateCost(ij, longB));
+  ASSERT_NOTATION_EQ(ij, autoschedule(ij, shortB));
+  ASSERT_NOTATION_EQ(ji, autoschedule(ij, longB));
+}
+
+TEST(autoschedule, contractionOrder) {
+  const int N = 12;
+  Tensor<double> B("coB", {N,N}, Format({dense,dense}));
+  Tensor<double> C("coC", {N,N}, Format({dense,dense}));
+  Tensor<double> D("coD", {N,N}, Format({dense,dense}));
+  Tensor<double> x("cox", {N}, Format({dense}));
+  for (int k = 0; k < N; k++) {
+    for (int l = 0; l < N; l++) {
+      B.insert({k, l}, 1.0 + k - l);
+      D.insert({k, l}, 0.5 * (k + l));
+    }
+    C.insert({k, (k * 5) % N}, 2.0);
+    x.insert({k}, 1.0 * k);
+  }
+  B.pack();
+  C.pack();
+  D.pack();
+  x.pack();
+
+  IndexVar i("i"), j("j"), k("k"), l("l");
+  Tensor<double> y("coy", {N}, Format({dense}));
+  y(i) = B(i,j) * C(j,k) * x(k);
+  IndexStmt contracted = optimizeContractionOrder(y.getAssignment());
+  ASSERT_TRUE(isa<Where>(contracted));
+
+  // Compiling only contracts products into temporaries if the autoscheduler
+  // is enabled
+  const char* autoscheduleEnv = std::getenv("TACO_AUTOSCHEDULE");
+  const std::string previous =
+      (autoscheduleEnv != nullptr) ? autoscheduleEnv : "";
+  unsetenv("TACO_AUTOSCHEDULE");
+  y.evaluate();
+  ASSERT_EQ(std::string::npos, y.getSource().find("t0_"));
+  setenv("TACO_AUTOSCHEDULE", "1", 1);
+  Tensor<double> contractedY("cocy", {N}, Format({dense}));
+  contractedY(i) = B(i,j) * C(j,k) * x(k);
+  contractedY.evaluate();
+  ASSERT_NE(std::string::npos, contractedY.getSource().find("t0_"));
+  if (autoscheduleEnv != nullptr) {
+    setenv("TACO_AUTOSCHEDULE", previous.c_str(), 1);
+  } else {
+    unsetenv("TACO_AUTOSCHEDULE");
+  }
+
+  Tensor<double> Cx("coCx", {N}, Format({dense}));
+  Tensor<double> expectedY("coey", {N}, Format({dense}));
+  Cx(j) = C(j,k) * x(k);
+  expectedY(i) = B(i,j) * Cx(j);
+  ASSERT_TENSOR_EQ(expectedY, y);
+  ASSERT_TENSOR_EQ(expectedY, contractedY);
+
+  Tensor<double> A("coA", {N,N}, Format({dense,dense}));
+  A(i,l) = B(i,j) * C(j,k) * D(k,l);
+  ASSERT_TRUE(isa<Where>(optimizeContractionOrder(A.getAssignment())));
+  A.evaluate();
+
+  Tensor<double> CD("coCD", {N,N}, Format({dense,dense}));
+  Tensor<double> expectedA("coeA", {N,N}, Format({dense,dense}));
+  CD(j,l) = C(j,k) * D(k,l);
+  expectedA(i,l) = B(i,j) * CD(j,l);
+  ASSERT_TENSOR_EQ(expectedA, A);
+
+  // Products of two operands are already pairwise
+  ASSERT_FALSE(optimizeContractionOrder(expectedA.getAssignment()).defined());
+}
+
+TEST(autoschedule, parallelAssembly) {
+  const int N = 40;
+  Tensor<double> B("paB", {N,N}, CSR);
+  Tensor<double> C("paC", {N,N}, CSR);
+  for (int k = 0; k < N; k++) {
+    B.insert({k, (k * 3) % N}, 1.0 + k);
+    B.insert({k, (k * 7 + 1) % N}, 2.0);
+    C.insert({k, (k + 2) % N}, 0.5 * k);
+    C.insert({(k * 5) % N, k}, 3.0);
+  }
+  B.pack();
+  C.pack();
+
+  IndexVar i("i"), j("j"), k("k");
+  Tensor<double> expectedA("paeA", {N,N}, CSR);
+  Tensor<double> expectedS("paeS", {N,N}, CSR);
+  expectedA(i,j) = B(i,k) * C(k,j);
+  expectedS(i,j) = B(i,j) + C(i,j);
+  expectedA.evaluate();
+  expectedS.evaluate();
+
+  taco_set_num_threads(2);
+  Tensor<double> A("paA", {N,N}, CSR);
+  Tensor<double> S("paS", {N,N}, CSR);
+  A(i,j) = B(i,k) * C(k,j);
+  S(i,j) = B(i,j) + C(i,j);
+
+  // Sparse results are assembled in parallel by counting their nonzeros first
+  IndexStmt stmt = makeConcreteNotation(makeReductionNotation(
+      A.getAssignment()));
+  stmt = parallelizeOuterLoop(taco::insertTemporaries(
+      taco::reorderLoopsTopologically(stmt)));
+  ASSERT_TRUE(isa<Assemble>(stmt));
+  ASSERT_TRUE(isa<Assemble>(parallelizeOuterLoop(
+      makeConcreteNotation(makeReductionNotation(S.getAssignment())))));
+
+  A.evaluate();
+  S.evaluate();
+  taco_set_num_threads(1);
+  ASSERT_TENSOR_EQ(expectedA, A);
+  ASSERT_TENSOR_EQ(expectedS, S);
+  ASSERT_NE(std::string::npos, A.getSource().find("= taco_prefixSum("));
+
+  // Edges are inserted in order unless the attribute queries are parallelized
+  Tensor<double> T("paT", {N,N}, CSR);
+  T(i,j) = B(i,j) + C(i,j);
+  T.compile(makeConcreteNotation(T.getAssignment())
+                .assemble(T.getTensorVar(), AssembleStrategy::Insert));
+  T.assemble();
+  T.compute();
+  ASSERT_TENSOR_EQ(expectedS, T);
+  ASSERT_EQ(std::string::npos, T.getSource().find("= taco_prefixSum("));
+
+  // A single thread assembles the results in one phase
+  ASSERT_FALSE(isa<Assemble>(parallelizeOuterLoop(
+      makeConcreteNotation(makeReductionNotation(S.getAssignment())))));
+}
+
+static OutputRaceStrategy getOuterOutputRaceStrategy(IndexStmt stmt) {
+  OutputRaceStrategy strategy = OutputRaceStrategy::IgnoreRaces;
+  bool matched = false;
+  match(stmt,
+    std::function<void(const ForallNode*)>([&](const ForallNode* node) {
+      if (!matched) strategy = node->output_race_strategy;
+      matched = true;
+    })
+  );
+  return strategy;
+}
+
+TEST(autoschedule, privatization) {
+  const int N = 40;
+  Tensor<double> A("prA", {N,N}, CSR);
+  Tensor<double> x("prx", {N}, Format({dense}));
+  for (int k = 0; k < N; k++) {
+    A.insert({k, (k * 3) % N}, 1.0 + k);
+    A.insert({k, (k * 7 + 1) % N}, 2.0);
+    x.insert({k}, 0.5 * k);
+  }
+  A.pack();
+  x.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> expected("prey", {N}, Format({dense}));
+  expected(j) = A(i,j) * x(i);
+  expected.evaluate();
+
+  // Threads reduce into their own copies of the result of a transposed
+  // matrix-vector product
+  taco_set_num_threads(2);
+  Tensor<double> y("pry", {N}, Format({dense}));
+  y(j) = A(i,j) * x(i);
+  IndexStmt stmt = taco::reorderLoopsTopologically(makeConcreteNotation(
+      makeReductionNotation(y.getAssignment())));
+  ASSERT_EQ(OutputRaceStrategy::Temporary,
+            getOuterOutputRaceStrategy(parallelizeOuterLoop(stmt)));
+  y.evaluate();
+  ASSERT_TENSOR_EQ(expected, y);
+  ASSERT_NE(std::string::npos,
+            y.getSource().find("pry_num_threads = omp_get_max_threads()"));
+
+  // Results whose copies exceed the budget are reduced into with atomics
+  setenv("TACO_PRIVATIZATION_BUDGET", "64", 1);
+  IndexStmt atomic = stmt.parallelize(i, ParallelUnit::CPUThread,
+                                      OutputRaceStrategy::Temporary);
+  unsetenv("TACO_PRIVATIZATION_BUDGET");
+  taco_set_num_threads(1);
+  ASSERT_EQ(OutputRaceStrategy::Atomics, getOuterOutputRaceStrategy(atomic));
+  ASSERT_EQ(stmt, parallelizeOuterLoop(stmt));
+}
+
+TEST(autoschedule, scalarReduction) {
+  const int N = 40;
+  Tensor<double> a("sra", {N}, Format({dense}));
+  Tensor<double> b("srb", {N}, Format({dense}));
+  double expectedDot = 0.0;
+  for (int k = 0; k < N; k++) {
+    a.insert({k}, 1.0 + k);
+    b.insert({k}, 0.5 * ((k * 7) % N));
+    expectedDot += (1.0 + k) * (0.5 * ((k * 7) % N));
+  }
+  a.pack();
+  b.pack();
+
+  // Threads reduce into their own copies of the result of a dot product,
+  // which are combined by the reduction clause of the loop
+  IndexVar i("i");
+  taco_set_num_threads(2);
+  Tensor<double> dot("srdot");
+  dot = a(i) * b(i);
+  IndexStmt stmt = makeConcreteNotation(
+      makeReductionNotation(dot.getAssignment()));
+  ASSERT_EQ(OutputRaceStrategy::ParallelReduction,
+            getOuterOutputRaceStrategy(parallelizeOuterLoop(stmt)));
+  dot.evaluate();
+  ASSERT_NE(std::string::npos, dot.getSource().find("reduction(+:"));
+  ASSERT_DOUBLE_EQ(expectedDot, dot.begin()->second);
+
+  // User-defined operators are reduced with the OpenMP operators they lower to
+  Func minOp("Min", MinImpl(),
+             {Identity(std::numeric_limits<double>::infinity())});
+  Tensor<double> min("srmin");
+  min = Reduction(minOp(), i, a(i) * b(i));
+  min.evaluate();
+  ASSERT_NE(std::string::npos, min.getSource().find("reduction(min:"));
+  ASSERT_DOUBLE_EQ(0.0, min.begin()->second);
+
+  // Operators that short-circuit the reduction are not parallelized
+  Func orOp("Or", OrImpl(), {Annihilator((double)1), Identity((double)0)});
+  Tensor<double> any("srany");
+  any = Reduction(orOp(), i, a(i) * b(i));
+  IndexStmt anyStmt = makeConcreteNotation(
+      makeReductionNotation(any.getAssignment()));
+  taco_set_num_threads(1);
+  std::string reason;
+  ASSERT_FALSE(Parallelize(i, ParallelUnit::CPUThread,
+                           OutputRaceStrategy::ParallelReduction)
+               .apply(anyStmt, &reason).defined());
+}
+
+TEST(algebra, simplify) {
+  TensorVar a("a", vectype), b("b", vectype), c("c", vectype), d("d", vectype);
+  TensorVar B("B", mattype), C("C", mattype);
+  IndexVar i("i"), j("j"), k("k");
+
+  // Common factors of sums are factored out
+  ASSERT_TRUE(equals(
+      Assignment(a(i), sum(j, B(i,j)*(c(j) + d(j)))),
+      simplifyAlgebraically(
+          Assignment(a(i), sum(j, B(i,j)*c(j) + B(i,j)*d(j))))));
+  ASSERT_TRUE(equals(
+      Assignment(a(i), b(i)*(c(i) - d(i)) + c(i)),
+      simplifyAlgebraically(
+          Assignment(a(i), b(i)*c(i) - d(i)*b(i) + c(i)))));
+
+  // Factors that do not depend on a reduction variable are hoisted out of it
+  ASSERT_TRUE(equals(
+      Assignment(a(i), sum(j, B(i,j)*sum(k, C(j,k)*c(k)))),
+      simplifyAlgebraically(
+          Assignment(a(i), sum(j, sum(k, B(i,j)*C(j,k)*c(k)))))));
+
+  // Zeros and Func identities and annihilators are simplified, except for
+  // floating-point products with zero, which are NaN if the other factor is
+  // NaN or infinite
+  Func orOp("Or", OrImpl(),
+            {Annihilator((double)1), Identity(Literal((double)0))});
+  ASSERT_TRUE(equals(
+      Assignment(a(i), b(i)*c(i) + d(i)*0.0),
+      simplifyAlgebraically(
+          Assignment(a(i), b(i)*orOp(c(i), Literal(0.0)) + d(i)*0.0))));
+  Type intvectype(Int32, {3});
+  TensorVar ia("ia", intvectype), ib("ib", intvectype), ic("ic", intvectype);
+  ASSERT_TRUE(equals(
+      Assignment(ia(i), ib(i)),
+      simplifyAlgebraically(Assignment(ia(i), ib(i) + ic(i)*0))));
+  ASSERT_TRUE(equals(
+      Assignment(a(i), b(i)*Literal(1.0)),
+      simplifyAlgebraically(Assignment(a(i), b(i)*orOp(c(i),
+                                                        Literal(1.0))))));
+  ASSERT_TRUE(equals(
+      Assignment(a(i), b(i)*0.0),
+      simplifyAlgebraically(Assignment(a(i), b(i)*0.0))));
+}
+
+TEST(algebra, evaluate) {
+  const int N = 10;
+  Tensor<double> B("alB", {N,N}, CSR);
+  Tensor<double> C("alC", {N,N}, CSR);
+  Tensor<double> c("alc", {N}, Format({dense}));
+  Tensor<double> d("ald", {N}, Format({dense}));
+  for (int k = 0; k < N; k++) {
+    B.insert({k, (k * 3) % N}, 1.0 + k);
+    B.insert({k, (k * 7 + 1) % N}, 2.0);
+    C.insert({k, (k + 2) % N}, 0.5 * k);
+    c.insert({k}, 1.0 * k);
+    d.insert({k}, 2.0 - k);
+  }
+  B.pack();
+  C.pack();
+  c.pack();
+  d.pack();
+
+  IndexVar i("i"), j("j"), k("k");
+  Tensor<double> y("aly", {N}, Format({dense}));
+  y(i) = B(i,j) * c(j) + B(i,j) * d(j);
+  Tensor<double> cd("alcd", {N}, Format({dense}));
+  Tensor<double> expectedY("aley", {N}, Format({dense}));
+  cd(j) = c(j) + d(j);
+  expectedY(i) = B(i,j) * cd(j);
+  ASSERT_TENSOR_EQ(expectedY, y);
+
+  Tensor<double> z("alz", {N}, Format({dense}));
+  z(i) = B(i,j) * C(j,k) * c(k);
+  Tensor<double> Cc("alCc", {N}, Format({dense}));
+  Tensor<double> expectedZ("alez", {N}, Format({dense}));
+  Cc(j) = C(j,k) * c(k);
+  expectedZ(i) = B(i,j) * Cc(j);
+  ASSERT_TENSOR_EQ(expectedZ, z);
+}
+
+TEST(autotune, scheduleFormat) {
+  TunedSchedule schedule;
+  schedule.loopOrder = {"i", "j"};
+  schedule.parallelize = true;
+  schedule.parallelSchedule = ParallelSchedule::Dynamic;
+  schedule.chunkSize = 16;
+  schedule.vectorWidth = 4;
+  ASSERT_EQ("order=i,j;parallel=dynamic,16;vector=4", util::toString(schedule));
+
+  TunedSchedule parsed;
+  ASSERT_TRUE(TunedSchedule::parse(util::toString(schedule), &parsed));
+  ASSERT_TRUE(parsed == schedule);
+  ASSERT_FALSE(TunedSchedule::parse("parallel=none", &parsed));
+  ASSERT_FALSE(TunedSchedule::parse("order=i;parallel=guided,4", &parsed));
+}
+
+TEST(autotune, database) {
+  const std::string database = util::getTmpdir() + "autotune.db";
+  setTuningDatabase(database);
+
+  Tensor<double> A("atA", {16,16}, CSR);
+  Tensor<double> x("atx", {16}, Format({dense}));
+  Tensor<double> expected("ate", {16}, Format({dense}));
+  for (int k = 0; k < 16; k++) {
+    A.insert({k, k}, 2.0);
+    A.insert({k, (k * 7) % 16}, 1.0 + k);
+    x.insert({k}, 0.5 * k);
+  }
+  A.pack();
+  x.pack();
+
+  IndexVar i("i"), j("j");
+  Tensor<double> y("aty", {16}, Format({dense}));
+  y(i) = A(i,j) * x(j);
+  TunedSchedule tuned = y.autotune(4);
+  ASSERT_FALSE(tuned.loopOrder.empty());
+  y.evaluate();
+
+  expected(i) = A(i,j) * x(j);
+  expected.evaluate();
+  ASSERT_TENSOR_EQ(expected, y);
+
+  // Reload the database from its file and compile the same expression again
+  setTuningDatabase(database);
+  std::ifstream file(database);
+  std::string line;
+  ASSERT_TRUE(bool(std::getline(file, line)));
+  ASSERT_EQ(util::toString(tuned), line.substr(line.rfind('\t') + 1));
+
+  Tensor<double> z("aty", {16}, Format({dense}));
+  z(i) = A(i,j) * x(j);
+  z.evaluate();
+  ASSERT_EQ(y.getSource(), z.getSource());
+  ASSERT_TENSOR_EQ(expected, z);
+
+  setTuningDatabase("");
+}
+
+TEST(autotune, tuningKey) {
+  IndexVar i("i"), j("j");
+  Tensor<double> A("ktA", {16,16}, CSR);
+  Tensor<double> x("ktx", {16}, Format({dense}));
+  Tensor<double> y("kty", {16}, Format({dense}));
+  Tensor<double> B("ktB", {16,16}, CSR);
+  Tensor<double> v("ktv", {16}, Format({dense}));
+  Tensor<double> w("ktw", {16}, Format({dense}));
+  y(i) = A(i,j) * x(j);
+  w(i) = B(i,j) * v(j);
+  ASSERT_EQ(getTuningKey(y.getAssignment(), {}),
+            getTuningKey(w.getAssignment(), {}));
+
+  w(i) = v(j) * B(i,j);
+  ASSERT_NE(getTuningKey(y.getAssignment(), {}),
+            getTuningKey(w.getAssignment(), {}));
+}
+
+TEST(autotune, accumulate) {
+  Tensor<double> A("acA", {16,16}, CSR);
+  Tensor<double> x("acx", {16}, Format({dense}));
+  Tensor<double> y("acy", {16}, Format({dense}));
+  Tensor<double> expected("ace", {16}, Format({dense}));
+  for (int k = 0; k < 16; k++) {
+    A.insert({k, k}, 2.0);
+    A.insert({k, (k * 5) % 16}, 1.0 + k);
+    x.insert({k}, 0.5 * k);
+    y.insert({k}, 1.0);
+    expected.insert({k}, 1.0);
+  }
+  A.pack();
+  x.pack();
+  y.pack();
+  expected.pack();
+
+  IndexVar i("i"), j("j");
+  y(i) += A(i,j) * x(j);
+  TunedSchedule tuned = y.autotune(4);
+  ASSERT_FALSE(tuned.loopOrder.empty());
+  y.evaluate();
+
+  expected(i) += A(i,j) * x(j);
+  expected.evaluate();
+  ASSERT_TENSOR_EQ(expected, y);
+}
+
 TEST(schedule, workspace_spmspm) {
   TensorBase A("A", Float(64), {3,3}, Format({dense,compressed}));
   TensorBase B = d33a("B", Format({dense,compressed}));
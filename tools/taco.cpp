@@ -194,6 +194,19 @@ static void printUsageInfo() {
   cout << endl;
   printFlag("nthreads", "Specify number of threads for parallel execution");
   cout << endl;
+  printFlag("autotune=<candidates>",
+            "Time up to <candidates> (defaults to 32) schedules of the "
+            "expression on the loaded and generated tensors and use the "
+            "fastest. The fastest schedule is recorded in the tuning database "
+            "given by the TACO_TUNING_DB environment variable. Requires every "
+            "operand to be loaded or generated.");
+  cout << endl;
+  printFlag("autoschedule",
+            "Schedule the expression with the cost-model driven "
+            "autoscheduler when no schedule is given with -s, rather than "
+            "with the default schedule. Also enabled by setting the "
+            "TACO_AUTOSCHEDULE environment variable to a value other than 0.");
+  cout << endl;
   printFlag("prefix", "Specify a prefix for generated function names");
   cout << endl;
   printFlag("help", "Print this usage information.");
@@ -229,10 +242,24 @@ static void printSchedulingHelp() {
               "index variable `f` that iterates over the product of the "
               "coordinates `i` and `j`.");
     cout << endl;
-    printFlag("s=split(i, i0, i1, factor)", "Splits (strip-mines) an index "
-              "variable `i` into two nested index variables `i0` and `i1`. The "
-              "size of the inner index variable `i1` is then held constant at "
-              "`factor`, which must be a positive integer.");
+    printFlag("s=split(i, i0, i1, factor, tail)", "Splits (strip-mines) an "
+              "index variable `i` into two nested index variables `i0` and "
+              "`i1`. The size of the inner index variable `i1` is then held "
+              "constant at `factor`, which must be a positive integer. The "
+              "optional tail strategy `tail` determines how the iterations past "
+              "the end of `i` are handled: Guard checks every iteration (the "
+              "default), Peel iterates over the last strip in a separate "
+              "loop, and RoundUp does not check the iterations, which requires "
+              "the size of `i` to be a multiple of `factor`.");
+    cout << endl;
+    printFlag("s=tile({i, j, ...}, {size0, size1, ...}, levels)", "Tiles "
+              "directly nested index variables for several levels of caches. "
+              "Every index variable `i` is strip-mined into the index "
+              "variables `i0`, `i1`, ... that iterate over the tiles of each "
+              "level, whose sizes are `size0`, `size1`, ..., and the index "
+              "variable `i<levels>` that iterates over the points of the "
+              "innermost tiles. If no sizes are given, the tiles of `levels` "
+              "levels are sized to fit in the L1, L2, ... data caches.");
     cout << endl;
     printFlag("s=precompute(expr, i, iw)", "Leverages scratchpad memories and "
               "reorders computations to increase locality.  Given a subexpression "
@@ -257,14 +284,38 @@ static void printSchedulingHelp() {
               "index variable `i` by `factor` number of iterations, where "
               "`factor` is a positive integer.");
     cout << endl;
+    printFlag("s=unrollReduction(i, accumulators)", "Unrolls the loop over "
+              "an index variable `i` by `accumulators` iterations and splits "
+              "its scalar reductions into that many independent partial sums, "
+              "which are added once the loop ends.");
+    cout << endl;
+    printFlag("s=prefetch(i, tensor, distance)", "Prefetches the values of "
+              "`tensor` that the loop over an index variable `i` reads, "
+              "`distance` iterations ahead. This hides the latency of indirect "
+              "accesses such as `x(j)` in the loop over the nonzeros of a "
+              "sparse matrix.");
+    cout << endl;
+    printFlag("s=mergeby(i, strategy)", "Sets the strategy that the loop over "
+              "an index variable `i` merges its operands with. Possible "
+              "strategies are: TwoFinger, Gallop, Branchless. Gallop skips over "
+              "the coordinates of long operands of intersections that are "
+              "missing from short ones with exponential searches. Branchless "
+              "computes unions without branching on which operands are "
+              "present at each coordinate.");
+    cout << endl;
     printFlag("s=parallelize(i, u, strat)", "tags an index variable `i` for "
               "parallel execution on hardware type `u`. Data races are handled by "
               "an output race strategy `strat`. Since the other transformations "
               "expect serial code, parallelize must come last in a series of "
               "transformations.  Possible parallel hardware units are: "
-              "NotParallel, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector. "
+              "NotParallel, GPUBlock, GPUWarp, GPUThread, CPUThread, CPUVector, "
+              "CPUTask. Loops over CPUTask can be nested, and split loops with "
+              "at least `chunk` iterations (see -schedule) into tasks of about "
+              "`chunk` iterations. "
               "Possible output race strategies are: "
-              "IgnoreRaces, NoRaces, Atomics, Temporary, ParallelReduction.");
+              "IgnoreRaces, NoRaces, Atomics, Temporary, ParallelReduction, "
+              "MergePath. MergePath splits the rows and nonzeros of a loop "
+              "over the rows of a compressed matrix evenly among CPU threads.");
 }
 
 static void printVersionInfo() {
@@ -308,6 +359,19 @@ static void printCommandLine(ostream& os, int argc, char* argv[]) {
   }
 }
 
+static TailStrategy parseTailStrategy(string tail) {
+  if (tail == "Guard") {
+    return TailStrategy::Guard;
+  } else if (tail == "Peel") {
+    return TailStrategy::Peel;
+  } else if (tail == "RoundUp") {
+    return TailStrategy::RoundUp;
+  }
+  taco_uerror << "Tail strategy '" << tail << "' not defined. Possible tail "
+              << "strategies are: Guard, Peel, RoundUp.";
+  return TailStrategy::Guard;
+}
+
 static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parser::Parser& parser, IndexStmt& stmt) {
   auto findVar = [&stmt](string name) {
     ProvenanceGraph graph(stmt);
@@ -353,8 +417,8 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
       stmt = stmt.fuse(findVar(i), findVar(j), fused);
 
     } else if (command == "split") {
-      taco_uassert(scheduleCommand.size() == 4)
-          << "'split' scheduling directive takes 4 parameters: split(i, i1, i2, splitFactor)";
+      taco_uassert(scheduleCommand.size() == 4 || scheduleCommand.size() == 5)
+          << "'split' scheduling directive takes 4 or 5 parameters: split(i, i1, i2, splitFactor [, tail])";
       string i, i1, i2;
       size_t splitFactor;
       i = scheduleCommand[0];
@@ -363,12 +427,17 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
       taco_uassert(sscanf(scheduleCommand[3].c_str(), "%zu", &splitFactor) == 1)
           << "failed to parse fourth parameter to `split` directive as a size_t";
 
+      TailStrategy tail_strategy = TailStrategy::Guard;
+      if (scheduleCommand.size() == 5) {
+        tail_strategy = parseTailStrategy(scheduleCommand[4]);
+      }
+
       IndexVar split1(i1);
       IndexVar split2(i2);
-      stmt = stmt.split(findVar(i), split1, split2, splitFactor);
+      stmt = stmt.split(findVar(i), split1, split2, splitFactor, tail_strategy);
     } else if (command == "divide") {
-      taco_uassert(scheduleCommand.size() == 4)
-          << "'divide' scheduling directive takes 4 parameters: divide(i, i1, i2, divFactor)";
+      taco_uassert(scheduleCommand.size() == 4 || scheduleCommand.size() == 5)
+          << "'divide' scheduling directive takes 4 or 5 parameters: divide(i, i1, i2, divFactor [, tail])";
       string i, i1, i2;
       i = scheduleCommand[0];
       i1 = scheduleCommand[1];
@@ -378,9 +447,58 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
       taco_uassert(sscanf(scheduleCommand[3].c_str(), "%zu", &divideFactor) == 1)
           << "failed to parse fourth parameter to `divide` directive as a size_t";
 
+      TailStrategy tail_strategy = TailStrategy::Guard;
+      if (scheduleCommand.size() == 5) {
+        tail_strategy = parseTailStrategy(scheduleCommand[4]);
+      }
+
       IndexVar divide1(i1);
       IndexVar divide2(i2);
-      stmt = stmt.divide(findVar(i), divide1, divide2, divideFactor);
+      stmt = stmt.divide(findVar(i), divide1, divide2, divideFactor, tail_strategy);
+    } else if (command == "tile") {
+      taco_uassert(scheduleCommand.size() == 2 || scheduleCommand.size() == 3)
+          << "'tile' scheduling directive takes 2 or 3 parameters: tile({vars}, {sizes} [, levels])";
+      vector<string> vars, sizes;
+      for (auto& var : parser::varListParser(scheduleCommand[0])) {
+        if (!var.empty()) {
+          vars.push_back(var);
+        }
+      }
+      for (auto& size : parser::varListParser(scheduleCommand[1])) {
+        if (!size.empty()) {
+          sizes.push_back(size);
+        }
+      }
+
+      size_t levels = sizes.size();
+      if (scheduleCommand.size() == 3) {
+        taco_uassert(sscanf(scheduleCommand[2].c_str(), "%zu", &levels) == 1)
+            << "failed to parse third parameter to `tile` directive as a size_t";
+      }
+      taco_uassert(levels > 0)
+          << "'tile' scheduling directive requires tile sizes or a number of levels";
+
+      vector<size_t> tileSizes;
+      for (auto& size : sizes) {
+        size_t tileSize;
+        taco_uassert(sscanf(size.c_str(), "%zu", &tileSize) == 1)
+            << "failed to parse tile size `" << size << "` as a size_t";
+        tileSizes.push_back(tileSize);
+      }
+
+      // The index variables of the tiles of level l of i are named il, and
+      // the index variable of the points of the innermost tiles is named
+      // i<levels>
+      vector<IndexVar> tiled;
+      vector<vector<IndexVar>> tiledVars;
+      for (auto& var : vars) {
+        tiled.push_back(findVar(var));
+        tiledVars.push_back({});
+        for (size_t level = 0; level <= levels; level++) {
+          tiledVars.back().push_back(IndexVar(var + to_string(level)));
+        }
+      }
+      stmt = stmt.tile(tiled, tiledVars, tileSizes);
     } else if (command == "precompute") {
       string exprStr, i, iw, name;
       vector<string> i_vars, iw_vars;
@@ -532,6 +650,53 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
 
       stmt = stmt.unroll(findVar(i), unrollFactor);
 
+    } else if (command == "unrollReduction") {
+      taco_uassert(scheduleCommand.size() == 2) << "'unrollReduction' scheduling directive takes 2 parameters: unrollReduction(i, accumulators)";
+      string i;
+      size_t accumulators;
+      i  = scheduleCommand[0];
+      taco_uassert(sscanf(scheduleCommand[1].c_str(), "%zu", &accumulators) == 1) << "failed to parse second parameter to `unrollReduction` directive as a size_t";
+
+      stmt = stmt.unrollReduction(findVar(i), accumulators);
+
+    } else if (command == "prefetch") {
+      taco_uassert(scheduleCommand.size() == 3) << "'prefetch' scheduling directive takes 3 parameters: prefetch(i, tensor, distance)";
+      string i, tensor;
+      size_t distance;
+      i      = scheduleCommand[0];
+      tensor = scheduleCommand[1];
+      taco_uassert(sscanf(scheduleCommand[2].c_str(), "%zu", &distance) == 1) << "failed to parse third parameter to `prefetch` directive as a size_t";
+
+      bool found = false;
+      for (auto a : getArgumentAccesses(stmt)) {
+        if (a.getTensorVar().getName() == tensor) {
+          stmt = stmt.prefetch(findVar(i), a, distance);
+          found = true;
+          break;
+        }
+      }
+      taco_uassert(found) << "Tensor '" << tensor << "' not defined in statement " << stmt;
+
+    } else if (command == "mergeby") {
+      taco_uassert(scheduleCommand.size() == 2) << "'mergeby' scheduling directive takes 2 parameters: mergeby(i, strategy)";
+      string i, strategy;
+      i        = scheduleCommand[0];
+      strategy = scheduleCommand[1];
+
+      MergeStrategy merge_strategy;
+      if (strategy == "TwoFinger") {
+        merge_strategy = MergeStrategy::TwoFinger;
+      } else if (strategy == "Gallop") {
+        merge_strategy = MergeStrategy::Gallop;
+      } else if (strategy == "Branchless") {
+        merge_strategy = MergeStrategy::Branchless;
+      } else {
+        taco_uerror << "Merge strategy not defined.";
+        goto end;
+      }
+
+      stmt = stmt.mergeby(findVar(i), merge_strategy);
+
     } else if (command == "parallelize") {
       string i, unit, strategy;
       taco_uassert(scheduleCommand.size() == 3) << "'parallelize' scheduling directive takes 3 parameters: parallelize(i, unit, strategy)";
@@ -555,6 +720,8 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
         parallel_unit = ParallelUnit::CPUThread;
       } else if (unit == "CPUVector") {
         parallel_unit = ParallelUnit::CPUVector;
+      } else if (unit == "CPUTask") {
+        parallel_unit = ParallelUnit::CPUTask;
       } else {
         taco_uerror << "Parallel hardware not defined.";
         goto end;
@@ -571,6 +738,8 @@ static bool setSchedulingCommands(vector<vector<string>> scheduleCommands, parse
         output_race_strategy = OutputRaceStrategy::Temporary;
       } else if (strategy == "ParallelReduction") {
         output_race_strategy = OutputRaceStrategy::ParallelReduction;
+      } else if (strategy == "MergePath") {
+        output_race_strategy = OutputRaceStrategy::MergePath;
       } else {
         taco_uerror << "Race strategy not defined.";
         goto end;
@@ -662,10 +831,14 @@ int main(int argc, char* argv[]) {
   bool cuda                = false;
 
   bool setSchedule         = false;
+  bool autotune            = false;
+  bool autoschedule        =
+      taco::util::getFromEnv("TACO_AUTOSCHEDULE", "0") != "0";
 
   ParallelSchedule sched = ParallelSchedule::Static;
   int chunkSize = 0;
   int nthreads = 0;
+  int autotuneCandidates = 32;
   string prefix = "";
 
   taco::util::TimeResults compileTime;
@@ -997,6 +1170,20 @@ int main(int argc, char* argv[]) {
         return reportError("Incorrect -nthreads usage", 3);
       }
     }
+    else if ("-autotune" == argName) {
+      autotune = true;
+      if (argValue != "") {
+        try {
+          autotuneCandidates = stoi(argValue);
+        }
+        catch (...) {
+          return reportError("Incorrect -autotune usage", 3);
+        }
+      }
+    }
+    else if ("-autoschedule" == argName) {
+      autoschedule = true;
+    }
     else if ("-print-kernels" == argName) {
       printKernels = true;
     }
@@ -1128,9 +1315,30 @@ int main(int argc, char* argv[]) {
   ir::Stmt compute;
   ir::Stmt evaluate;
 
-  taco_set_parallel_schedule(sched, chunkSize);
   taco_set_num_threads(nthreads);
 
+  TunedSchedule tuned;
+  if (autotune) {
+    if (setSchedule || cuda) {
+      return reportError("-autotune cannot be used with -s or -cuda", 3);
+    }
+    if (!benchmark) {
+      return reportError("-autotune requires every operand to be loaded or "
+                         "generated", 3);
+    }
+    if (autotuneCandidates <= 0) {
+      return reportError("Incorrect -autotune usage", 3);
+    }
+    tuned = tensor.autotune(autotuneCandidates);
+    if (tuned.parallelize) {
+      sched = tuned.parallelSchedule;
+      chunkSize = tuned.chunkSize;
+    }
+    cout << "Tuned schedule: " << tuned << endl;
+  }
+
+  taco_set_parallel_schedule(sched, chunkSize);
+
   IndexStmt stmt =
       makeConcreteNotation(makeReductionNotation(tensor.getAssignment()));
   stmt = reorderLoopsTopologically(stmt);
@@ -1138,6 +1346,12 @@ int main(int argc, char* argv[]) {
   if (setSchedule) {
     cuda |= setSchedulingCommands(scheduleCommands, parser, stmt);
   }
+  else if (autotune && tuned.apply(stmt).defined()) {
+    stmt = tuned.apply(stmt);
+  }
+  else if (autoschedule) {
+    stmt = taco::autoschedule(stmt);
+  }
   else {
     stmt = insertTemporaries(stmt);
     stmt = parallelizeOuterLoop(stmt);